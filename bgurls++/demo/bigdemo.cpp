@@ -99,7 +99,9 @@ int main(int argc, char *argv[])
     int numprocs;
     int myid;
 
-    MPI_Init(&argc, &argv);
+    // BigArray blocks are read ahead by a background thread when MPI can be called from more than one thread
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
 
 //     Find out the number of processes
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
@@ -60,6 +60,10 @@
 
 #include <mpi.h>
 
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
 #include <boost/algorithm/string/erase.hpp>
 
 namespace gurls
@@ -77,6 +81,11 @@ public:
     /**
      * Implements a BGURLS process and stores results of each BGURLS task in opt.
      *
+     * Serial (gurls++) tasks run on process 0 only, and their results are broadcast to the other processes
+     * from memory, or through a scratch file in shared_dir if larger than memlimit.
+     * The elapsed time and the BigArray I/O volume of each task on each process are stored in the time list of opt
+     * as processid_ranks and processid_io (processes x tasks matrices), to expose load imbalance.
+     *
      * \param X input data matrix
      * \param y labels matrix
      * \param opt initial BGURLS options
@@ -89,23 +98,23 @@ public:
 
     template<typename T, class TaskT>
     void runSerialTask(gMat2D<T>& X, gMat2D<T>& y, GurlsOptionsList& opt,
-                        int myid, const std::string& taskName, const std::string& reg2, const std::string& dataExchangeFile)
+                        int myid, const std::string& taskName, const std::string& reg2, const std::string& dataExchangeFile,
+                        unsigned long memLimit)
     {
+        GurlsOptionsList* ret;
+
         if(myid == 0)
         {
             TaskT* task = TaskT::factory(reg2);
 
-            GurlsOptionsList* ret = task->execute(X, y, opt);
-            ret->save(dataExchangeFile);
+            ret = task->execute(X, y, opt);
 
             delete task;
-            delete ret;
         }
+        else
+            ret = new GurlsOptionsList(taskName);
 
-        MPI_Barrier(MPI_COMM_WORLD);
-
-        GurlsOptionsList* ret = new GurlsOptionsList(taskName);
-        ret->load(dataExchangeFile);
+        broadcastObject(*ret, myid, dataExchangeFile, memLimit);
 
         opt.removeOpt(taskName);
         opt.addOpt(taskName, ret);
@@ -126,16 +135,115 @@ public:
         opt.addOpt(taskName, ret);
     }
 
+protected:
+
+    /**
+     * Copies an object from process 0 to all the other processes. The serialized object is broadcast
+     * from memory if it fits in memLimit bytes, otherwise it is spilled to scratchFile, a file accessible
+     * by all the processes, which is removed as soon as they have read it.
+     * Must be called by all the processes at the same time
+     */
+    template<class Object>
+    void broadcastObject(Object& obj, int myid, const std::string& scratchFile, unsigned long memLimit)
+    {
+        std::string buffer;
+        unsigned long size = 0;
+
+        if(myid == 0)
+        {
+            std::ostringstream stream(std::ios_base::out | std::ios_base::binary);
+            saveObject(stream, obj);
+
+            buffer = stream.str();
+            size = buffer.size();
+        }
+
+        MPI_Bcast(&size, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+
+        if(size <= memLimit)
+        {
+            buffer.resize(size);
+
+            // MPI counts are int
+            const unsigned long maxCount = 1ul << 30;
+            for(unsigned long offset = 0; offset < size; offset += maxCount)
+                MPI_Bcast(&buffer[offset], static_cast<int>(std::min(maxCount, size-offset)), MPI_CHAR, 0, MPI_COMM_WORLD);
+
+            if(myid != 0)
+            {
+                std::istringstream stream(buffer, std::ios_base::in | std::ios_base::binary);
+                loadObject(stream, obj);
+            }
+        }
+        else
+        {
+            if(myid == 0)
+            {
+                std::ofstream stream(scratchFile.c_str(), std::ios_base::binary);
+                stream.write(buffer.data(), size);
+
+                if(!stream)
+                    throw gException("Could not write file " + scratchFile);
+
+                buffer.clear();
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            if(myid != 0)
+            {
+                std::ifstream stream(scratchFile.c_str(), std::ios_base::binary);
+
+                if(!stream.is_open())
+                    throw gException("Could not open file " + scratchFile);
+
+                loadObject(stream, obj);
+            }
+
+            MPI_Barrier(MPI_COMM_WORLD);
+
+            if(myid == 0)
+                std::remove(scratchFile.c_str());
+        }
+    }
+
+    static void saveObject(std::ostream& stream, const GurlsOptionsList& obj)
+    {
+        obj.save(stream);
+    }
+
+    static void loadObject(std::istream& stream, GurlsOptionsList& obj)
+    {
+        obj.load(stream);
+    }
+
+    template<typename T>
+    static void saveObject(std::ostream& stream, const gMat2D<T>& obj)
+    {
+        oarchive outar(stream);
+        outar << obj;
+    }
+
+    template<typename T>
+    static void loadObject(std::istream& stream, gMat2D<T>& obj)
+    {
+        iarchive inar(stream);
+        inar >> obj;
+    }
+
 };
 
 
 template <typename T>
 void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& opt, std::string processid, bool hasGurlsProcesses)
 {
+    int numprocs;
     int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
     double begin, end;
+    unsigned long ioBegin;
 
 //    try{
 
@@ -154,6 +262,12 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
         const std::string sharedDir = opt.getOptAsString("shared_dir");
         const std::string dataExchangeFile = sharedDir + "ret";
 
+        // results of the serial tasks smaller than memlimit are broadcast from memory, larger ones through dataExchangeFile
+        const unsigned long memLimit = opt.hasOpt("memlimit")? static_cast<unsigned long>(opt.getOptAsNumber("memlimit")): 0;
+
+        // HDF5 layout and transfer settings for the BigArrays created by the tasks
+        BigArrayIO::configure(opt);
+
         GurlsOptionsList* loadOpt = new GurlsOptionsList("load");
 
         MPI_Barrier(MPI_COMM_WORLD);
@@ -185,6 +299,13 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
         T *process_time = process_time_vector->getData();
         set(process_time, (T)0.0, seq->size());
 
+        // elapsed time and BigArray I/O volume of each task on each process, gathered on process 0
+        gMat2D<T>* rank_time_matrix = new gMat2D<T>(numprocs, seq->size());
+        gMat2D<T>* rank_io_matrix = new gMat2D<T>(numprocs, seq->size());
+        set(rank_time_matrix->getData(), (T)0.0, rank_time_matrix->getSize());
+        set(rank_io_matrix->getData(), (T)0.0, rank_io_matrix->getSize());
+        double* rankStats = new double[2*numprocs];
+
 
         std::string reg1;
         std::string reg2;
@@ -195,7 +316,8 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
         gMat2D<T> X_mat;
         gMat2D<T> y_mat;
 
-        if(hasGurlsProcesses)
+        // serial tasks only run on process 0
+        if(hasGurlsProcesses && myid == 0)
         {
             X.getMatrix(0, 0, X.rows(), X.cols(), X_mat);
             y.getMatrix(0, 0, y.rows(), y.cols(), y_mat);
@@ -227,54 +349,48 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
             case GURLS::computeNsave:
 
                 begin = MPI_Wtime();
+                ioBegin = BigArrayIO::bytesRead + BigArrayIO::bytesWritten;
 
                 if (!reg1.compare("optimizer"))
                 {
-                    runSerialTask<T, Optimizer<T> >(X_mat, y_mat, opt, myid, "optimizer", reg2, dataExchangeFile);
+                    runSerialTask<T, Optimizer<T> >(X_mat, y_mat, opt, myid, "optimizer", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("paramsel"))
                 {
-                    runSerialTask<T, ParamSelection<T> >(X_mat, y_mat, opt, myid, "paramsel", reg2, dataExchangeFile);
+                    runSerialTask<T, ParamSelection<T> >(X_mat, y_mat, opt, myid, "paramsel", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("pred"))
                 {
                     unsigned char isMatrixOption; // old MPI standards doesn't support bool data type
 
+                    GurlsOption* ret = NULL;
+
                     if(myid == 0)
                     {
                         Prediction<T> *taskPrediction = Prediction<T>::factory(reg2);
 
-                        GurlsOption* ret = taskPrediction->execute(X_mat, y_mat, opt);
+                        ret = taskPrediction->execute(X_mat, y_mat, opt);
 
                         isMatrixOption = ret->isA(MatrixOption)? 1 : 0;
 
-                        if(isMatrixOption)
-                            OptMatrix<gMat2D<T> >::dynacast(ret)->getValue().save(dataExchangeFile);
-                        else
-                            GurlsOptionsList::dynacast(ret)->save(dataExchangeFile);
-
                         delete taskPrediction;
-                        delete ret;
                     }
 
                     MPI_Bcast(&isMatrixOption, 1, MPI_UNSIGNED_CHAR, 0, MPI_COMM_WORLD);
 
-                    MPI_Barrier(MPI_COMM_WORLD);
-
-                    GurlsOption* ret;
-
                     if(isMatrixOption)
                     {
-                        gMat2D<T>* mat = new gMat2D<T>();
-                        mat->load(dataExchangeFile);
+                        if(myid != 0)
+                            ret = new OptMatrix<gMat2D<T> >();
 
-                        ret = new OptMatrix<gMat2D<T> >(*mat);
+                        broadcastObject(OptMatrix<gMat2D<T> >::dynacast(ret)->getValue(), myid, dataExchangeFile, memLimit);
                     }
                     else
                     {
-                        GurlsOptionsList* tmp = new GurlsOptionsList("pred");
-                        tmp->load(dataExchangeFile);
-                        ret = tmp;
+                        if(myid != 0)
+                            ret = new GurlsOptionsList("pred");
+
+                        broadcastObject(*GurlsOptionsList::dynacast(ret), myid, dataExchangeFile, memLimit);
                     }
 
                     opt.removeOpt("pred");
@@ -282,27 +398,27 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
                 }
                 else if (!reg1.compare("perf"))
                 {
-                    runSerialTask<T, Performance<T> >(X_mat, y_mat, opt, myid, "perf", reg2, dataExchangeFile);
+                    runSerialTask<T, Performance<T> >(X_mat, y_mat, opt, myid, "perf", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("kernel"))
                 {
-                    runSerialTask<T, Kernel<T> >(X_mat, y_mat, opt, myid, "kernel", reg2, dataExchangeFile);
+                    runSerialTask<T, Kernel<T> >(X_mat, y_mat, opt, myid, "kernel", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("norm"))
                 {
-                    runSerialTask<T, Norm<T> >(X_mat, y_mat, opt, myid, "norm", reg2, dataExchangeFile);
+                    runSerialTask<T, Norm<T> >(X_mat, y_mat, opt, myid, "norm", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("split"))
                 {
-                    runSerialTask<T, Split<T> >(X_mat, y_mat, opt, myid, "split", reg2, dataExchangeFile);
+                    runSerialTask<T, Split<T> >(X_mat, y_mat, opt, myid, "split", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("predkernel"))
                 {
-                    runSerialTask<T, PredKernel<T> >(X_mat, y_mat, opt, myid, "predkernel", reg2, dataExchangeFile);
+                    runSerialTask<T, PredKernel<T> >(X_mat, y_mat, opt, myid, "predkernel", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("conf"))
                 {
-                    runSerialTask<T, Confidence<T> >(X_mat, y_mat, opt, myid, "conf", reg2, dataExchangeFile);
+                    runSerialTask<T, Confidence<T> >(X_mat, y_mat, opt, myid, "conf", reg2, dataExchangeFile, memLimit);
                 }
                 else if (!reg1.compare("bigoptimizer"))
                 {
@@ -331,11 +447,32 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
 
                 end = MPI_Wtime();
 
+                {
+                    double stats[2] = {end-begin, static_cast<double>(BigArrayIO::bytesRead + BigArrayIO::bytesWritten - ioBegin)};
+                    MPI_Gather(stats, 2, MPI_DOUBLE, rankStats, 2, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+                }
+
                 if(myid == 0)
                 {
                     process_time[i] = (T)(end-begin);
 
-                    std::cout << " done." << std::endl;
+                    double minTime = rankStats[0], maxTime = rankStats[0], totalIO = 0;
+                    for(int p = 0; p < numprocs; ++p)
+                    {
+                        (*rank_time_matrix)(p, i) = (T)rankStats[2*p];
+                        (*rank_io_matrix)(p, i) = (T)rankStats[2*p+1];
+
+                        minTime = std::min(minTime, rankStats[2*p]);
+                        maxTime = std::max(maxTime, rankStats[2*p]);
+                        totalIO += rankStats[2*p+1];
+                    }
+
+                    std::cout << " done";
+                    if(numprocs > 1)
+                        std::cout << " (process time " << minTime << "-" << maxTime << " s";
+                    else
+                        std::cout << " (" << maxTime << " s";
+                    std::cout << ", I/O " << totalIO/(1 << 20) << " MB)." << std::endl;
                 }
 
                 break;
@@ -373,6 +510,8 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
         if(myid == 0)
         {
             timelist->addOpt(processid, new OptMatrix<gMat2D<T> >(*process_time_vector));
+            timelist->addOpt(processid + "_ranks", new OptMatrix<gMat2D<T> >(*rank_time_matrix));
+            timelist->addOpt(processid + "_io", new OptMatrix<gMat2D<T> >(*rank_io_matrix));
 
             bool save = false;
 
@@ -408,6 +547,15 @@ void BGURLS::run(const BigArray<T>& X, const BigArray<T>& y, GurlsOptionsList& o
             }
         }
 
+        else
+        {
+            delete process_time_vector;
+            delete rank_time_matrix;
+            delete rank_io_matrix;
+        }
+
+        delete[] rankStats;
+
         MPI_Barrier(MPI_COMM_WORLD);
         delete loadOpt;
 
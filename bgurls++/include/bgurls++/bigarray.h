@@ -46,7 +46,10 @@
 #include <hdf5.h>
 
 #include <gurls++/gmat2d.h>
+#include <list>
+#include <map>
 #include <string>
+#include <vector>
 
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/split_member.hpp>
@@ -76,6 +79,99 @@ template<>
 GURLS_EXPORT hid_t getHdfType<unsigned int>();
 
 
+class GurlsOptionsList;
+
+/**
+  * \brief BigArrayIO collects the HDF5 layout and transfer settings used by BigArray.
+  *
+  * Settings affect the datasets created (layout, compression) or opened (chunk cache) after they are changed.
+  */
+class GURLS_EXPORT BigArrayIO
+{
+public:
+    /**
+      * If true datasets are stored in chunks of contiguous rows instead of a single contiguous
+      * (column major) block, so that reading or writing a block of rows touches contiguous file regions
+      */
+    static bool chunked;
+
+    /**
+      * Number of rows in a chunk. If 0 chunks are aligned to the block of rows owned by each process
+      */
+    static unsigned long chunkRows;
+
+    /**
+      * Datasets smaller than this amount of bytes are always stored contiguously
+      */
+    static unsigned long minChunkedBytes;
+
+    /**
+      * If true the *Collective methods of BigArray use collective MPI-IO transfers (requires USE_MPIIO)
+      */
+    static bool collective;
+
+    /**
+      * Deflate level (0-9) applied to the chunked datasets filled by BigArray::readCSV; 0 disables compression.
+      * Parallel HDF5 can only write filtered datasets collectively, so it requires \c collective.
+      */
+    static int compression;
+
+    /**
+      * Size in bytes of the raw data chunk cache of each dataset; 0 keeps the HDF5 default
+      */
+    static unsigned long cacheBytes;
+
+    /**
+      * File alignment in bytes of objects larger than alignment/2 (e.g. the stripe size of a parallel filesystem); 0 disables it
+      */
+    static unsigned long alignment;
+
+    /**
+      * Size in bytes of the write-back block cache of each BigArray, serving element, row and column accesses; 0 (default) disables it.
+      * The cache is private to each process: only the elements written by this process are written back, and cached
+      * blocks do not see the writes of other processes until flush()
+      */
+    static unsigned long blockCacheBytes;
+
+    /**
+      * Number of rows and columns of the square blocks held by the block cache
+      */
+    static unsigned long blockCacheSide;
+
+    /**
+      * Bytes read from the datasets by the BigArrays of this process since the program started. Never reset:
+      * the volume of a phase is the difference of two readings
+      */
+    static unsigned long bytesRead;
+
+    /**
+      * Bytes written to the datasets by the BigArrays of this process since the program started
+      */
+    static unsigned long bytesWritten;
+
+    /**
+      * Reads the settings from the options hdf5_layout, hdf5_chunkrows, hdf5_collective, hdf5_compression,
+      * hdf5_cache, hdf5_alignment, block_cache, block_cache_side and memlimit of opt, if present.
+      * A cache size of 0 is replaced by memlimit/4. Throws if compression is enabled without collective transfers
+      */
+    static void configure(const GurlsOptionsList& opt);
+};
+
+
+/**
+  * \brief BigArrayCacheStats counts the accesses to the block cache of a BigArray
+  */
+struct BigArrayCacheStats
+{
+    BigArrayCacheStats(): hits(0), misses(0), writeBacks(0), bypasses(0) {}
+
+    unsigned long hits;         ///< block lookups served by the cache
+    unsigned long misses;       ///< blocks read from the file
+    unsigned long writeBacks;   ///< dirty blocks written to the file
+    unsigned long bypasses;     ///< row or column accesses larger than the cache, served directly by the file
+};
+
+
 template<typename T>
 class BigArray: protected gMat2D<T>
 {
@@ -136,6 +232,11 @@ public:
 
     void getMatrix(unsigned long startingRow, unsigned long startingCol, gMat2D<T>&result) const;
 
+    /**
+      * Reads a numRows x numCols block into the column major buffer \a result, which must be large enough
+      */
+    void getMatrix(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result) const;
+
 
     // Setter
     void setValue(unsigned long row, unsigned long col, T value);
@@ -148,6 +249,30 @@ public:
 
     void setRow(unsigned long row, const gVec<T>& value);
 
+    /**
+      * Collective version of getMatrix: it must be called by all the processes at the same time,
+      * each one with its own (possibly empty) block
+      */
+    void getMatrixCollective(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, gMat2D<T>&result) const;
+
+    /**
+      * Collective version of getMatrix reading into a column major buffer: it must be called by all the processes
+      * at the same time, each one with its own (possibly empty) block
+      */
+    void getMatrixCollective(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result) const;
+
+    /**
+      * Collective version of setMatrix: it must be called by all the processes at the same time,
+      * each one with its own (possibly empty) block
+      */
+    void setMatrixCollective(unsigned long startingRow, unsigned long startingCol, const gMat2D<T>&value);
+
+    /**
+      * Collective version of setMatrix: it must be called by all the processes at the same time,
+      * each one with its own (possibly empty) block
+      */
+    void setMatrixCollective(unsigned long startingRow, unsigned long startingCol, const T* M, const unsigned long M_rows, const unsigned long M_cols);
+
     /**
       * Serializes the vector to a generic archive
       */
@@ -187,6 +312,19 @@ public:
         return isBigArray(&matrix);
     }
 
+    /**
+      * Statistics of the block cache since the array was created or the statistics were reset
+      */
+    const BigArrayCacheStats& cacheStatistics() const
+    {
+        return cacheStats;
+    }
+
+    void resetCacheStatistics()
+    {
+        cacheStats = BigArrayCacheStats();
+    }
+
 protected:
 
     static boost::signal0<void> &releaseSignal()
@@ -197,14 +335,76 @@ protected:
 
     void loadNC(const std::string &fileName);
 
-    void init(std::string& fileName, unsigned long r, unsigned long c);
+    void init(std::string& fileName, unsigned long r, unsigned long c, bool compressed = false);
 
-    void getMatrix(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result) const;
+    hid_t createFileAccessList(const std::string& errorString) const;
+
+    hid_t createDatasetAccessList(hsize_t chunkBytes, const std::string& errorString) const;
+
+    void createTransferLists(const std::string& errorString);
+
+    void read(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result, hid_t xfer_id) const;
+
+    void write(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, const T* M, hid_t xfer_id);
+
+    /**
+      * Block of the cache, a numRows x numCols column major copy of the array starting at (row, col)
+      */
+    struct CacheBlock
+    {
+        T* data;
+        unsigned long row;
+        unsigned long col;
+        unsigned long numRows;
+        unsigned long numCols;
+        std::vector<bool> dirty;    ///< elements written since the block was read, empty if none
+        unsigned long numDirty;
+        std::list<unsigned long>::iterator lru;
+    };
+
+    typedef std::map<unsigned long, CacheBlock> CacheMap;
+
+    /**
+      * Returns the cached block in position (blockRow, blockCol) of the grid of blocks, reading it if needed
+      */
+    CacheBlock& cacheBlock(unsigned long blockRow, unsigned long blockCol) const;
+
+    /**
+      * Returns true if a numRows x numCols access fits in the block cache
+      */
+    bool cacheFits(unsigned long numRows, unsigned long numCols) const;
+
+    void cacheEvict(typename CacheMap::iterator it) const;
+
+    /**
+      * Writes the elements of \a block set since it was read, in runs of contiguous elements of each column
+      */
+    void cacheWriteBlock(CacheBlock& block) const;
+
+    /**
+      * Writes the dirty blocks to the file
+      */
+    void cacheWriteBack() const;
+
+    /**
+      * Writes the dirty blocks to the file and empties the cache
+      */
+    void cacheClear() const;
+
+    /**
+      * Copies a block written to the file into the overlapping cached blocks
+      */
+    void cachePatch(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, const T* M) const;
+
+    mutable CacheMap cacheBlocks;
+    mutable std::list<unsigned long> cacheLRU;  ///< keys of the cached blocks, most recently used first
+    mutable BigArrayCacheStats cacheStats;
 
 
     hid_t file_id;
     hid_t dset_id;
     hid_t plist_id;
+    hid_t coll_plist_id;
 
     std::string dataFileName;
 
@@ -15,6 +15,8 @@
 
 #include <boost/serialization/base_object.hpp>
 
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -22,8 +24,6 @@
 
 #include <gurls++/exceptions.h>
 
-#include <boost/lexical_cast.hpp>
-#include <boost/tokenizer.hpp>
 #include <boost/bind.hpp>
 
 #ifdef  USE_BINARY_ARCHIVES
@@ -65,7 +65,7 @@ std::ostream& operator<<(std::ostream& os, const BigArray<T>& m)
 }
 
 template <typename T>
-BigArray<T>::BigArray(): gMat2D<T>(), file_id(-1), dset_id(-1), plist_id(-1), dataFileName("")
+BigArray<T>::BigArray(): gMat2D<T>(), file_id(-1), dset_id(-1), plist_id(-1), coll_plist_id(-1), dataFileName("")
 {
 }
 
@@ -122,6 +122,7 @@ BigArray<T>::BigArray(std::wstring fileName, const gMat2D<T>& mat)
 template <typename T>
 BigArray<T>::BigArray(const BigArray<T>& other)
 {
+    other.cacheWriteBack();
     loadNC(other.dataFileName);
 }
 
@@ -147,6 +148,9 @@ BigArray<T>::~BigArray()
 template <typename T>
 void BigArray<T>::flush()
 {
+    // blocks are dropped too, so that data written by other processes is read again
+    cacheClear();
+
     herr_t status = H5Fflush(file_id, H5F_SCOPE_GLOBAL);
     CHECK_HDF5_ERR(status, "Error flushing data to file")
 }
@@ -154,6 +158,8 @@ void BigArray<T>::flush()
 template <typename T>
 void BigArray<T>::close()
 {
+    cacheClear();
+
     herr_t status;
 
     if(dset_id >= 0)
@@ -170,6 +176,13 @@ void BigArray<T>::close()
         plist_id = -1;
     }
 
+    if(coll_plist_id >= 0)
+    {
+        status = H5Pclose(coll_plist_id);
+        CHECK_HDF5_ERR(status, "Error closing BigArray plist")
+        coll_plist_id = -1;
+    }
+
     if(file_id >= 0)
     {
         status = H5Fclose(file_id);
@@ -210,7 +223,18 @@ gVec<T> BigArray<T>::operator[](unsigned long i) const
 
     gVec<T> ret(this->numcols);
 
-    getMatrix(i, 0, 1, this->numcols, ret.getData());
+    if(cacheFits(1, this->numcols))
+    {
+        const unsigned long side = BigArrayIO::blockCacheSide;
+
+        for(unsigned long blockCol = 0; blockCol*side < this->numcols; ++blockCol)
+        {
+            const CacheBlock& block = cacheBlock(i/side, blockCol);
+            copy(ret.getData()+block.col, block.data+(i-block.row), block.numCols, 1, block.numRows);
+        }
+    }
+    else
+        getMatrix(i, 0, 1, this->numcols, ret.getData());
 
     return ret;
 }
@@ -229,7 +253,18 @@ gVec<T> BigArray<T>::operator() (unsigned long i) const
 
     gVec<T> ret(this->numrows);
 
-    getMatrix(0, i, this->numrows, 1, ret.getData());
+    if(cacheFits(this->numrows, 1))
+    {
+        const unsigned long side = BigArrayIO::blockCacheSide;
+
+        for(unsigned long blockRow = 0; blockRow*side < this->numrows; ++blockRow)
+        {
+            const CacheBlock& block = cacheBlock(blockRow, i/side);
+            copy(ret.getData()+block.row, block.data+(i-block.col)*block.numRows, block.numRows);
+        }
+    }
+    else
+        getMatrix(0, i, this->numrows, 1, ret.getData());
 
     return ret;
 }
@@ -246,6 +281,14 @@ T BigArray<T>::operator() (unsigned long row, unsigned long col) const
     if(row >= this->numrows || col >= this->numcols)
         throw gException(Exception_Index_Out_of_Bound);
 
+    if(BigArrayIO::blockCacheBytes > 0)
+    {
+        const unsigned long side = BigArrayIO::blockCacheSide;
+        const CacheBlock& block = cacheBlock(row/side, col/side);
+
+        return block.data[(row-block.row) + (col-block.col)*block.numRows];
+    }
+
     T ret;
 
     std::string errorString("Error reading BigArray value");
@@ -266,6 +309,8 @@ T BigArray<T>::operator() (unsigned long row, unsigned long col) const
     status = H5Dread(dset_id, getHdfType<T>(), memspace, filespace, plist_id, &ret);
     CHECK_HDF5_ERR(status, errorString)
 
+    BigArrayIO::bytesRead += sizeof(T);
+
     status = H5Sclose(memspace);
     CHECK_HDF5_ERR(status, errorString)
 
@@ -309,10 +354,59 @@ void BigArray<T>::getMatrix(unsigned long startingRow, unsigned long startingCol
 
 template <typename T>
 void BigArray<T>::getMatrix(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result) const
+{
+    cacheWriteBack();
+
+    read(startingRow, startingCol, numRows, numCols, result, plist_id);
+}
+
+template <typename T>
+void BigArray<T>::getMatrixCollective(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, gMat2D<T>&result) const
+{
+    if(numRows*numCols > 0)
+    {
+        if(startingRow >= this->numrows || startingCol >= this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+
+        if(startingRow+numRows > this->numrows || startingCol+numCols > this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+    }
+
+    result.resize(numRows, numCols);
+
+    cacheWriteBack();
+
+    read(startingRow, startingCol, numRows, numCols, result.getData(), coll_plist_id);
+}
+
+template <typename T>
+void BigArray<T>::getMatrixCollective(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result) const
+{
+    if(numRows*numCols > 0)
+    {
+        if(startingRow >= this->numrows || startingCol >= this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+
+        if(startingRow+numRows > this->numrows || startingCol+numCols > this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+    }
+
+    cacheWriteBack();
+
+    read(startingRow, startingCol, numRows, numCols, result, coll_plist_id);
+}
+
+template <typename T>
+void BigArray<T>::read(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, T* result, hid_t xfer_id) const
 {
     std::string errorString("Error reading matrix data");
 
+    const bool empty = (numRows*numCols == 0);
+
     hsize_t dims[2] = {numCols, numRows};
+    if(empty)
+        dims[0] = dims[1] = 1;
+
     hid_t memspace = H5Screate_simple(2, dims, NULL);
     CHECK_HDF5_ERR(memspace, errorString)
 
@@ -328,12 +422,23 @@ void BigArray<T>::getMatrix(unsigned long startingRow, unsigned long startingCol
 
     herr_t status;
 
-    status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, stride, count, block);
+    if(empty)
+    {
+        // processes with nothing to read still take part in collective transfers
+        status = H5Sselect_none(memspace);
+        CHECK_HDF5_ERR(status, errorString)
+
+        status = H5Sselect_none(filespace);
+    }
+    else
+        status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, stride, count, block);
     CHECK_HDF5_ERR(status, errorString)
 
-    status = H5Dread(dset_id, getHdfType<T>(), memspace, filespace, plist_id, result);
+    status = H5Dread(dset_id, getHdfType<T>(), memspace, filespace, xfer_id, result);
     CHECK_HDF5_ERR(status, errorString)
 
+    BigArrayIO::bytesRead += numRows*numCols*sizeof(T);
+
     status = H5Sclose(memspace);
     CHECK_HDF5_ERR(status, errorString)
 
@@ -348,6 +453,25 @@ void BigArray<T>::setValue(unsigned long row, unsigned long col, T value)
     if(row >= this->numrows || col >= this->numcols)
         throw gException(Exception_Index_Out_of_Bound);
 
+    if(BigArrayIO::blockCacheBytes > 0)
+    {
+        const unsigned long side = BigArrayIO::blockCacheSide;
+        CacheBlock& block = cacheBlock(row/side, col/side);
+
+        const unsigned long index = (row-block.row) + (col-block.col)*block.numRows;
+        block.data[index] = value;
+
+        if(block.dirty.empty())
+            block.dirty.assign(block.numRows*block.numCols, false);
+
+        if(!block.dirty[index])
+        {
+            block.dirty[index] = true;
+            ++block.numDirty;
+        }
+        return;
+    }
+
     std::string errorString("Error writing BigArray value");
 
     hsize_t dims[2] = {1, 1};
@@ -366,6 +490,8 @@ void BigArray<T>::setValue(unsigned long row, unsigned long col, T value)
     status = H5Dwrite(dset_id, getHdfType<T>(), memspace, filespace, plist_id, &value);
     CHECK_HDF5_ERR(status, errorString)
 
+    BigArrayIO::bytesWritten += sizeof(T);
+
     status = H5Sclose(memspace);
     CHECK_HDF5_ERR(status, errorString)
 
@@ -388,9 +514,46 @@ void BigArray<T>::setMatrix(unsigned long startingRow, unsigned long startingCol
     if(startingRow+M_rows > this->numrows || startingCol+M_cols > this->numcols)
         throw gException(Exception_Index_Out_of_Bound);
 
+    write(startingRow, startingCol, M_rows, M_cols, M, plist_id);
+
+    cachePatch(startingRow, startingCol, M_rows, M_cols, M);
+}
+
+template <typename T>
+void BigArray<T>::setMatrixCollective(unsigned long startingRow, unsigned long startingCol, const gMat2D<T>&value)
+{
+    setMatrixCollective(startingRow, startingCol, value.getData(), value.rows(), value.cols());
+}
+
+template <typename T>
+void BigArray<T>::setMatrixCollective(unsigned long startingRow, unsigned long startingCol, const T* M, const unsigned long M_rows, const unsigned long M_cols)
+{
+    if(M_rows*M_cols > 0)
+    {
+        if(startingRow >= this->numrows || startingCol >= this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+
+        if(startingRow+M_rows > this->numrows || startingCol+M_cols > this->numcols)
+            throw gException(Exception_Index_Out_of_Bound);
+    }
+
+    // other processes write too: the cached blocks may become stale
+    cacheClear();
+
+    write(startingRow, startingCol, M_rows, M_cols, M, coll_plist_id);
+}
+
+template <typename T>
+void BigArray<T>::write(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, const T* M, hid_t xfer_id)
+{
     std::string errorString("Error writing matrix data");
 
-    hsize_t dims[2] = {M_cols, M_rows};
+    const bool empty = (numRows*numCols == 0);
+
+    hsize_t dims[2] = {numCols, numRows};
+    if(empty)
+        dims[0] = dims[1] = 1;
+
     hid_t memspace = H5Screate_simple(2, dims, NULL);
     CHECK_HDF5_ERR(memspace, errorString)
 
@@ -405,12 +568,24 @@ void BigArray<T>::setMatrix(unsigned long startingRow, unsigned long startingCol
     CHECK_HDF5_ERR(filespace, errorString)
 
     herr_t status;
-    status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, stride, count, block);
+
+    if(empty)
+    {
+        // processes with nothing to write still take part in collective transfers
+        status = H5Sselect_none(memspace);
+        CHECK_HDF5_ERR(status, errorString)
+
+        status = H5Sselect_none(filespace);
+    }
+    else
+        status = H5Sselect_hyperslab(filespace, H5S_SELECT_SET, offset, stride, count, block);
     CHECK_HDF5_ERR(status, errorString)
 
-    status = H5Dwrite(dset_id, getHdfType<T>(), memspace, filespace, plist_id, M);
+    status = H5Dwrite(dset_id, getHdfType<T>(), memspace, filespace, xfer_id, M);
     CHECK_HDF5_ERR(status, errorString)
 
+    BigArrayIO::bytesWritten += numRows*numCols*sizeof(T);
+
     H5Sclose(memspace);
     CHECK_HDF5_ERR(status, errorString)
 
@@ -443,6 +618,157 @@ void BigArray<T>::setRow(unsigned long row, const gVec<T>& value)
 }
 
 
+template <typename T>
+typename BigArray<T>::CacheBlock& BigArray<T>::cacheBlock(unsigned long blockRow, unsigned long blockCol) const
+{
+    const unsigned long side = BigArrayIO::blockCacheSide;
+    const unsigned long key = blockRow*((this->numcols + side - 1)/side) + blockCol;
+
+    typename CacheMap::iterator it = cacheBlocks.find(key);
+
+    if(it != cacheBlocks.end())
+    {
+        ++cacheStats.hits;
+        cacheLRU.splice(cacheLRU.begin(), cacheLRU, it->second.lru);
+
+        return it->second;
+    }
+
+    ++cacheStats.misses;
+
+    const unsigned long capacity = std::max(BigArrayIO::blockCacheBytes/(side*side*sizeof(T)), 1ul);
+    while(cacheBlocks.size() >= capacity)
+        cacheEvict(cacheBlocks.find(cacheLRU.back()));
+
+    CacheBlock block;
+    block.row = blockRow*side;
+    block.col = blockCol*side;
+    block.numRows = std::min(side, this->numrows - block.row);
+    block.numCols = std::min(side, this->numcols - block.col);
+    block.numDirty = 0;
+    block.data = new T[block.numRows*block.numCols];
+
+    try
+    {
+        read(block.row, block.col, block.numRows, block.numCols, block.data, plist_id);
+    }
+    catch(gException&)
+    {
+        delete[] block.data;
+        throw;
+    }
+
+    cacheLRU.push_front(key);
+    block.lru = cacheLRU.begin();
+
+    return cacheBlocks.insert(std::make_pair(key, block)).first->second;
+}
+
+template <typename T>
+bool BigArray<T>::cacheFits(unsigned long numRows, unsigned long numCols) const
+{
+    if(BigArrayIO::blockCacheBytes == 0)
+        return false;
+
+    const unsigned long side = BigArrayIO::blockCacheSide;
+    const unsigned long blocks = ((numRows + side - 1)/side)*((numCols + side - 1)/side);
+
+    if(blocks*side*side*sizeof(T) <= BigArrayIO::blockCacheBytes)
+        return true;
+
+    ++cacheStats.bypasses;
+    return false;
+}
+
+template <typename T>
+void BigArray<T>::cacheEvict(typename CacheMap::iterator it) const
+{
+    CacheBlock& block = it->second;
+
+    cacheWriteBlock(block);
+
+    delete[] block.data;
+    cacheLRU.erase(block.lru);
+    cacheBlocks.erase(it);
+}
+
+template <typename T>
+void BigArray<T>::cacheWriteBack() const
+{
+    for(typename CacheMap::iterator it = cacheBlocks.begin(); it != cacheBlocks.end(); ++it)
+        cacheWriteBlock(it->second);
+}
+
+template <typename T>
+void BigArray<T>::cacheWriteBlock(CacheBlock& block) const
+{
+    if(block.numDirty == 0)
+        return;
+
+    BigArray<T>* self = const_cast<BigArray<T>*>(this);
+
+    // elements of the block not written here may have been written by other processes
+    if(block.numDirty == block.numRows*block.numCols)
+        self->write(block.row, block.col, block.numRows, block.numCols, block.data, plist_id);
+    else
+    {
+        for(unsigned long j = 0; j < block.numCols; ++j)
+        {
+            const unsigned long offset = j*block.numRows;
+
+            for(unsigned long i = 0; i < block.numRows; )
+            {
+                if(!block.dirty[offset+i])
+                {
+                    ++i;
+                    continue;
+                }
+
+                const unsigned long first = i;
+                while(i < block.numRows && block.dirty[offset+i])
+                    ++i;
+
+                self->write(block.row+first, block.col+j, i-first, 1, block.data+offset+first, plist_id);
+            }
+        }
+    }
+
+    ++cacheStats.writeBacks;
+    block.dirty.clear();
+    block.numDirty = 0;
+}
+
+template <typename T>
+void BigArray<T>::cacheClear() const
+{
+    cacheWriteBack();
+
+    for(typename CacheMap::iterator it = cacheBlocks.begin(); it != cacheBlocks.end(); ++it)
+        delete[] it->second.data;
+
+    cacheBlocks.clear();
+    cacheLRU.clear();
+}
+
+template <typename T>
+void BigArray<T>::cachePatch(unsigned long startingRow, unsigned long startingCol, unsigned long numRows, unsigned long numCols, const T* M) const
+{
+    for(typename CacheMap::iterator it = cacheBlocks.begin(); it != cacheBlocks.end(); ++it)
+    {
+        CacheBlock& block = it->second;
+
+        const unsigned long firstRow = std::max(startingRow, block.row);
+        const unsigned long lastRow = std::min(startingRow+numRows, block.row+block.numRows);
+        const unsigned long firstCol = std::max(startingCol, block.col);
+        const unsigned long lastCol = std::min(startingCol+numCols, block.col+block.numCols);
+
+        for(unsigned long j = firstCol; j < lastCol; ++j)
+            for(unsigned long i = firstRow; i < lastRow; ++i)
+                block.data[(i-block.row) + (j-block.col)*block.numRows] = M[(i-startingRow) + (j-startingCol)*numRows];
+    }
+}
+
+
 template <typename T>
 template<class Archive>
 void BigArray<T>::save(Archive & ar, const unsigned int /* file_version */) const
@@ -492,6 +818,38 @@ void BigArray<T>::load(Archive & ar, const unsigned int /* file_version */)
         loadNC(name);
 }
 
+/**
+  * Parses the numbers of a line of a CSV file, separated by any of " ;|,\t\r", appending them to \a values
+  * \return the number of values read
+  */
+template <typename T>
+unsigned long parseCSVLine(const char* line, std::vector<T>& values)
+{
+    static const char separators[] = " ;|,\t\r";
+
+    unsigned long count = 0;
+    const char* it = line;
+
+    for(;;)
+    {
+        while(*it != '\0' && std::strchr(separators, *it) != NULL)
+            ++it;
+
+        if(*it == '\0')
+            return count;
+
+        char* next;
+        const double value = std::strtod(it, &next);
+
+        if(next == it)
+            throw gurls::gException(std::string("Invalid number in CSV line: ") + line);
+
+        values.push_back(static_cast<T>(value));
+        ++count;
+        it = next;
+    }
+}
+
 template <typename T>
 void BigArray<T>::readCSV(const std::string& fileName)
 {
@@ -500,83 +858,84 @@ void BigArray<T>::readCSV(const std::string& fileName)
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
-    unsigned long rows = 0;
-    unsigned long cols = 0;
+    std::ifstream in(fileName.c_str(), std::ios::in | std::ios::binary);
+
+    if(!in.is_open())
+        throw gurls::gException("Cannot open file " + fileName);
+
+    // every process parses the lines starting in its own byte range of the file
+    in.seekg(0, std::ios::end);
+    const unsigned long fileSize = static_cast<unsigned long>(in.tellg());
+
+    const unsigned long begin = static_cast<unsigned long>((static_cast<double>(fileSize)*myid)/numprocs);
+    const unsigned long end = (myid == numprocs-1)? fileSize: static_cast<unsigned long>((static_cast<double>(fileSize)*(myid+1))/numprocs);
 
-    typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
-    boost::char_separator<char> sep(" ;|,");
     std::string line;
+    unsigned long position = begin;
 
-    if(myid == 0)
+    // resync to the first line starting at or after begin: the line across the boundary belongs to the previous process
+    if(begin > 0 && begin < fileSize)
     {
-        std::ifstream in(fileName.c_str());
+        in.seekg(begin-1);
+        std::getline(in, line);
+        position = begin + line.size();
+    }
+    else
+        in.seekg(begin);
 
-        if(!in.is_open())
-            throw gurls::gException("Cannot open file " + fileName);
+    std::vector<T> values;  // rows of the block, one after the other
+    unsigned long block_rows = 0;
+    unsigned long cols = 0;
 
-        while(std::getline(in, line))
-        {
-            if(!line.empty())
-                ++rows;
+    while(position < end && std::getline(in, line))
+    {
+        position += line.size()+1;
 
-            if(rows == 1)
-            {
-                tokenizer tokens(line, sep);
-                for (tokenizer::iterator t_it = tokens.begin(); t_it != tokens.end(); ++t_it)
-                    ++cols;
-            }
-        }
+        const unsigned long count = parseCSVLine(line.c_str(), values);
 
-        in.close();
-    }
+        if(count == 0)
+            continue;
 
-    MPI_Bcast(&rows, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
-    MPI_Bcast(&cols, 1, MPI_UNSIGNED_LONG, 0, MPI_COMM_WORLD);
+        if(block_rows == 0)
+            cols = count;
+        else if(count != cols)
+            throw gurls::gException("Inconsistent number of columns in file " + fileName);
 
-    close();
-    init(dataFileName, rows, cols);
+        ++block_rows;
+    }
+    in.close();
 
-    if(rows == 0 || cols == 0)
-        return;
+    // rows before this process' ones and total size
+    unsigned long first_row = 0;
+    MPI_Exscan(&block_rows, &first_row, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if(myid == 0)
+        first_row = 0;
 
-    unsigned long block_rows = rows/numprocs;
-    const unsigned long first_row = myid*block_rows;
-    if(myid == numprocs -1)
-       block_rows += rows%numprocs;
-    const unsigned long last_row = first_row+block_rows-1;
+    unsigned long rows;
+    MPI_Allreduce(&block_rows, &rows, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
 
+    unsigned long max_cols;
+    MPI_Allreduce(&cols, &max_cols, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
 
-    std::ifstream in(fileName.c_str());
+    if(block_rows > 0 && cols != max_cols)
+        throw gurls::gException("Inconsistent number of columns in file " + fileName);
 
-    if(!in.is_open())
-        throw gurls::gException("Cannot open file " + fileName);
+    cols = max_cols;
 
-    T* block_transposed = new T[cols*block_rows];
-    T* rv_it = block_transposed;
+    close();
+    init(dataFileName, rows, cols, true);
 
-    tokenizer::iterator t_it;
+    if(rows == 0 || cols == 0)
+        return;
 
-    unsigned long row = 0;
-    while (std::getline(in, line))
-    {
-        if(!line.empty())
-        {
-            if(row >= first_row && row <= last_row)
-            {
-                tokenizer tokens(line, sep);
-                for (t_it = tokens.begin(); t_it != tokens.end(); ++t_it, ++rv_it)
-                        *rv_it = boost::lexical_cast<T>(*t_it);
-            }
-            ++row;
-        }
-    }
-    in.close();
+    T* block =  new T[std::max(block_rows*cols, 1ul)];
+    if(block_rows > 0)
+        gurls::transpose(&values[0], cols, block_rows, block);
 
-    T* block =  new T[block_rows*cols];
-    gurls::transpose(block_transposed, cols, block_rows, block);
-    setMatrix(first_row, 0, block, block_rows, cols);
+    std::vector<T>().swap(values);
+
+    setMatrixCollective(first_row, 0, block, block_rows, cols);
 
-    delete[] block_transposed;
     delete[] block;
 
     MPI_Barrier(MPI_COMM_WORLD);
@@ -602,24 +961,15 @@ void BigArray<T>::loadNC(const std::string &fileName)
 
 
     // Set up file access property list with parallel I/O access
-    plist_id = H5Pcreate(H5P_FILE_ACCESS);
-    if(plist_id == -1)
-        throw gException(errorString);
+    hid_t fapl_id = createFileAccessList(errorString);
 
     herr_t status;
 
-#ifdef USE_MPIIO
-    status = H5Pset_fapl_mpio(plist_id, MPI_COMM_WORLD, MPI_INFO_NULL);
-#else
-    status = H5Pset_fapl_mpiposix(plist_id, MPI_COMM_WORLD, false);
-#endif
-    CHECK_HDF5_ERR(status, errorString)
-
     // Create a new file collectively and release property list identifier.
-    file_id = H5Fopen(fileName.c_str(), H5F_ACC_RDWR, plist_id);
+    file_id = H5Fopen(fileName.c_str(), H5F_ACC_RDWR, fapl_id);
     CHECK_HDF5_ERR(file_id, errorString)
 
-    status = H5Pclose(plist_id);
+    status = H5Pclose(fapl_id);
     CHECK_HDF5_ERR(status, errorString)
 
     dset_id =  H5Dopen(file_id, "mat", H5P_DEFAULT);
@@ -638,18 +988,39 @@ void BigArray<T>::loadNC(const std::string &fileName)
     this->numrows = static_cast<unsigned long>(dims[1]);
     this->numcols = static_cast<unsigned long>(dims[0]);
 
-    // Create property list for collective dataset write.
-    plist_id = H5Pcreate(H5P_DATASET_XFER);
-    if(plist_id == -1)
-        throw gException(errorString);
+    // The chunk cache can only be set when opening the dataset: reopen chunked datasets with a cache sized for their chunks
+    if(BigArrayIO::cacheBytes > 0)
+    {
+        hid_t dcpl_id = H5Dget_create_plist(dset_id);
+        CHECK_HDF5_ERR(dcpl_id, errorString)
 
-    status = H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_INDEPENDENT);
-    CHECK_HDF5_ERR(status, errorString)
+        if(H5Pget_layout(dcpl_id) == H5D_CHUNKED)
+        {
+            hsize_t chunk[2];
+            status = H5Pget_chunk(dcpl_id, 2, chunk);
+            CHECK_HDF5_ERR(status, errorString)
+
+            status = H5Dclose(dset_id);
+            CHECK_HDF5_ERR(status, errorString)
+
+            hid_t dapl_id = createDatasetAccessList(chunk[0]*chunk[1]*sizeof(T), errorString);
+
+            dset_id =  H5Dopen(file_id, "mat", dapl_id);
+            CHECK_HDF5_ERR(dset_id, errorString)
 
+            status = H5Pclose(dapl_id);
+            CHECK_HDF5_ERR(status, errorString)
+        }
+
+        status = H5Pclose(dcpl_id);
+        CHECK_HDF5_ERR(status, errorString)
+    }
+
+    createTransferLists(errorString);
 }
 
 template <typename T>
-void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c)
+void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c, bool compressed)
 {
     dataFileName = fileName;
 
@@ -659,25 +1030,15 @@ void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c)
     std::string errorString = "Error creating file " + fileName + ":";
 
     // Set up file access property list with parallel I/O access
-    plist_id = H5Pcreate(H5P_FILE_ACCESS);
-    if(plist_id == -1)
-        throw gException(errorString);
+    hid_t fapl_id = createFileAccessList(errorString);
 
     herr_t status;
 
-#ifdef USE_MPIIO
-    status = H5Pset_fapl_mpio(plist_id, MPI_COMM_WORLD, MPI_INFO_NULL);
-#else
-    status = H5Pset_fapl_mpiposix(plist_id, MPI_COMM_WORLD, false);
-#endif
-
-    CHECK_HDF5_ERR(status, errorString)
-
     // Create a new file collectively and release property list identifier.
-    file_id = H5Fcreate(fileName.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, plist_id);
+    file_id = H5Fcreate(fileName.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, fapl_id);
     CHECK_HDF5_ERR(file_id, errorString)
 
-    status = H5Pclose(plist_id);
+    status = H5Pclose(fapl_id);
     CHECK_HDF5_ERR(status, errorString)
 
 
@@ -693,9 +1054,57 @@ void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c)
     if(plist_dset_id == -1)
         throw gException(errorString);
 
-    dset_id = H5Dcreate(file_id, "mat", getHdfType<T>(), filespace, H5P_DEFAULT, plist_dset_id, H5P_DEFAULT);
+    hsize_t chunkBytes = 0;
+
+    if(BigArrayIO::chunked && r > 0 && c > 0 && r*c*sizeof(T) >= BigArrayIO::minChunkedBytes)
+    {
+        int numprocs;
+        MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+
+        // chunks hold whole rows and are aligned to the row blocks owned by each process,
+        // but HDF5 does not allow chunks larger than 4GB (keep them below 1GB, or below the cache size if compressed)
+        hsize_t maxChunkBytes = 1ul << 30;
+        if(compressed && BigArrayIO::compression > 0 && BigArrayIO::cacheBytes > 0)
+            maxChunkBytes = std::min(maxChunkBytes, static_cast<hsize_t>(BigArrayIO::cacheBytes));
+
+        const hsize_t maxChunkElements = std::max(maxChunkBytes/sizeof(T), (hsize_t)1);
+
+        hsize_t chunk[2];
+        chunk[0] = std::min(dims[0], maxChunkElements);
+
+        unsigned long chunkRows = (BigArrayIO::chunkRows > 0)? BigArrayIO::chunkRows: std::max(r/numprocs, 1ul);
+        chunkRows = std::min(chunkRows, r);
+
+        const unsigned long maxRows = static_cast<unsigned long>(std::max(maxChunkElements/chunk[0], (hsize_t)1));
+        if(chunkRows > maxRows)
+        {
+            // split each row block in equally sized chunks
+            const unsigned long pieces = (chunkRows + maxRows - 1)/maxRows;
+            chunkRows = (chunkRows + pieces - 1)/pieces;
+        }
+
+        chunk[1] = static_cast<hsize_t>(chunkRows);
+
+        status = H5Pset_chunk(plist_dset_id, 2, chunk);
+        CHECK_HDF5_ERR(status, errorString)
+
+        if(compressed && BigArrayIO::compression > 0)
+        {
+            status = H5Pset_deflate(plist_dset_id, static_cast<unsigned int>(BigArrayIO::compression));
+            CHECK_HDF5_ERR(status, errorString)
+        }
+
+        chunkBytes = chunk[0]*chunk[1]*sizeof(T);
+    }
+
+    hid_t dapl_id = createDatasetAccessList(chunkBytes, errorString);
+
+    dset_id = H5Dcreate(file_id, "mat", getHdfType<T>(), filespace, H5P_DEFAULT, plist_dset_id, dapl_id);
     CHECK_HDF5_ERR(dset_id, errorString)
 
+    status = H5Pclose(dapl_id);
+    CHECK_HDF5_ERR(status, errorString)
+
     status = H5Pclose(plist_dset_id);
     CHECK_HDF5_ERR(status, errorString)
 
@@ -705,7 +1114,61 @@ void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c)
     this->numrows = r;
     this->numcols = c;
 
-    // Create property list for collective dataset write.
+    createTransferLists(errorString);
+
+    flush();
+}
+
+template <typename T>
+hid_t BigArray<T>::createFileAccessList(const std::string& errorString) const
+{
+    hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+    if(fapl_id == -1)
+        throw gException(errorString);
+
+    herr_t status;
+
+#ifdef USE_MPIIO
+    status = H5Pset_fapl_mpio(fapl_id, MPI_COMM_WORLD, MPI_INFO_NULL);
+#else
+    status = H5Pset_fapl_mpiposix(fapl_id, MPI_COMM_WORLD, false);
+#endif
+    CHECK_HDF5_ERR(status, errorString)
+
+    if(BigArrayIO::alignment > 0)
+    {
+        status = H5Pset_alignment(fapl_id, BigArrayIO::alignment/2, BigArrayIO::alignment);
+        CHECK_HDF5_ERR(status, errorString)
+    }
+
+    return fapl_id;
+}
+
+template <typename T>
+hid_t BigArray<T>::createDatasetAccessList(hsize_t chunkBytes, const std::string& errorString) const
+{
+    hid_t dapl_id = H5Pcreate(H5P_DATASET_ACCESS);
+    if(dapl_id == -1)
+        throw gException(errorString);
+
+    if(chunkBytes > 0 && BigArrayIO::cacheBytes > 0)
+    {
+        // about 100 hash slots per chunk fitting in the cache, odd to spread the hash values
+        const size_t nslots = std::max(static_cast<size_t>(100*(BigArrayIO::cacheBytes/chunkBytes)), static_cast<size_t>(521)) | 1;
+
+        herr_t status = H5Pset_chunk_cache(dapl_id, nslots, BigArrayIO::cacheBytes, 1.0);
+        CHECK_HDF5_ERR(status, errorString)
+    }
+
+    return dapl_id;
+}
+
+template <typename T>
+void BigArray<T>::createTransferLists(const std::string& errorString)
+{
+    herr_t status;
+
+    // Create property list for independent dataset transfers.
     plist_id = H5Pcreate(H5P_DATASET_XFER);
     if(plist_id == -1)
         throw gException(errorString);
@@ -713,7 +1176,17 @@ void BigArray<T>::init(std::string& fileName, unsigned long r, unsigned long c)
     status = H5Pset_dxpl_mpio(plist_id, H5FD_MPIO_INDEPENDENT);
     CHECK_HDF5_ERR(status, errorString)
 
-    flush();
+    // Create property list for the transfers performed by the *Collective methods
+    coll_plist_id = H5Pcreate(H5P_DATASET_XFER);
+    if(coll_plist_id == -1)
+        throw gException(errorString);
+
+#ifdef USE_MPIIO
+    status = H5Pset_dxpl_mpio(coll_plist_id, BigArrayIO::collective? H5FD_MPIO_COLLECTIVE: H5FD_MPIO_INDEPENDENT);
+#else
+    status = H5Pset_dxpl_mpio(coll_plist_id, H5FD_MPIO_INDEPENDENT);
+#endif
+    CHECK_HDF5_ERR(status, errorString)
 }
 
 }
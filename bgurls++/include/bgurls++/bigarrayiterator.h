@@ -0,0 +1,352 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-2013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _GURLS_BIGARRAYITERATOR_H_
+#define _GURLS_BIGARRAYITERATOR_H_
+
+#include "bgurls++/bigarray.h"
+#include "gurls++/gmath.h"
+
+#include <mpi.h>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace gurls
+{
+
+/**
+  * \brief BigArrayRowIterator visits a range of rows of a BigArray (and optionally of a second one with
+  * the same number of rows) in blocks of fixed size.
+  *
+  * Blocks are read into a ring of preallocated buffers. If MPI was initialized with at least
+  * MPI_THREAD_SERIALIZED support, a background thread reads ahead while the caller works on the
+  * current block; otherwise every block is read when it is requested.
+  *
+  * While the iteration is in progress the caller must not perform HDF5 or MPI calls. With collective
+  * reads every process must visit its whole sequence of blocks: all the processes take part in the same
+  * number of reads, processes with fewer blocks than the others get empty blocks at the end.
+  */
+template <typename T>
+class BigArrayRowIterator
+{
+public:
+
+    /**
+      * Order in which the blocks of rows are visited
+      */
+    enum Order
+    {
+        Sequential, ///< blocks are visited by increasing row
+        Shuffled    ///< blocks are visited in a random order, drawn independently by each process
+    };
+
+    /**
+      * Constructor
+      * \param A BigArray to be read
+      * \param B optional second BigArray, read at the same rows of A. May be NULL
+      * \param firstRow first row of the range
+      * \param numRows number of rows in the range
+      * \param blockRows number of rows of each block, except the last one
+      * \param buffers number of buffers of the ring, i.e. number of blocks held in memory at the same time
+      * \param order order in which the blocks are visited
+      * \param collective if true blocks are read with BigArray::getMatrixCollective, and every process must construct
+      * and go through its own iterator at the same time
+      */
+    BigArrayRowIterator(const BigArray<T>& A, const BigArray<T>* B, unsigned long firstRow, unsigned long numRows,
+                        unsigned long blockRows, int buffers = 2, Order order = Sequential, bool collective = true);
+
+    ~BigArrayRowIterator();
+
+    /**
+      * Moves to the next block, releasing the buffer of the current one
+      * \return false when there are no more blocks
+      */
+    bool next();
+
+    /**
+      * Row of the current block, relative to firstRow
+      */
+    unsigned long offset() const {return offsets[current];}
+
+    /**
+      * Number of rows of the current block (possibly 0)
+      */
+    unsigned long rows() const {return sizes[current];}
+
+    /**
+      * Current block of A, rows() x A.cols() column major
+      */
+    const T* blockA() const {return buffersA[current];}
+
+    /**
+      * Current block of B, rows() x B->cols() column major
+      */
+    const T* blockB() const {return buffersB[current];}
+
+    /**
+      * Returns true if blocks are read by a background thread
+      */
+    bool prefetching() const {return reader != NULL;}
+
+protected:
+
+    void read(unsigned long round, int buffer);
+
+    void readAhead();
+
+    const BigArray<T>& A;
+    const BigArray<T>* B;
+
+    const unsigned long firstRow;
+    const unsigned long numRows;
+    const unsigned long blockRows;
+    const bool collective;
+
+    std::vector<unsigned long> blocks;  ///< block visited at each round
+    unsigned long rounds;
+    unsigned long consumed;             ///< number of rounds returned by next
+
+    int numBuffers;
+    int current;
+    std::vector<T*> buffersA;
+    std::vector<T*> buffersB;
+    std::vector<unsigned long> offsets;
+    std::vector<unsigned long> sizes;
+    std::vector<bool> ready;
+
+    boost::thread* reader;
+    boost::mutex mutex;
+    boost::condition_variable changed;
+    bool abandoned;
+    std::string error;
+
+private:
+    BigArrayRowIterator(const BigArrayRowIterator<T>&);
+    BigArrayRowIterator<T>& operator=(const BigArrayRowIterator<T>&);
+};
+
+template <typename T>
+BigArrayRowIterator<T>::BigArrayRowIterator(const BigArray<T>& A, const BigArray<T>* B, unsigned long firstRow, unsigned long numRows,
+                                            unsigned long blockRows, int buffers, Order order, bool collective)
+    : A(A), B(B), firstRow(firstRow), numRows(numRows), blockRows(std::max(blockRows, 1ul)), collective(collective),
+      consumed(0), current(0), reader(NULL), abandoned(false)
+{
+    unsigned long numBlocks = (numRows + this->blockRows - 1)/this->blockRows;
+
+    blocks.resize(numBlocks);
+    for(unsigned long i = 0; i < numBlocks; ++i)
+        blocks[i] = i;
+
+    if(order == Shuffled && numBlocks > 0)
+        randperm(numBlocks, &blocks[0], false);
+
+    rounds = numBlocks;
+    if(collective)
+        MPI_Allreduce(&numBlocks, &rounds, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+    int provided = MPI_THREAD_SINGLE;
+    MPI_Query_thread(&provided);
+
+    const bool prefetch = (buffers > 1) && (rounds > 1) && (provided >= MPI_THREAD_SERIALIZED);
+    numBuffers = prefetch? buffers: 1;
+
+    const unsigned long rowsA = std::min(this->blockRows, numRows);
+    for(int i = 0; i < numBuffers; ++i)
+    {
+        buffersA.push_back(new T[std::max(rowsA*A.cols(), 1ul)]);
+        buffersB.push_back((B != NULL)? new T[std::max(rowsA*B->cols(), 1ul)]: NULL);
+    }
+    offsets.resize(numBuffers, 0);
+    sizes.resize(numBuffers, 0);
+    ready.resize(numBuffers, false);
+
+    if(prefetch)
+        reader = new boost::thread(boost::bind(&BigArrayRowIterator<T>::readAhead, this));
+}
+
+template <typename T>
+BigArrayRowIterator<T>::~BigArrayRowIterator()
+{
+    if(reader != NULL)
+    {
+        // the reader completes the remaining reads, which may be collective, without waiting for free buffers
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            abandoned = true;
+        }
+        changed.notify_all();
+
+        reader->join();
+        delete reader;
+    }
+
+    for(int i = 0; i < numBuffers; ++i)
+    {
+        delete[] buffersA[i];
+        delete[] buffersB[i];
+    }
+}
+
+template <typename T>
+bool BigArrayRowIterator<T>::next()
+{
+    if(consumed > 0 && reader != NULL)
+    {
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            ready[current] = false;
+        }
+        changed.notify_all();
+    }
+
+    if(consumed == rounds)
+    {
+        if(reader != NULL)
+        {
+            reader->join();
+            delete reader;
+            reader = NULL;
+        }
+
+        return false;
+    }
+
+    current = consumed%numBuffers;
+
+    if(reader != NULL)
+    {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while(!ready[current])
+            changed.wait(lock);
+
+        if(!error.empty())
+            throw gException(error);
+    }
+    else
+        read(consumed, current);
+
+    ++consumed;
+
+    return true;
+}
+
+template <typename T>
+void BigArrayRowIterator<T>::read(unsigned long round, int buffer)
+{
+    unsigned long offset = 0;
+    unsigned long size = 0;
+
+    if(round < blocks.size())
+    {
+        offset = blocks[round]*blockRows;
+        size = std::min(blockRows, numRows-offset);
+    }
+
+    offsets[buffer] = offset;
+    sizes[buffer] = size;
+
+    if(collective)
+    {
+        A.getMatrixCollective(firstRow+offset, 0, size, A.cols(), buffersA[buffer]);
+        if(B != NULL)
+            B->getMatrixCollective(firstRow+offset, 0, size, B->cols(), buffersB[buffer]);
+    }
+    else if(size > 0)
+    {
+        A.getMatrix(firstRow+offset, 0, size, A.cols(), buffersA[buffer]);
+        if(B != NULL)
+            B->getMatrix(firstRow+offset, 0, size, B->cols(), buffersB[buffer]);
+    }
+}
+
+template <typename T>
+void BigArrayRowIterator<T>::readAhead()
+{
+    for(unsigned long r = 0; r < rounds; ++r)
+    {
+        const int buffer = r%numBuffers;
+
+        {
+            boost::unique_lock<boost::mutex> lock(mutex);
+            while(ready[buffer] && !abandoned)
+                changed.wait(lock);
+        }
+
+        // nothing may escape the thread, it would terminate the program: the consumer rethrows the error
+        std::string message;
+        try
+        {
+            read(r, buffer);
+        }
+        catch(gException& e)
+        {
+            message = e.getMessage();
+        }
+        catch(std::exception& e)
+        {
+            message = e.what();
+        }
+        catch(...)
+        {
+            message = "Unknown error while reading ahead";
+        }
+
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            ready[buffer] = true;
+            if(error.empty())
+                error = message;
+        }
+        changed.notify_all();
+    }
+}
+
+}
+
+#endif //_GURLS_BIGARRAYITERATOR_H_
@@ -50,23 +50,61 @@
 #define _GURLS_BIGMATH_H_
 
 #include "gurls++/gmath.h"
+#include "gurls++/optlist.h"
 #include "bgurls++/bigarray.h"
 
 #include "bgurls++/mpi_utils.h"
+#include "bgurls++/bigarrayiterator.h"
+#include "bgurls++/workmanager.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
 
 namespace gurls
 {
 
+/**
+ * Assignments of the row blocks of the operands of matMult_AtB and matMult_AB to the processes
+ */
+enum AtBSchedule
+{
+    AtBStatic,  ///< each process reads its own block of rows, overlapping reads and products
+    AtBDynamic  ///< blocks of rows are booked through a WorkManager by the processes as they become idle
+};
+
+/**
+ * Returns the matMult_AtB schedule named by the field atb_schedule ("static" or "dynamic")
+ * of an options list, AtBStatic if the field is missing
+ */
+inline AtBSchedule atbSchedule(const GurlsOptionsList& opt)
+{
+    if(!opt.hasOpt("atb_schedule"))
+        return AtBStatic;
+
+    const std::string name = opt.getOptAsString("atb_schedule");
+
+    if(name == "static")
+        return AtBStatic;
+    if(name == "dynamic")
+        return AtBDynamic;
+
+    throw gException(Exception_Illegal_Argument_Value);
+}
+
 /**
  * Performs Matrix-matrix multiplication (AB) between BigArrays
  * \param A first matrix
  * \param B second matrix
  * \param resultFile filename where result BigArray has to be stored
  * \param memB available memory in bytes
+ * \param schedule AtBStatic assigns the blocks of rows of A round robin, AtBDynamic hands them out through
+ * a WorkManager, which needs a state file on a filesystem shared by all the processes
  * \return the result BigArray
  */
 template<typename T>
-BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, const unsigned long memB /*const unsigned long memMB*/)
+BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, const unsigned long memB /*const unsigned long memMB*/,
+                        AtBSchedule schedule = AtBStatic)
 {
 
     if(A.cols() != B.rows())
@@ -103,7 +141,22 @@ BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::s
     gMat2D<T>* U = new gMat2D<T>;
     gMat2D<T>* V = new gMat2D<T>;
 
-    for(int block=myid; block<numBlocks; block+=numprocs)
+    // with the dynamic schedule blocks of rows of A are handed out on demand, so that faster processes take more of them
+    const std::string workFile = resultFile + ".work";
+    WorkManager* work = NULL;
+
+    if(schedule == AtBDynamic)
+    {
+        if(myid == 0)
+            WorkManager::setup(workFile, numBlocks, std::numeric_limits<double>::max());
+
+        MPI_Barrier(MPI_COMM_WORLD);
+
+        work = new WorkManager(workFile);
+    }
+
+    long block = (work != NULL)? work->getWork(): myid;
+    while(block >= 0 && block < numBlocks)
     {
         unsigned long rows, cols;
 
@@ -129,12 +182,25 @@ BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::s
 
             ret->setMatrix(block*blockRowsA, cblock*blockColsB, result);
         }
+
+        if(work != NULL)
+        {
+            work->reportWork(block);
+            block = work->getWork();
+        }
+        else
+            block += numprocs;
     }
 
+    delete work;
     delete U;
     delete V;
 
     MPI_Barrier(MPI_COMM_WORLD);
+
+    if(schedule == AtBDynamic && myid == 0)
+        WorkManager::dismiss(workFile);
+
     return ret;
 
 }
@@ -176,14 +242,14 @@ BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::s
     gMat2D<T>* U = new gMat2D<T>;
     gMat2D<T>* V = new gMat2D<T>;
 
-    A.getMatrix(myid*blockSize, 0, blockRows, d, *U);
-    B.getMatrix(0, 0, d, t, *V);
+    A.getMatrixCollective(myid*blockSize, 0, blockRows, d, *U);
+    B.getMatrixCollective(0, 0, d, t, *V);
 
     T* result = new T[blockRows*t];
 
     dot(U->getData(), V->getData(), result, blockRows, d, d, t, blockRows, t, CblasNoTrans, CblasNoTrans, CblasColMajor);
 
-    ret->setMatrix(myid*blockSize, 0, result, blockRows, t);
+    ret->setMatrixCollective(myid*blockSize, 0, result, blockRows, t);
 
     delete [] result;
     delete U;
@@ -195,137 +261,221 @@ BigArray<T>* matMult_AB(const BigArray<T>& A, const BigArray<T>& B, const std::s
 }
 
 /**
- * Performs Matrix-matrix multiplication (A'B) between BigArrays
- * \param A first matrix
- * \param B second matrix
- * \param resultFile filename where result BigArray has to be stored
- * \param memB available memory in bytes
- * \return the result BigArray
+ * Schemes available to matMult_AtB to sum up the partial products computed by the processes
  */
-template<typename T>
-BigArray<T>* matMult_AtB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, const unsigned long memB /*const unsigned long memMB*/)
+enum AtBReduction
 {
+    AtBReduceRoot,  ///< partial products are summed on process 0, which writes the whole result
+    AtBReduceTree,  ///< MPI_Reduce_scatter: each process receives and writes one block of columns of the result
+    AtBReduceRing   ///< same as AtBReduceTree, with a bandwidth optimal ring of numprocs-1 point to point exchanges
+};
 
-    if(A.rows() != B.rows())
-        throw gException(Exception_Inconsistent_Size);
-
-
-//    const unsigned long bytesInMB = 1024*1024;
-//    const unsigned long cells = static_cast<unsigned long>((memMB*bytesInMB)/sizeof(T));
-    const unsigned long cells = static_cast<unsigned long>(memB/sizeof(T));
-
-    const unsigned long n = A.rows();
-    const unsigned long d = A.cols();
-    const unsigned long t = B.cols();
+/**
+ * Returns the matMult_AtB reduction scheme named by the field atb_reduction ("root", "tree" or "ring")
+ * of an options list, AtBReduceTree if the field is missing
+ */
+inline AtBReduction atbReduction(const GurlsOptionsList& opt)
+{
+    if(!opt.hasOpt("atb_reduction"))
+        return AtBReduceTree;
 
+    const std::string name = opt.getOptAsString("atb_reduction");
 
-    if(cells < (2*d*t)+d+t) // maximum allocated cells are 2*d*t (sum+reduced or sum+result)
-        throw gException("Not enough memory available to complete the operation");
+    if(name == "root")
+        return AtBReduceRoot;
+    if(name == "tree")
+        return AtBReduceTree;
+    if(name == "ring")
+        return AtBReduceRing;
 
+    throw gException(Exception_Illegal_Argument_Value);
+}
 
+/**
+ * Ring reduce-scatter: on return the block of \a buffer owned by each process holds the sum of that block over all processes
+ * \param buffer local data, partitioned in numprocs consecutive blocks
+ * \param counts number of elements of each block
+ * \param displs offset of each block in \a buffer
+ * \param maxCount largest number of elements sent by a single MPI call: larger blocks are sent in pieces
+ */
+template<typename T>
+void ringReduceScatter(T* buffer, const unsigned long* counts, const unsigned long* displs, const unsigned long maxCount = mpiMaxCount)
+{
     int numprocs;
     int myid;
     MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
     MPI_Comm_rank(MPI_COMM_WORLD, &myid);
 
+    const int next = (myid+1)%numprocs;
+    const int prev = (myid-1+numprocs)%numprocs;
+
+    // every process sends the same number of pieces, so that all the transfers are matched
+    const unsigned long largest = *std::max_element(counts, counts+numprocs);
+    const unsigned long piece = std::min(largest, maxCount);
 
-    T maxBlockSize = std::floor(static_cast<T>(cells - (d*t))/(d+t));
-    int numBlocks = static_cast<int>( std::ceil(static_cast<T>(n)/maxBlockSize) );
+    T* received = new T[std::max(piece, 1ul)];
 
-    if(numprocs < numBlocks)
+    // at step s a process forwards the partial sum of block myid-s-1 and accumulates block myid-s-2:
+    // after numprocs-1 steps its own block has gone through all the processes
+    for(int s = 0; s < numprocs-1; ++s)
     {
-        maxBlockSize = std::floor(static_cast<T>(cells - 2*(d*t))/(d+t));
-        numBlocks = static_cast<int>( std::ceil(static_cast<T>(n)/maxBlockSize) );
+        const int sendBlock = (myid-s-1+2*numprocs)%numprocs;
+        const int recvBlock = (myid-s-2+2*numprocs)%numprocs;
+
+        for(unsigned long i = 0; i < largest; i += piece)
+        {
+            const unsigned long sendCount = (counts[sendBlock] > i)? std::min(counts[sendBlock]-i, piece): 0;
+            const unsigned long recvCount = (counts[recvBlock] > i)? std::min(counts[recvBlock]-i, piece): 0;
+
+            MPI_SendrecvT(buffer+displs[sendBlock]+i, static_cast<int>(sendCount), next,
+                          received, static_cast<int>(recvCount), prev, s, MPI_COMM_WORLD);
+
+            axpy(recvCount, (T)1.0, received, 1, buffer+displs[recvBlock]+i, 1);
+        }
     }
 
-    const unsigned long blockRows = n/numBlocks;
-    const unsigned long lastBlockRows = n%numBlocks;
+    delete [] received;
+}
+
+/**
+ * MPI_Reduce_scatter of blocks of any size. Since the counts of a single call are int, and so is their sum
+ * in many MPI implementations, blocks are reduced in rounds each one scattering the next piece of every block
+ * \param buffer local data, partitioned in numprocs consecutive blocks
+ * \param reduced on return holds the sum over all processes of the block owned by this process
+ * \param counts number of elements of each block
+ * \param displs offset of each block in \a buffer
+ * \param maxCount largest number of elements moved by a single MPI call
+ */
+template<typename T>
+void blockReduceScatter(T* buffer, T* reduced, const unsigned long* counts, const unsigned long* displs,
+                        const unsigned long maxCount = mpiMaxCount)
+{
+    int numprocs;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
 
+    const unsigned long largest = *std::max_element(counts, counts+numprocs);
+    const unsigned long piece = std::min(largest, std::max(maxCount/numprocs, 1ul));
 
-    T* sum = new T[d*t];    // size: d*t
-    set(sum, (T)0.0, d*t);
+    int* pieceCounts = new int[numprocs];
 
-    gMat2D<T>* U = new gMat2D<T>;   // max size: blockRows*d
-    gMat2D<T>* V = new gMat2D<T>;   // max size: blockRows*t
+    // a single round reduces buffer in place, otherwise the pieces are packed
+    T* packed = (largest > piece)? new T[numprocs*piece]: NULL;
 
-    for(int block=myid; block<numBlocks; block+=numprocs)
+    for(unsigned long i = 0; i < largest; i += piece)
     {
-        unsigned long rows;
+        T* it = packed;
 
-        if(block == (numBlocks-1) && lastBlockRows != 0)
+        for(int p = 0; p < numprocs; ++p)
         {
-            A.getMatrix(block*blockRows, 0, lastBlockRows, d, *U);
-            B.getMatrix(block*blockRows, 0, lastBlockRows, t, *V);
-
-            rows = lastBlockRows;
+            const unsigned long count = (counts[p] > i)? std::min(counts[p]-i, piece): 0;
+            pieceCounts[p] = static_cast<int>(count);
+
+            if(packed != NULL)
+            {
+                copy(it, buffer+displs[p]+i, count);
+                it += count;
+            }
         }
-        else
-        {
-            A.getMatrix(block*blockRows, 0, blockRows, d, *U);
-            B.getMatrix(block*blockRows, 0, blockRows, t, *V);
 
-            rows = blockRows;
-        }
+        MPI_ReduceScatterT((packed != NULL)? packed: buffer, reduced+i, pieceCounts, MPI_SUM, MPI_COMM_WORLD);
+    }
 
+    delete [] packed;
+    delete [] pieceCounts;
+}
 
-        if(numprocs < numBlocks)
-        {
-            T* result = new T[d*t]; // size: d*t
+/**
+ * Sums up the d x t partial products computed by the processes and stores the result in a new BigArray.
+ * Must be called by all the processes at the same time
+ * \param sum local partial product, column major. Its content is overwritten
+ * \param d number of rows of the product
+ * \param t number of columns of the product
+ * \param resultFile filename where result BigArray has to be stored
+ * \param reduction scheme used to sum up the partial products
+ * \return the result BigArray
+ */
+template<typename T>
+BigArray<T>* reduceAtB(T* sum, const unsigned long d, const unsigned long t, const std::string& resultFile, AtBReduction reduction)
+{
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    BigArray<T>* ret = new BigArray<T>(resultFile, d, t);
 
-            dot(U->getData(), V->getData(), result, rows, d, rows, t, d, t, CblasTrans, CblasNoTrans, CblasColMajor);
-            axpy(d*t, (T)1.0, result, 1, sum, 1);
+    if(reduction == AtBReduceRoot)
+    {
+        T* reduced = NULL;
+        if(myid == 0)
+            reduced = new T[d*t];
 
-            delete [] result;
-        }
-        else
-            dot(U->getData(), V->getData(), sum, rows, d, rows, t, d, t, CblasTrans, CblasNoTrans, CblasColMajor);
+        MPI_ReduceLargeT(sum, reduced, d*t, MPI_SUM, 0, MPI_COMM_WORLD);
 
+        if(myid == 0)
+        {
+            ret->setMatrix(0, 0, reduced, d, t);
+            delete[] reduced;
+        }
     }
+    else
+    {
+        // process p owns columns [p*colBlock, p*colBlock + cols_p) of the result, contiguous in sum
+        const unsigned long colBlock = t/numprocs;
 
-    delete U;
-    delete V;
+        unsigned long* counts = new unsigned long[numprocs];
+        unsigned long* displs = new unsigned long[numprocs];
+        for(int p = 0; p < numprocs; ++p)
+        {
+            counts[p] = d*(colBlock + ((p == numprocs-1)? t%numprocs: 0));
+            displs[p] = d*colBlock*p;
+        }
 
-    T* reduced = NULL;
-    if(myid == 0)
-        reduced = new T[d*t]; // size: d*t
+        const unsigned long myCols = (d > 0)? counts[myid]/d: 0;
 
-    MPI_ReduceT(sum, reduced, d*t, MPI_SUM, 0, MPI_COMM_WORLD);
+        if(reduction == AtBReduceRing)
+        {
+            ringReduceScatter(sum, counts, displs);
+            ret->setMatrixCollective(0, myid*colBlock, sum+displs[myid], d, myCols);
+        }
+        else
+        {
+            T* reduced = new T[std::max(counts[myid], 1ul)];
 
-    delete [] sum;
+            blockReduceScatter(sum, reduced, counts, displs);
+            ret->setMatrixCollective(0, myid*colBlock, reduced, d, myCols);
 
+            delete [] reduced;
+        }
 
-    BigArray<T>* ret = new BigArray<T>(resultFile, d, t);
-    if(myid == 0)
-    {
-        ret->setMatrix(0, 0, reduced, d, t);
-        delete[] reduced;
+        delete [] counts;
+        delete [] displs;
     }
-    MPI_Barrier(MPI_COMM_WORLD);
 
     return ret;
-
 }
 
 /**
- * Performs Matrix-matrix multiplication (A'B) between BigArrays
+ * Pipelined kernel of matMult_AtB. Each process multiplies its own block of rows of A and B
+ * reading readRows rows at a time with a BigArrayRowIterator, so that the next rows are read
+ * while the current ones are multiplied.
+ * If A and B are the same BigArray only A is read and the product is accumulated with syrk.
  * \param A first matrix
  * \param B second matrix
  * \param resultFile filename where result BigArray has to be stored
- * \param memB available memory in bytes
+ * \param readRows number of rows read at a time by each process
+ * \param reduction scheme used to sum up the partial products
  * \return the result BigArray
  */
 template<typename T>
-BigArray<T>* matMult_AtB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile)
+BigArray<T>* matMult_AtB_pipelined(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, unsigned long readRows, AtBReduction reduction)
 {
-
-    if(A.rows() != B.rows())
-        throw gException(Exception_Inconsistent_Size);
-
-
     const unsigned long n = A.rows();
     const unsigned long d = A.cols();
     const unsigned long t = B.cols();
 
+    const bool symmetric = (&A == &B);
+
 
     int numprocs;
     int myid;
@@ -336,41 +486,205 @@ BigArray<T>* matMult_AtB(const BigArray<T>& A, const BigArray<T>& B, const std::
     const unsigned long blockSize = n/numprocs;
     const unsigned long remainder = (myid == numprocs-1)? (n%numprocs): 0;
     const unsigned long blockRows = blockSize + remainder;
+    const unsigned long firstRow = myid*blockSize;
 
 
     T* sum = new T[d*t];
     set(sum, (T)0.0, d*t);
 
-    gMat2D<T>* U = new gMat2D<T>;
-    gMat2D<T>* V = new gMat2D<T>;
+    {
+        BigArrayRowIterator<T> it(A, symmetric? NULL: &B, firstRow, blockRows, readRows);
 
-    A.getMatrix(myid*blockSize, 0, blockRows, d, *U);
-    B.getMatrix(myid*blockSize, 0, blockRows, t, *V);
+        while(it.next())
+        {
+            const unsigned long rows = it.rows();
 
-    dot(U->getData(), V->getData(), sum, blockRows, d, blockRows, t, d, t, CblasTrans, CblasNoTrans, CblasColMajor);
+            if(rows == 0)
+                continue;
 
-    delete U;
-    delete V;
+            if(symmetric)
+                syrk(CblasUpper, CblasTrans, d, rows, (T)1.0, it.blockA(), rows, (T)1.0, sum, d);
+            else
+                gemm(CblasTrans, CblasNoTrans, d, t, rows, (T)1.0, it.blockA(), rows, it.blockB(), rows, (T)1.0, sum, d);
+        }
+    }
 
-    T* reduced = NULL;
-    if(myid == 0)
-        reduced = new T[d*t];
+    // syrk only updates the upper triangle
+    if(symmetric)
+        for(unsigned long j = 0; j < d; ++j)
+            for(unsigned long i = j+1; i < d; ++i)
+                sum[i + j*d] = sum[j + i*d];
 
-    MPI_ReduceT(sum, reduced, d*t, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    BigArray<T>* ret = reduceAtB(sum, d, t, resultFile, reduction);
 
     delete [] sum;
 
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    return ret;
+}
+
+/**
+ * Dynamically scheduled kernel of matMult_AtB. The rows of A and B are split in blocks of readRows rows,
+ * which the processes book through a WorkManager and read independently, so that the work follows
+ * the speed of each process instead of being split evenly in advance.
+ * If A and B are the same BigArray only A is read and the product is accumulated with syrk.
+ * \param A first matrix
+ * \param B second matrix
+ * \param resultFile filename where result BigArray has to be stored
+ * \param readRows number of rows of each block
+ * \param reduction scheme used to sum up the partial products
+ * \return the result BigArray
+ */
+template<typename T>
+BigArray<T>* matMult_AtB_dynamic(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, unsigned long readRows, AtBReduction reduction)
+{
+    const unsigned long n = A.rows();
+    const unsigned long d = A.cols();
+    const unsigned long t = B.cols();
+
+    const bool symmetric = (&A == &B);
+
+
+    int myid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+
+    readRows = std::max(readRows, 1ul);
+    const unsigned long numBlocks = (n + readRows - 1)/readRows;
+
+    const std::string workFile = resultFile + ".work";
 
-    BigArray<T>* ret = new BigArray<T>(resultFile, d, t);
     if(myid == 0)
+        WorkManager::setup(workFile, numBlocks, std::numeric_limits<double>::max());
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+
+    T* sum = new T[d*t];
+    set(sum, (T)0.0, d*t);
+
+    T* bufferA = new T[readRows*d];
+    T* bufferB = symmetric? NULL: new T[readRows*t];
+
     {
-        ret->setMatrix(0, 0, reduced, d, t);
-        delete[] reduced;
+        WorkManager work(workFile);
+
+        long block;
+        while((block = work.getWork()) >= 0)
+        {
+            const unsigned long firstRow = block*readRows;
+            const unsigned long rows = std::min(readRows, n - firstRow);
+
+            A.getMatrix(firstRow, 0, rows, d, bufferA);
+
+            if(symmetric)
+                syrk(CblasUpper, CblasTrans, d, rows, (T)1.0, bufferA, rows, (T)1.0, sum, d);
+            else
+            {
+                B.getMatrix(firstRow, 0, rows, t, bufferB);
+                gemm(CblasTrans, CblasNoTrans, d, t, rows, (T)1.0, bufferA, rows, bufferB, rows, (T)1.0, sum, d);
+            }
+
+            work.reportWork(block);
+        }
     }
+
+    delete [] bufferA;
+    delete [] bufferB;
+
+    // syrk only updates the upper triangle
+    if(symmetric)
+        for(unsigned long j = 0; j < d; ++j)
+            for(unsigned long i = j+1; i < d; ++i)
+                sum[i + j*d] = sum[j + i*d];
+
+
+    BigArray<T>* ret = reduceAtB(sum, d, t, resultFile, reduction);
+
+    delete [] sum;
+
     MPI_Barrier(MPI_COMM_WORLD);
 
+    if(myid == 0)
+        WorkManager::dismiss(workFile);
+
     return ret;
+}
+
+/**
+ * Performs Matrix-matrix multiplication (A'B) between BigArrays
+ * \param A first matrix
+ * \param B second matrix
+ * \param resultFile filename where result BigArray has to be stored
+ * \param memB available memory in bytes
+ * \param reduction scheme used to sum up the partial products of the processes
+ * \param schedule assignment of the rows to the processes
+ * \return the result BigArray
+ */
+template<typename T>
+BigArray<T>* matMult_AtB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, const unsigned long memB /*const unsigned long memMB*/,
+                         AtBReduction reduction = AtBReduceTree, AtBSchedule schedule = AtBStatic)
+{
+
+    if(A.rows() != B.rows())
+        throw gException(Exception_Inconsistent_Size);
+
+
+//    const unsigned long bytesInMB = 1024*1024;
+//    const unsigned long cells = static_cast<unsigned long>((memMB*bytesInMB)/sizeof(T));
+    const unsigned long cells = static_cast<unsigned long>(memB/sizeof(T));
+
+    const unsigned long d = A.cols();
+    const unsigned long t = B.cols();
+
+    // allocated cells: d*t partial product, up to d*t reduced result and two buffers
+    // of readRows*(d+t) cells, readRows*d if B is A
+    const unsigned long reserved = 2*d*t;
+    const unsigned long rowCells = 2*((&A == &B)? d: d+t);
+
+    if(cells < reserved + rowCells)
+        throw gException("Not enough memory available to complete the operation");
+
+    const unsigned long readRows = (cells - reserved)/rowCells;
+
+    if(schedule == AtBDynamic)
+        return matMult_AtB_dynamic(A, B, resultFile, readRows, reduction);
+
+    return matMult_AtB_pipelined(A, B, resultFile, readRows, reduction);
+}
+
+/**
+ * Performs Matrix-matrix multiplication (A'B) between BigArrays, assuming that a block of rows of A and B
+ * per process can be loaded in memory
+ * \param A first matrix
+ * \param B second matrix
+ * \param resultFile filename where result BigArray has to be stored
+ * \param reduction scheme used to sum up the partial products of the processes
+ * \param schedule assignment of the rows to the processes
+ * \return the result BigArray
+ */
+template<typename T>
+BigArray<T>* matMult_AtB(const BigArray<T>& A, const BigArray<T>& B, const std::string& resultFile, AtBReduction reduction = AtBReduceTree,
+                         AtBSchedule schedule = AtBStatic)
+{
+
+    if(A.rows() != B.rows())
+        throw gException(Exception_Inconsistent_Size);
+
+
+    int numprocs;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+
+    // four reads per process, so that three of them overlap with the products
+    const unsigned long maxBlockRows = A.rows()/numprocs + A.rows()%numprocs;
+    const unsigned long readRows = (maxBlockRows + 3)/4;
+
+    if(schedule == AtBDynamic)
+        return matMult_AtB_dynamic(A, B, resultFile, readRows, reduction);
 
+    return matMult_AtB_pipelined(A, B, resultFile, readRows, reduction);
 }
 
 /**
@@ -405,13 +719,13 @@ BigArray<T>* matMult_ABt(BigArray<T>& bU, BigArray<T>& bV,  const std::string& r
 
     if(myid != numprocs-1)
     {
-        bU.getMatrix(0, myid*blockSize, bU.rows(), blockSize, *U);
-        bV.getMatrix(0, myid*blockSize, bV.rows(), blockSize, *V);
+        bU.getMatrixCollective(0, myid*blockSize, bU.rows(), blockSize, *U);
+        bV.getMatrixCollective(0, myid*blockSize, bV.rows(), blockSize, *V);
     }
     else
     {
-        bU.getMatrix(0, myid*blockSize, bU.rows(), lastBlockSize, *U);
-        bV.getMatrix(0, myid*blockSize, bV.rows(), lastBlockSize, *V);
+        bU.getMatrixCollective(0, myid*blockSize, bU.rows(), lastBlockSize, *U);
+        bV.getMatrixCollective(0, myid*blockSize, bV.rows(), lastBlockSize, *V);
     }
 
 
@@ -445,6 +759,371 @@ BigArray<T>* matMult_ABt(BigArray<T>& bU, BigArray<T>& bV,  const std::string& r
     return ret;
 }
 
+/**
+ * Computes offset and size of one of the 2*numprocs blocks of consecutive columns
+ * in which eig_sm_jacobi splits a d x d matrix
+ */
+inline void jacobiBlock(const unsigned long d, const int numprocs, const int block, unsigned long& offset, unsigned long& size)
+{
+    const unsigned long blocks = 2*numprocs;
+    const unsigned long b = static_cast<unsigned long>(block);
+
+    size = d/blocks + ((b < d%blocks)? 1: 0);
+    offset = b*(d/blocks) + std::min(b, d%blocks);
+}
+
+/**
+ * Returns true if the field gram_solver of an options list asks the d x d systems of primal RLS to be solved
+ * by all the processes with eig_sm_jacobi ("jacobi", or "auto" with more than one process)
+ * instead of by process 0 alone ("root")
+ */
+inline bool distributedGramSolver(const GurlsOptionsList& opt)
+{
+    int numprocs;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+
+    if(!opt.hasOpt("gram_solver"))
+        return numprocs > 1;
+
+    const std::string name = opt.getOptAsString("gram_solver");
+
+    if(name == "root")
+        return false;
+    if(name == "jacobi")
+        return true;
+    if(name == "auto")
+        return numprocs > 1;
+
+    throw gException(Exception_Illegal_Argument_Value);
+}
+
+/**
+ * Eigendecomposition of a symmetric positive semidefinite d x d matrix K distributed over the processes,
+ * computed with a parallel one-sided block Jacobi method.
+ *
+ * The columns of K are split in 2*numprocs blocks (see jacobiBlock) and every process holds two of them.
+ * At each step a process makes the columns of its pair of blocks orthogonal, rotating them by the right
+ * singular vectors of the pair, then blocks move to the next process along a round-robin tournament
+ * so that in 2*numprocs-1 steps (a sweep) every pair of blocks meets once.
+ * When no rotation is needed the columns of K*Q are orthogonal: Q are the eigenvectors and the norms
+ * of the columns of K*Q the eigenvalues. No process ever holds more than two blocks of columns.
+ * The norms are the absolute values of the eigenvalues, so K has to be positive semidefinite.
+ *
+ * \param U on input the columns of K in blocks myid and 2*numprocs-1-myid, d x m; destroyed
+ * \param d order of K
+ * \param Q on output the eigenvectors held by the process, d x m
+ * \param L on output the corresponding eigenvalues, m x 1
+ * \param maxSweeps maximum number of sweeps
+ * \return number of sweeps performed
+ * \throws gException if rotations are still needed after maxSweeps sweeps
+ */
+template<typename T>
+int eig_sm_jacobi(gMat2D<T>& U, const unsigned long d, gMat2D<T>& Q, gMat2D<T>& L, const int maxSweeps = 30)
+{
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    const int blocks = 2*numprocs;
+
+    // blocks held by each process
+    std::vector<int> top(numprocs), bottom(numprocs);
+    for(int k = 0; k < numprocs; ++k)
+    {
+        top[k] = k;
+        bottom[k] = blocks-1-k;
+    }
+
+    std::vector<unsigned long> offsets(blocks), sizes(blocks);
+    for(int b = 0; b < blocks; ++b)
+        jacobiBlock(d, numprocs, b, offsets[b], sizes[b]);
+
+    unsigned long bt = sizes[top[myid]];
+    unsigned long bb = sizes[bottom[myid]];
+
+    if(U.rows() != d || U.cols() != bt+bb)
+        throw gException(Exception_Inconsistent_Size);
+
+    // block 0 is the largest one
+    const unsigned long maxCols = 2*sizes[0];
+
+    T* u = new T[d*maxCols];    // columns of K*Q
+    T* v = new T[d*maxCols];    // columns of Q
+    T* tmp = new T[d*maxCols];
+
+    copy(u, U.getData(), d*(bt+bb));
+    U.resize(0, 0);
+
+    set(v, (T)0.0, d*maxCols);
+    for(unsigned long j = 0; j < bt; ++j)
+        v[offsets[top[myid]] + j + j*d] = (T)1.0;
+    for(unsigned long j = 0; j < bb; ++j)
+        v[offsets[bottom[myid]] + j + (bt+j)*d] = (T)1.0;
+
+    T* G = new T[maxCols*maxCols];
+    T* s = new T[maxCols];
+    T* Vt = new T[maxCols*maxCols];
+
+    T* sendBuffer = new T[2*d*sizes[0]];
+    T* recvTop = new T[2*d*sizes[0]];
+    T* recvBottom = new T[2*d*sizes[0]];
+
+    char jobu = 'N';
+    char jobvt = 'A';
+    int m_ = static_cast<int>(d);
+    int n_ = static_cast<int>(maxCols);
+    int ld = std::max(m_, 1);
+    int ldvt = std::max(n_, 1);
+    int one = 1;
+    int info;
+    int lwork = -1;
+    T wsize;
+    gesvd_(&jobu, &jobvt, &m_, &n_, tmp, &ld, s, tmp, &one, Vt, &ldvt, &wsize, &lwork, &info);
+    lwork = std::max(static_cast<int>(wsize), std::max(3*n_+m_, 5*n_));
+    T* work = new T[lwork];
+
+    const T tol = std::max(d, 1ul)*std::numeric_limits<T>::epsilon();
+
+    int sweep = 0;
+    bool converged = false;
+    while(sweep < maxSweeps)
+    {
+        ++sweep;
+
+        unsigned long rotations = 0;
+
+        for(int step = 0; step < blocks-1; ++step)
+        {
+            const unsigned long m = bt+bb;
+
+            // all the pairs of columns at the first step of a sweep, pairs across the two blocks afterwards
+            bool rotate = false;
+
+            if(m > 1)
+            {
+                gemm(CblasTrans, CblasNoTrans, m, m, d, (T)1.0, u, d, u, d, (T)0.0, G, m);
+
+                // the rotation leaves couplings of the order of eps*m*max(G_ii): below that they are rounding errors
+                T gmax = 0;
+                for(unsigned long i = 0; i < m; ++i)
+                    gmax = std::max(gmax, G[i+i*m]);
+
+                for(unsigned long j = (step == 0)? 1: bt; j < m && !rotate; ++j)
+                    for(unsigned long i = 0; i < ((step == 0)? j: bt) && !rotate; ++i)
+                    {
+                        const T g = std::abs(G[i+j*m]);
+                        rotate = (g > tol*std::sqrt(G[i+i*m]*G[j+j*m])) && (g > tol*m*gmax);
+                    }
+            }
+
+            if(rotate)
+            {
+                // [u_top u_bottom]*V' has orthogonal columns: rotate K*Q and Q by V'
+                m_ = static_cast<int>(d);
+                n_ = static_cast<int>(m);
+                ldvt = n_;
+
+                copy(tmp, u, d*m);
+                gesvd_(&jobu, &jobvt, &m_, &n_, tmp, &ld, s, tmp, &one, Vt, &ldvt, work, &lwork, &info);
+
+                if(info != 0)
+                    throw gException("SVD failed in eig_sm_jacobi");
+
+                // singular vectors come sorted by singular value: put them back in the order of the columns
+                // they are closest to, otherwise the method may stall swapping columns between blocks
+                for(unsigned long i = 0; i < m; ++i)
+                {
+                    unsigned long best = i;
+                    for(unsigned long k = i+1; k < m; ++k)
+                        if(std::abs(Vt[k+i*m]) > std::abs(Vt[best+i*m]))
+                            best = k;
+
+                    if(best != i)
+                        swap(m, Vt+i, m, Vt+best, m);
+                }
+
+                gemm(CblasNoTrans, CblasTrans, d, m, m, (T)1.0, u, d, Vt, m, (T)0.0, tmp, d);
+                std::swap(u, tmp);
+                gemm(CblasNoTrans, CblasTrans, d, m, m, (T)1.0, v, d, Vt, m, (T)0.0, tmp, d);
+                std::swap(v, tmp);
+
+                ++rotations;
+            }
+
+            if(numprocs == 1)
+                continue;
+
+            // round-robin tournament: top[0] stays, the other blocks move along
+            // top[1] -> top[2] -> ... -> top[p-1] -> bottom[p-1] -> ... -> bottom[0] -> top[1]
+            const int left = (myid > 0)? myid-1: MPI_PROC_NULL;
+            const int right = (myid < numprocs-1)? myid+1: MPI_PROC_NULL;
+
+            const unsigned long outRight = (myid == 0)? bb: bt;
+            const unsigned long outRightCol = (myid == 0)? bt: 0;
+            const unsigned long inTop = (myid > 0)? sizes[(myid == 1)? bottom[0]: top[myid-1]]: 0;
+            const unsigned long inBottom = (myid < numprocs-1)? sizes[bottom[myid+1]]: 0;
+
+            copy(sendBuffer, u+outRightCol*d, d*outRight);
+            copy(sendBuffer+d*outRight, v+outRightCol*d, d*outRight);
+            MPI_SendrecvT(sendBuffer, static_cast<int>(2*d*outRight), right, recvTop, static_cast<int>(2*d*inTop), left, 0, MPI_COMM_WORLD);
+
+            copy(sendBuffer, u+bt*d, d*bb);
+            copy(sendBuffer+d*bb, v+bt*d, d*bb);
+            MPI_SendrecvT(sendBuffer, static_cast<int>(2*d*bb), left, recvBottom, static_cast<int>(2*d*inBottom), right, 1, MPI_COMM_WORLD);
+
+            // new top: own top on process 0, the incoming one elsewhere;
+            // new bottom: own top on the last process, the incoming one elsewhere
+            const unsigned long newTop = (myid == 0)? bt: inTop;
+            const unsigned long newBottom = (myid == numprocs-1)? bt: inBottom;
+
+            for(int k = 0; k < 2; ++k)
+            {
+                T*& w = (k == 0)? u: v;
+                const unsigned long shift = (k == 0)? 0: 1;
+
+                if(myid == 0)
+                    copy(tmp, w, d*bt);
+                else
+                    copy(tmp, recvTop + shift*d*inTop, d*inTop);
+
+                if(myid == numprocs-1)
+                    copy(tmp+d*newTop, w, d*bt);
+                else
+                    copy(tmp+d*newTop, recvBottom + shift*d*inBottom, d*inBottom);
+
+                std::swap(w, tmp);
+            }
+
+            std::vector<int> nextTop(top), nextBottom(bottom);
+            nextTop[1] = bottom[0];
+            for(int k = 2; k < numprocs; ++k)
+                nextTop[k] = top[k-1];
+            for(int k = 0; k < numprocs-1; ++k)
+                nextBottom[k] = bottom[k+1];
+            nextBottom[numprocs-1] = top[numprocs-1];
+
+            top.swap(nextTop);
+            bottom.swap(nextBottom);
+
+            bt = newTop;
+            bb = newBottom;
+        }
+
+        unsigned long allRotations;
+        MPI_Allreduce(&rotations, &allRotations, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+
+        if(allRotations == 0)
+        {
+            converged = true;
+            break;
+        }
+    }
+
+    const unsigned long m = bt+bb;
+
+    Q.resize(d, m);
+    copy(Q.getData(), v, d*m);
+
+    L.resize(m, 1);
+    for(unsigned long j = 0; j < m; ++j)
+        L.getData()[j] = nrm2(static_cast<int>(d), u+j*d, 1);
+
+    delete [] u;
+    delete [] v;
+    delete [] tmp;
+    delete [] G;
+    delete [] s;
+    delete [] Vt;
+    delete [] work;
+    delete [] sendBuffer;
+    delete [] recvTop;
+    delete [] recvBottom;
+
+    // every process has seen the same rotation count, so they all throw
+    if(!converged)
+        throw gException("eig_sm_jacobi did not converge");
+
+    return sweep;
+}
+
+/**
+ * Distributed eigendecomposition of A - S, where A and S are d x d BigArrays and A - S is positive semidefinite,
+ * computed with eig_sm_jacobi. Every process reads only its own two blocks of columns of A and S.
+ * Eigenvalues are computed as column norms, so A - S must be positive semidefinite.
+ * \param A first matrix
+ * \param S matrix subtracted from A, may be NULL
+ * \param Q on output the eigenvectors held by the process
+ * \param L on output the corresponding eigenvalues
+ * \param maxSweeps maximum number of sweeps
+ * \return number of sweeps performed
+ */
+template<typename T>
+int eig_sm_jacobi(const BigArray<T>& A, const BigArray<T>* S, gMat2D<T>& Q, gMat2D<T>& L, const int maxSweeps = 30)
+{
+    const unsigned long d = A.rows();
+
+    if(A.cols() != d || (S != NULL && (S->rows() != d || S->cols() != d)))
+        throw gException(Exception_Inconsistent_Size);
+
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    unsigned long offsetTop, bt, offsetBottom, bb;
+    jacobiBlock(d, numprocs, myid, offsetTop, bt);
+    jacobiBlock(d, numprocs, 2*numprocs-1-myid, offsetBottom, bb);
+
+    gMat2D<T> U(d, bt+bb);
+    gMat2D<T> block;
+
+    A.getMatrixCollective(0, offsetTop, d, bt, block);
+    copy(U.getData(), block.getData(), d*bt);
+    A.getMatrixCollective(0, offsetBottom, d, bb, block);
+    copy(U.getData()+d*bt, block.getData(), d*bb);
+
+    if(S != NULL)
+    {
+        S->getMatrixCollective(0, offsetTop, d, bt, block);
+        axpy(d*bt, (T)-1.0, block.getData(), 1, U.getData(), 1);
+        S->getMatrixCollective(0, offsetBottom, d, bb, block);
+        axpy(d*bb, (T)-1.0, block.getData(), 1, U.getData()+d*bt, 1);
+    }
+
+    return eig_sm_jacobi(U, d, Q, L, maxSweeps);
+}
+
+/**
+ * Collects on every process the eigenvalues computed by eig_sm_jacobi
+ * \param L eigenvalues held by the process
+ * \param d order of the matrix
+ * \return array of all the d eigenvalues, to be freed with delete[]
+ */
+template<typename T>
+T* eig_sm_jacobi_values(const gMat2D<T>& L, const unsigned long d)
+{
+    int myid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    unsigned long m = L.getSize();
+    unsigned long offset = 0;
+    MPI_Exscan(&m, &offset, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if(myid == 0)
+        offset = 0;
+
+    T* local = new T[d];
+    set(local, (T)0.0, d);
+    copy(local+offset, L.getData(), m);
+
+    T* values = new T[d];
+    MPI_AllReduceT(local, values, d, MPI_SUM, MPI_COMM_WORLD);
+
+    delete [] local;
+
+    return values;
+}
+
 }
 
 #endif // _GURLS_BIGMATH_H_
@@ -43,10 +43,17 @@
 #ifndef _GURLS_BIGRLSPEGASOS_H_
 #define _GURLS_BIGRLSPEGASOS_H_
 
+#include "gurls++/optmatrix.h"
+#include "gurls++/optfunction.h"
 #include "bgurls++/bigarray.h"
 #include "bgurls++/bigoptimization.h"
+#include "bgurls++/bigmath.h"
+#include "bgurls++/bigpred_primal.h"
+#include "bgurls++/bigperf.h"
 #include "gurls++/utils.h"
 
+#include <vector>
+
 
 namespace gurls {
 
@@ -65,34 +72,288 @@ public:
      * The regularization parameter is set to the one found in the field paramsel of opt.
      * In case of multiclass problems, the regularizers need to be combined with the function specified inthe field singlelambda of opt
      *
+     * Each process streams its own block of rows of X and Y from disk in chunks of syncperiod*batchsize rows
+     * (fewer if the chunk does not fit in memlimit), runs mini-batch pegasos on each chunk and then averages
+     * its model with the ones of the other processes.
+     *
      * \param X input data bigarray
      * \param Y labels bigarray
      * \param opt options with the following:
      *  - singlelambda (default)
      *  - epochs (default)
+     *  - batchsize (default)
+     *  - hogwild (default)
+     *  - syncperiod (default)
+     *  - testperiod (default)
+     *  - memlimit (default)
      *  - paramsel (settable with the class ParamSelection and its subclasses)
-     *  - Xte (test input data matrix, needed for accuracy evaluation)
-     *  - yte (test labels matrix, needed for accuracy evaluation)
+     *  - files list containing file names for BigArrays
+     *  - Xte (test input data bigarray, needed for accuracy evaluation)
+     *  - yte (test labels bigarray, needed for accuracy evaluation)
      *
      * \return returns a list containing the following fields:
      *  - W = matrix of coefficient vectors of rls estimator for each class
+     *  - W_last = model computed in the last iteration
      *  - W_sum = sum of the classifiers across iterations
      *  - t0 = stepsize parameter
      *  - count = number of iterations
-     *  - acc_last = accuracy of the solution computed in the last iteration
-     *  - acc_avg = average accuracy across iterations
+     *  - acc_last = accuracy of the solution computed in the last iteration, evaluated every testperiod model averages
+     *  - acc_avg = accuracy of the averaged solution, evaluated every testperiod model averages
+     *  - C = empty matrix
+     *  - X = empty matrix
      *
      */
     GurlsOptionsList* execute(const BigArray<T>& X, const BigArray<T>& Y, const GurlsOptionsList &opt);
+
+protected:
+    /**
+     * Evaluates the mean macro averaged accuracy of the linear classifier W on the test set Xte, yte
+     */
+    T testAccuracy(const T* W, BigArray<T>& bW, const BigArray<T>& Xte, const BigArray<T>& yte, GurlsOptionsList& nestedOpt);
 };
 
 
 template <typename T>
-GurlsOptionsList* BigRLSPegasos<T>::execute(const BigArray<T>& /*X*/, const BigArray<T>& /*Y*/, const GurlsOptionsList& /*opt*/)
+GurlsOptionsList* BigRLSPegasos<T>::execute(const BigArray<T>& X, const BigArray<T>& Y, const GurlsOptionsList& opt)
+{
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    //	lambda = opt.singlelambda(opt.paramsel.lambdas);
+    const gMat2D<T> &ll = opt.getOptValue<OptMatrix<gMat2D<T> > >("paramsel.lambdas");
+    const T lambda = opt.getOptAs<OptFunction>("singlelambda")->getValue(ll.getData(), ll.getSize());
+
+    const unsigned long n = X.rows();
+    const unsigned long d = X.cols();
+    const unsigned long t = Y.cols();
+
+    if(Y.rows() != n)
+        throw gException(Exception_Inconsistent_Size);
+
+    const unsigned long epochs = static_cast<unsigned long>(opt.getOptAsNumber("epochs"));
+    const unsigned long batchsize = std::max(1ul, static_cast<unsigned long>(opt.getOptAsNumber("batchsize")));
+    const unsigned long syncperiod = std::max(1ul, static_cast<unsigned long>(opt.getOptAsNumber("syncperiod")));
+    const unsigned long testperiod = static_cast<unsigned long>(opt.getOptAsNumber("testperiod"));
+    const bool hogwild = opt.getOptAsNumber("hogwild") > 0;
+
+    // rows owned by this process
+    const unsigned long blockSize = n/numprocs;
+    const unsigned long remainder = (myid == numprocs-1)? (n%numprocs): 0;
+    const unsigned long blockRows = blockSize + remainder;
+    const unsigned long firstRow = myid*blockSize;
+
+    // a chunk is read from disk and processed between two model averages
+    const unsigned long cells = static_cast<unsigned long>(opt.getOptAsNumber("memlimit")/sizeof(T));
+    const unsigned long W_size = d*t;
+
+    if(cells < 4*W_size + batchsize*(d+2*t))
+        throw gException("Not enough memory available to complete the operation");
+
+    const unsigned long maxChunkRows = (cells - 4*W_size)/(d+2*t);
+    const unsigned long chunkRows = std::max(1ul, std::min(std::min(syncperiod*batchsize, maxChunkRows), blockRows));
+    unsigned long numChunks = (blockRows + chunkRows - 1)/chunkRows;
+
+    // every process takes part in the same number of averages
+    unsigned long rounds;
+    MPI_Allreduce(&numChunks, &rounds, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
+
+    //	opt.cfr.t0 = ceil(norm(X(1,:))/sqrt(opt.singlelambda(opt.paramsel.lambdas)));
+    gMat2D<T> x0;
+    X.getMatrix(0, 0, 1, d, x0);
+    const T t0 = std::max((T)1.0, static_cast<T>(ceil(nrm2(d, x0.getData(), 1)/sqrt(lambda))));
+
+
+    const bool test = (testperiod > 0) && opt.hasOpt("Xte") && opt.hasOpt("yte");
+
+    //	opt.cfr.W = zeros(d,T);
+    //	opt.cfr.W_sum = zeros(d,T);
+    //	opt.cfr.count = 0;
+    T* W = new T[W_size+1];
+    T* W_sum = new T[W_size+1];
+    T* reduced = new T[W_size+1];
+    set(W, (T)0.0, W_size+1);
+    set(W_sum, (T)0.0, W_size+1);
+
+    unsigned long count = 0;
+
+    BigArray<T>* bW = new BigArray<T>(opt.getOptAsString("files.optimizer_W_filename"), d, t);
+
+    GurlsOptionsList* nestedOpt = NULL;
+    std::vector<T> acc_last, acc_avg;
+
+    if(test)
+    {
+        nestedOpt = new GurlsOptionsList("nested");
+        nestedOpt->copyOpt("nb_pred", opt);
+        nestedOpt->copyOpt("files", opt);
+        nestedOpt->copyOpt("tmpfile", opt);
+        nestedOpt->copyOpt("memlimit", opt);
+
+        GurlsOptionsList* optimizer = new GurlsOptionsList("optimizer");
+        optimizer->addOpt("W", new OptMatrix<BigArray<T> >(*(new BigArray<T>(*bW))));
+        nestedOpt->addOpt("optimizer", optimizer);
+    }
+
+    gMat2D<T> Xc, Yc;
+    unsigned long* chunkOrder = new unsigned long[std::max(1ul, numChunks)];
+    unsigned long round = 0;
+
+    //	for i = 1:opt.epochs,
+    for(unsigned long e = 0; e < epochs; ++e)
+    {
+        //	blockOrder = randperm(nBlocks);
+        randperm(numChunks, chunkOrder, true, 0);
+
+        for(unsigned long r = 0; r < rounds; ++r)
+        {
+            unsigned long updates = 0;
+
+            if(r < numChunks)
+            {
+                const unsigned long offset = chunkOrder[r]*chunkRows;
+                const unsigned long rows = std::min(chunkRows, blockRows-offset);
+
+                X.getMatrix(firstRow+offset, 0, rows, d, Xc);
+                Y.getMatrix(firstRow+offset, 0, rows, t, Yc);
+
+                //	opt.cfr = bigrls_pegasos_singlepass(tX', tbY, opt);
+                const unsigned long prev = count;
+                rls_pegasos_batch_driver(Xc.getData(), Yc.getData(), rows, d, t, lambda, t0, batchsize, 1ul, hogwild, W, W_sum, count);
+                updates = count - prev;
+            }
+
+            // W = sum_p(updates_p*W_p)/sum_p(updates_p)
+            scal(W_size, (T)updates, W, 1);
+            W[W_size] = (T)updates;
+
+            MPI_AllReduceT(W, reduced, W_size+1, MPI_SUM, MPI_COMM_WORLD);
+
+            if(gt(reduced[W_size], (T)0.0))
+            {
+                copy(W, reduced, W_size);
+                scal(W_size, ((T)1.0)/reduced[W_size], W, 1);
+            }
+            else
+                set(W, (T)0.0, W_size);
+
+            ++round;
+
+            if(test && (round % testperiod == 0))
+            {
+                const BigArray<T>& Xte = opt.getOptValue<OptMatrix<BigArray<T> > >("Xte");
+                const BigArray<T>& yte = opt.getOptValue<OptMatrix<BigArray<T> > >("yte");
+
+                acc_last.push_back(testAccuracy(W, *bW, Xte, yte, *nestedOpt));
+
+                W_sum[W_size] = (T)count;
+                MPI_AllReduceT(W_sum, reduced, W_size+1, MPI_SUM, MPI_COMM_WORLD);
+                scal(W_size, ((T)1.0)/std::max(reduced[W_size], (T)1.0), reduced, 1);
+
+                acc_avg.push_back(testAccuracy(reduced, *bW, Xte, yte, *nestedOpt));
+            }
+        }
+    }
+
+    delete [] chunkOrder;
+    delete nestedOpt;
+
+    //	cfr.W = opt.cfr.W_sum/opt.cfr.count;
+    W_sum[W_size] = (T)count;
+    MPI_AllReduceT(W_sum, reduced, W_size+1, MPI_SUM, MPI_COMM_WORLD);
+    delete [] W_sum;
+
+    const T totalCount = reduced[W_size];
+    if(eq(totalCount, (T)0.0))
+    {
+        delete [] W;
+        delete [] reduced;
+        delete bW;
+        throw gException(Exception_Illegal_Argument_Value);
+    }
+
+    if(myid == 0)
+    {
+        T* W_avg = new T[W_size];
+        copy(W_avg, reduced, W_size);
+        scal(W_size, ((T)1.0)/totalCount, W_avg, 1);
+        bW->setMatrix(0, 0, W_avg, d, t);
+        delete [] W_avg;
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+
+    GurlsOptionsList* optimizer = new GurlsOptionsList("optimizer");
+
+    optimizer->addOpt("W", new OptMatrix<BigArray<T> >(*bW));
+
+    gMat2D<T>* W_last = new gMat2D<T>(d, t);
+    copy(W_last->getData(), W, W_size);
+    optimizer->addOpt("W_last", new OptMatrix<gMat2D<T> >(*W_last));
+    delete [] W;
+
+    gMat2D<T>* W_sum_mat = new gMat2D<T>(d, t);
+    copy(W_sum_mat->getData(), reduced, W_size);
+    optimizer->addOpt("W_sum", new OptMatrix<gMat2D<T> >(*W_sum_mat));
+    delete [] reduced;
+
+    optimizer->addOpt("count", new OptNumber(totalCount));
+    optimizer->addOpt("t0", new OptNumber(t0));
+
+    if(test)
+    {
+        gMat2D<T>* acc_last_mat = new gMat2D<T>(1, acc_last.size());
+        copy(acc_last_mat->getData(), &(*acc_last.begin()), acc_last.size());
+        optimizer->addOpt("acc_last", new OptMatrix<gMat2D<T> >(*acc_last_mat));
+
+        gMat2D<T>* acc_avg_mat = new gMat2D<T>(1, acc_avg.size());
+        copy(acc_avg_mat->getData(), &(*acc_avg.begin()), acc_avg.size());
+        optimizer->addOpt("acc_avg", new OptMatrix<gMat2D<T> >(*acc_avg_mat));
+    }
+
+    BigArray<T>* emptyC = new BigArray<T>();
+    optimizer->addOpt("C", new OptMatrix<BigArray<T> >(*emptyC));
+
+    //	cfr.X = [];
+    BigArray<T>* emptyX = new BigArray<T>();
+    optimizer->addOpt("X", new OptMatrix<BigArray<T> >(*emptyX));
+
+    return optimizer;
+}
+
+template <typename T>
+T BigRLSPegasos<T>::testAccuracy(const T* W, BigArray<T>& bW, const BigArray<T>& Xte, const BigArray<T>& yte, GurlsOptionsList& nestedOpt)
 {
-    // TODO
+    int myid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    //	opt.rls.W = W;
+    if(myid == 0)
+        bW.setMatrix(0, 0, W, bW.rows(), bW.cols());
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    //	opt.pred = bigpred_primal(opt.Xte, opt.yte, opt);
+    BigPredPrimal<T> primal;
+    nestedOpt.removeOpt("pred");
+    nestedOpt.addOpt("pred", primal.execute(Xte, yte, nestedOpt));
+
+    //	opt.perf = bigperf_macroavg(opt.Xte, opt.yte, opt);
+    BigPerformance<T>* perfClass = BigPerformance<T>::factory("macroavg");
+    GurlsOptionsList* perf = perfClass->execute(Xte, yte, nestedOpt);
+    delete perfClass;
+
+    //	acc = mean([opt.perf.acc]);
+    const gMat2D<T>& acc = perf->getOptValue<OptMatrix<gMat2D<T> > >("acc");
+
+    T res;
+    mean(acc.getData(), &res, acc.getSize(), 1, 1);
+
+    delete perf;
 
-    return new GurlsOptionsList("optimizer");
+    return res;
 }
 
 }
@@ -75,6 +75,9 @@ public:
     *  - files list containing file names for BigArrays
     *  - tmpfile path of a file used to store and load temporary data
     *  - memlimit maximum amount memory to be used performing matrix multiplications
+    *  - atb_reduction, atb_schedule (default) distribution of the X\'X and X\'y products, see matMult_AtB
+    *  - gram_solver (default) "root" to solve the d x d system on process 0,
+    *    "jacobi" to distribute it over all processes (see eig_sm_jacobi), "auto" for jacobi with more than one process
     *
     * BigArray Multiplications are performed in parallel
     *
@@ -97,13 +100,13 @@ GurlsOptionsList* BigRLSPrimal<T>::execute(const BigArray<T>& X, const BigArray<
 
     //	K = X'*X;
     if(!opt.hasOpt("paramsel.XtX"))
-        bK = matMult_AtB(X, X, opt.getOptAsString("files.XtX_filename"));
+        bK = matMult_AtB(X, X, opt.getOptAsString("files.XtX_filename"), atbReduction(opt), atbSchedule(opt));
     else
         bK = &opt.getOptValue<OptMatrix<BigArray<T> > >("paramsel.XtX");
 
     //	Xty = X'*y;
     if(!opt.hasOpt("paramsel.Xty"))
-        bXty = matMult_AtB(X, Y, opt.getOptAsString("files.Xty_filename"));
+        bXty = matMult_AtB(X, Y, opt.getOptAsString("files.Xty_filename"), atbReduction(opt), atbSchedule(opt));
     else
         bXty = &opt.getOptValue<OptMatrix<BigArray<T> > >("paramsel.Xty");
 
@@ -113,7 +116,50 @@ GurlsOptionsList* BigRLSPrimal<T>::execute(const BigArray<T>& X, const BigArray<
 
     BigArray<T>* W = new BigArray<T>(opt.getOptAsString("files.optimizer_W_filename"), d, t);
 
-    if(myid == 0)
+    if(distributedGramSolver(opt))
+    {
+        const gMat2D<T> &ll = opt.getOptValue<OptMatrix<gMat2D<T> > >("paramsel.lambdas");
+        T lambda = opt.getOptAs<OptFunction>("singlelambda")->getValue(ll.getData(), ll.getSize());
+
+        //	[Q,L] = eig(K);
+        gMat2D<T> Q, L;
+        eig_sm_jacobi(*bK, static_cast<const BigArray<T>*>(NULL), Q, L);
+
+        gMat2D<T> Xty;
+        bXty->getMatrixCollective(0, 0, bXty->rows(), bXty->cols(), Xty);
+
+        // W = Q*inv(L + n*lambda)*Q'*Xty is the sum of the contributions of the eigenpairs of each process
+        const unsigned long m = L.getSize();
+
+        T* W_local = new T[d*t];
+        set(W_local, (T)0.0, d*t);
+
+        if(m > 0)
+        {
+            T* QtXtY = new T[m*t];
+            dot(Q.getData(), Xty.getData(), QtXtY, d, m, d, t, m, t, CblasTrans, CblasNoTrans, CblasColMajor);
+
+            T* work = new T[(d+1)*m];
+            rls_eigen(Q.getData(), L.getData(), QtXtY, W_local, lambda, n, d, m, m, m, t, work);
+
+            delete [] work;
+            delete [] QtXtY;
+        }
+
+        T* W_mat = NULL;
+        if(myid == 0)
+            W_mat = new T[d*t];
+
+        MPI_ReduceT(W_local, W_mat, d*t, MPI_SUM, 0, MPI_COMM_WORLD);
+        delete [] W_local;
+
+        if(myid == 0)
+        {
+            W->setMatrix(0, 0, W_mat, d, t);
+            delete [] W_mat;
+        }
+    }
+    else if(myid == 0)
     {
         gMat2D<T> K, Xty;
         bK->getMatrix(0, 0, bK->rows(), bK->cols(), K);
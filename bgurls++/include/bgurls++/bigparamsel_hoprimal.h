@@ -47,7 +47,6 @@
 #include "bgurls++/bigparamsel.h"
 #include "gurls++/optmatrix.h"
 #include "bgurls++/bigmath.h"
-#include "bgurls++/bigpred_primal.h"
 #include "bgurls++/bigperf.h"
 
 
@@ -72,14 +71,21 @@ public:
      * \param Y labels bigarray
      * \param opt options with the following:
      *  - nlambda (default)
-     *  - hoperf (default)
+     *  - hoperf (default, only macroavg is supported)
+     *  - nb_pred (default)
      *  - smallnumber (default)
      *  - split (settable with the class Split and its subclasses)
      *  - files list containing file names for BigArrays
      *  - tmpfile path of a file used to store and load temporary data
      *  - memlimit maximum amount memory to be used performing matrix multiplications
+     *  - atb_reduction, atb_schedule (default) distribution of the X\'X and X\'y products, see matMult_AtB
      *
-     * BigArray multiplications and subtasks calls are executed in parallel
+     *  - gram_solver (default) "root" to diagonalize the d x d system on process 0,
+     *    "jacobi" to distribute it over all processes (see eig_sm_jacobi), "auto" for jacobi with more than one process
+     *
+     * BigArray multiplications are executed in parallel. The classifiers for all the lambda guesses are
+     * broadcast at once and every process reads its block of Xva once, computing the predictions and the
+     * validation performance for all the guesses in memory.
      *
      * \return a GurlsOptionList with the following fields:
      *  - lambdas = array of values of the regularization parameter lambda minimizing the validation error for each class
@@ -104,14 +110,29 @@ GurlsOptionsList *BigParamSelHoPrimal<T>::execute(const BigArray<T> &X, const Bi
     const BigArray<T>& XvatXva = split->getOptValue<OptMatrix<BigArray<T> > >("XvatXva");
     const BigArray<T>& Xvatyva = split->getOptValue<OptMatrix<BigArray<T> > >("XvatYva");
 
-    BigArray<T>* XtX = matMult_AtB(X, X, opt.getOptAsString("files.XtX_filename"));
-    BigArray<T>* Xty = matMult_AtB(X, Y, opt.getOptAsString("files.Xty_filename"));
+    BigArray<T>* XtX = matMult_AtB(X, X, opt.getOptAsString("files.XtX_filename"), atbReduction(opt), atbSchedule(opt));
+    BigArray<T>* Xty = matMult_AtB(X, Y, opt.getOptAsString("files.Xty_filename"), atbReduction(opt), atbSchedule(opt));
+
 
+    // with the distributed solver every process diagonalizes K = XtX - XvatXva together,
+    // otherwise process 0 alone
+    const bool distributed = distributedGramSolver(opt);
 
     gMat2D<T>* XtX_mat = NULL;
     gMat2D<T>* Xty_mat = NULL;
 
-    if(myid == 0)
+    if(distributed)
+    {
+//        Xty = Xty - Xvatyva;
+        Xty_mat = new gMat2D<T>;
+        Xty->getMatrixCollective(0, 0, Xty->rows(), Xty->cols(), *Xty_mat);
+
+        gMat2D<T> Xvatyva_mat;
+        Xvatyva.getMatrixCollective(0, 0, Xvatyva.rows(), Xvatyva.cols(), Xvatyva_mat);
+
+        axpy(Xty_mat->getSize(), (T)-1.0, Xvatyva_mat.getData(), 1, Xty_mat->getData(), 1);
+    }
+    else if(myid == 0)
     {
 //        K = XtX - XvatXva;
         XtX_mat = new gMat2D<T>(XtX->rows(), XtX->cols());
@@ -146,9 +167,36 @@ GurlsOptionsList *BigParamSelHoPrimal<T>::execute(const BigArray<T> &X, const Bi
     T *L = NULL;
     T* QtXtY = NULL;
 
+    // number of eigenpairs held by the process
+    unsigned long m = d;
+    gMat2D<T> Q_local, L_local;
+
     gMat2D<T>* guesses_mat = new gMat2D<T>(1, tot);
 
-    if(myid == 0)
+    if(distributed)
+    {
+        //	[Q,L] = eig(K);
+        eig_sm_jacobi(*XtX, &XvatXva, Q_local, L_local);
+
+        m = L_local.getSize();
+        Q = Q_local.getData();
+        L = L_local.getData();
+
+        //	QtXtY = Q'*Xty;
+        QtXtY = new T[m*t];
+        if(m > 0)
+            dot(Q, Xty_mat->getData(), QtXtY, d, m, d, t, m, t, CblasTrans, CblasNoTrans, CblasColMajor);
+
+        delete Xty_mat;
+
+        //	guesses = paramsel_lambdaguesses(L, min(n,d), n, opt);
+        T* allL = eig_sm_jacobi_values(L_local, d);
+        T* guesses = lambdaguesses(allL, d, std::min(d, n), n, tot, (T)(opt.getOptAsNumber("smallnumber")));
+        copy(guesses_mat->getData(), guesses, tot);
+        delete[] guesses;
+        delete[] allL;
+    }
+    else if(myid == 0)
     {
         //	[Q,L] = eig(K);
         Q = XtX_mat->getData();
@@ -172,76 +220,144 @@ GurlsOptionsList *BigParamSelHoPrimal<T>::execute(const BigArray<T> &X, const Bi
     MPI_BcastT<T>(guesses, tot, 0, MPI_COMM_WORLD);
 
 
-//	ap = zeros(tot,T);
-    gMat2D<T>* ap_mat = new gMat2D<T>(tot, t);
-    T* ap = ap_mat->getData();
-    set(ap, (T)0.0, tot*t);
+    if(opt.getOptAsString("hoperf") != "macroavg")
+        throw BadPerformanceCreation(opt.getOptAsString("hoperf"));
 
+    const unsigned long Wt = d*t*tot;
 
-    GurlsOptionsList* nestedOpt = new GurlsOptionsList("nested");
-    nestedOpt->copyOpt("nb_pred", opt);
-    nestedOpt->copyOpt("files", opt);
-    nestedOpt->copyOpt("tmpfile", opt);
-    nestedOpt->copyOpt("memlimit", opt);
+//    for i = 1:tot
+//        opt.rls.W = rls_eigen(Q,L,QtXtY,guesses(i),n);
+    T* W_all = new T[Wt];
 
-    GurlsOptionsList* optimizer = new GurlsOptionsList("optimizer");
-    nestedOpt->addOpt("optimizer",optimizer);
+    if(distributed)
+    {
+        // W = Q*inv(L + n*lambda)*Q'*Xty is the sum of the contributions of the eigenpairs of each process
+        T* W_local = new T[Wt];
+        set(W_local, (T)0.0, Wt);
 
-    T* work = NULL;
-    gMat2D<T> *W_mat = NULL;
+        if(m > 0)
+        {
+            T* work = new T[(d+1)*m];
 
-    if(myid == 0)
-    {
-        work = new T[d*(d+1)];
-        W_mat = new gMat2D<T>(d, t);
-    }
+            for(int i=0; i<tot; ++i)
+                rls_eigen(Q, L, QtXtY, W_local + i*d*t, guesses[i], n, d, m, m, m, t, work);
 
-    BigArray<T>* W = new BigArray<T>(opt.getOptAsString("files.optimizer_W_filename"), d, t);
-    optimizer->addOpt("W", new OptMatrix<BigArray<T> >(*W));
+            delete [] work;
+        }
 
-    BigPredPrimal< T > primal;
-    BigPerformance<T>* perfClass = BigPerformance<T>::factory(opt.getOptAsString("hoperf"));
+        delete [] QtXtY;
 
-    for(int i=0; i<tot; ++i)
+        MPI_AllReduceT(W_local, W_all, Wt, MPI_SUM, MPI_COMM_WORLD);
+        delete [] W_local;
+    }
+    else
     {
         if(myid == 0)
         {
-//        opt.rls.W = rls_eigen(Q,L,QtXtY,guesses(i),n);
-            rls_eigen(Q, L, QtXtY, W_mat->getData(), guesses[i], n, d, d, d, d, t, work);
-            W->setMatrix(0, 0, *W_mat);
+            T* work = new T[d*(d+1)];
+
+            for(int i=0; i<tot; ++i)
+                rls_eigen(Q, L, QtXtY, W_all + i*d*t, guesses[i], n, d, d, d, d, t, work);
+
+            delete [] work;
+            delete XtX_mat;
+            delete [] L;
+            delete [] QtXtY;
         }
 
-        MPI_Barrier(MPI_COMM_WORLD);
+        MPI_BcastT(W_all, Wt, 0, MPI_COMM_WORLD);
+    }
 
-//        opt.pred = bigpred_primal(Xva,yva,opt);
-        nestedOpt->removeOpt("pred");
-        GurlsOptionsList *ret_pred = primal.execute(Xva, Yva, *nestedOpt);
 
-        nestedOpt->addOpt("pred", ret_pred);
+    // block of validation rows owned by this process, read in chunks fitting in memlimit
+    int numprocs;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
 
-//		opt.perf = opt.hoperf(Xva,yva,opt);
-        GurlsOptionsList* ret_perf = perfClass->execute(Xva, Yva, *nestedOpt);
+    const unsigned long nva = Xva.rows();
+    const unsigned long blockSize = nva/numprocs;
+    const unsigned long blockRows = blockSize + ((myid == numprocs-1)? (nva%numprocs): 0);
+    const unsigned long firstRow = myid*blockSize;
 
-        gMat2D<T> &forho_vec = ret_perf->getOptValue<OptMatrix<gMat2D<T> > >("forho");
+    const unsigned long cells = static_cast<unsigned long>(opt.getOptAsNumber("memlimit")/sizeof(T));
+    // two chunks of Xva and Yva are held by the iterator while the next one is read
+    const unsigned long rowCells = 2*(d + t) + t*tot;
 
-        copy(ap+i, forho_vec.getData(), t, tot, 1);
+    if(cells < Wt + rowCells)
+        throw gException("Not enough memory available to complete the operation");
 
-        delete ret_perf;
+    const unsigned long chunkRows = std::max(1ul, std::min((cells - Wt)/rowCells, blockSize + nva%numprocs));
 
-    }
+    const unsigned long nb_pred = static_cast<unsigned long>(opt.getOptAsNumber("nb_pred"));
+
+//    n_class = zeros(1,T);
+//    flatcost = zeros(tot,T);
+    T* stats = new T[(tot+1)*t];
+    set(stats, (T)0.0, (tot+1)*t);
+    T* nClass = stats + tot*t;
 
-    delete nestedOpt;
-    delete perfClass;
+    T* pred = new T[chunkRows*t*tot];
 
-    if(myid ==0)
+    BigArrayRowIterator<T> it(Xva, &Yva, firstRow, blockRows, chunkRows);
+
+    while(it.next())
     {
-        delete W_mat;
-        delete [] work;
-        delete XtX_mat;
-        delete [] L;
-        delete [] QtXtY;
+        const unsigned long rows = it.rows();
+
+        if(rows == 0)
+            continue;
+
+//        opt.pred = bigpred_primal(Xva,yva,opt);  for all the guesses at once
+        dot(it.blockA(), W_all, pred, rows, d, d, t*tot, rows, t*tot, CblasNoTrans, CblasNoTrans, CblasColMajor);
+
+//		opt.perf = opt.hoperf(Xva,yva,opt);
+        const T* y = it.blockB();
+
+        for(unsigned long j = 0; j < rows; ++j)
+        {
+//            [dummy,IY]= max(y_block,[],2);
+            unsigned long IY = 0;
+            for(unsigned long c = 1; c < t; ++c)
+                if(gt(y[j+c*rows], y[j+IY*rows]))
+                    IY = c;
+
+//            n_class(IY(i)) = n_class(IY(i)) + 1;
+            ++nClass[IY];
+
+//            flatcost(IY(i)) = flatcost(IY(i)) + ismember(IY(i),IYpred(i,1:nb_pred));
+            for(int i = 0; i < tot; ++i)
+            {
+                const T* p = pred + i*rows*t + j;
+                const T value = p[IY*rows];
+
+                // IY is among the nb_pred largest scores if less than nb_pred scores are larger
+                unsigned long larger = 0;
+                for(unsigned long c = 0; c < t && larger < nb_pred; ++c)
+                    if(gt(p[c*rows], value))
+                        ++larger;
+
+                if(larger < nb_pred)
+                    ++stats[i+IY*tot];
+            }
+        }
     }
 
+    delete [] pred;
+    delete [] W_all;
+
+    T* allStats = new T[(tot+1)*t];
+    MPI_AllReduceT(stats, allStats, (tot+1)*t, MPI_SUM, MPI_COMM_WORLD);
+    delete [] stats;
+
+//	ap = flatcost./n_class;
+    gMat2D<T>* ap_mat = new gMat2D<T>(tot, t);
+    T* ap = ap_mat->getData();
+
+    for(unsigned long c = 0; c < t; ++c)
+        for(int i = 0; i < tot; ++i)
+            ap[i+c*tot] = allStats[i+c*tot]/allStats[tot*t+c];
+
+    delete [] allStats;
+
 
     GurlsOptionsList* paramsel;
 
@@ -267,7 +383,7 @@ GurlsOptionsList *BigParamSelHoPrimal<T>::execute(const BigArray<T> &X, const Bi
 
 
 //    [dummy,idx] = max(ap,[],1);
-    work = NULL;
+    T* work = NULL;
     unsigned long* idx = new unsigned long[t];
     indicesOfMax(ap, tot, t, idx, work, 1);
 
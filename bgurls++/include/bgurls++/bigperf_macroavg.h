@@ -71,8 +71,10 @@ public:
      * \param opt options with the following:
      *  - pred (settable with the class Prediction and its subclasses)
      *  - nb_pred
+     *  - memlimit maximum amount memory to be used by each process: Y and pred are read in chunks of rows
      *
-     * This task parallelizes the costs computation
+     * This task parallelizes the costs computation. A sample counts as correctly classified if its class is
+     * among the nb_pred largest predictions, ties broken by class index; predictions are never sorted
      *
      * \return a GurslOptionList equal to the field pred of opt, with the following fields added or substituted:
      *  - acc = array of prediction accuracy for each class
@@ -134,52 +136,53 @@ GurlsOptionsList* BigPerfMacroAvg<T>::execute(const BigArray<T>& /*X*/, const Bi
 
     const unsigned long block_rows = blockSize + remainder;
 
+    // the block of rows of y and pred is streamed in chunks: two buffers of readRows*2t cells
+    // and three vectors of readRows elements, besides the 4t cells of the counters
+    const unsigned long cells = static_cast<unsigned long>(opt.getOptAsNumber("memlimit")/sizeof(T));
+    const unsigned long reserved = 4*t;
+    const unsigned long rowCells = 4*t + 3;
 
-    gMat2D<T> *y_block = new gMat2D<T>(block_rows, t);
-    gMat2D<T> *ypred_block = new gMat2D<T>(block_rows, t);
+    if(cells < reserved + rowCells)
+        throw gException("Not enough memory available to complete the operation");
 
-//        y_block = y(i1 : i2, : );
-    Y.getMatrix(myid*blockSize, 0, *y_block);
+    const unsigned long readRows = std::min((cells - reserved)/rowCells, std::max(block_rows, 1ul));
 
-//        ypred_block = opt.pred(i1 : i2, : );
-    pred.getMatrix(myid*blockSize, 0, *ypred_block);
+    unsigned long* IY = new unsigned long[readRows];
+    unsigned long* ranks = new unsigned long[readRows];
+    T* work = new T[readRows];
 
-    T* work = new T[y_block->getSize()];
+    {
+        BigArrayRowIterator<T> it(Y, &pred, myid*blockSize, block_rows, readRows);
+
+        while(it.next())
+        {
+            const unsigned long rows = it.rows();
 
 //        [dummy,IY]= max(y_block,[],2);
-    unsigned long* IY = new unsigned long[y_block->rows()];
-    indicesOfMax(y_block->getData(), (int)(y_block->rows()), (int)(y_block->cols()), IY, work, 2);
-    delete[] work;
+            rowIndicesOfMax(it.blockA(), rows, t, IY, work);
 
 //        [dummy,IYpred]= sort(ypred_block,2,'descend');
-    unsigned long* IYpred = new unsigned long[y_block->getSize()];
-    delete y_block;
-
-    T* values = NULL;
-    sort(ypred_block->getData(), ypred_block->rows(), ypred_block->cols(), &gte<T>, values, IYpred);
-    delete ypred_block;
+            // IY(i) is among IYpred(i,1:nb_pred) iff fewer than nb_pred predictions of row i precede it
+            rowRanks(it.blockB(), rows, t, IY, ranks, work);
 
 //        for i=1:size(y_block,1)
-    for(unsigned long i=0; i< block_rows; ++i)
-    {
-        const unsigned long index = IY[i];
+            for(unsigned long i=0; i< rows; ++i)
+            {
+                const unsigned long index = IY[i];
 
 //            flatcost(IY(i)) = flatcost(IY(i)) + ismember(IY(i),IYpred(i,1:nb_pred));
-        const unsigned long value = IY[i];
-        for(unsigned long j=0; j<nb_pred; ++j)
-        {
-            if(IYpred[i+(block_rows*j)] == value)
-            {
-                ++flatCost[index];
-                break;
-            }
-        }
+                if(ranks[i] < nb_pred)
+                    ++flatCost[index];
 
 //            n_class(IY(i)) = n_class(IY(i)) + 1;
-        ++nClass[index];
+                ++nClass[index];
+            }
+        }
     }
 
-    delete[] IYpred;
+    delete[] IY;
+    delete[] ranks;
+    delete[] work;
 
     T* allNClass = new T[t];
     MPI_AllReduceT(nClass, allNClass, t, MPI_SUM, MPI_COMM_WORLD);
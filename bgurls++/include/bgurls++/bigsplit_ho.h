@@ -52,6 +52,8 @@
 
 #include <boost/filesystem.hpp>
 
+#include <algorithm>
+
 namespace gurls
 {
 
@@ -71,7 +73,9 @@ public:
      * \param opt options with the following field
      *   - hoproportion (default)
      *   - files list containing file names for BigArrays
-     *   - memlimit maximum amount memory to be used performing matrix multiplications
+     *   - memlimit maximum amount memory to be used by each process: X and Y are streamed in chunks of rows
+     *     while the validation rows are written and XvatXva, XvatYva accumulated
+     *   - atb_reduction (default)
      *
      * \return a list containing the following fields:
      *  - Xva
@@ -209,50 +213,109 @@ GurlsOptionsList* BigSplitHo<T>::execute(const BigArray<T>& X, const BigArray<T>
     const unsigned long numRows = n/numprocs;
     const unsigned long remainder = (myid == numprocs-1)? (n%numprocs) : 0;
     const unsigned long lastRows = numRows+remainder;
+    const unsigned long firstRow = numRows*myid;
+
+    // validation rows of this process, chosen up front and sorted so that they are met in order while streaming
+    const unsigned long lastBlockRows = static_cast<unsigned long>(lastRows*hoProportion);
+
+    unsigned long* indices = new unsigned long[std::max(lastRows, 1ul)];
+    randperm(lastRows, indices, true, 0);
+    std::sort(indices, indices+lastBlockRows);
 
+    unsigned long begin = 0;
+    MPI_Exscan(&lastBlockRows, &begin, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
+    if(myid == 0)
+        begin = 0;
+
+    unsigned long rows;
+    MPI_Allreduce(&lastBlockRows, &rows, 1, MPI_UNSIGNED_LONG, MPI_SUM, MPI_COMM_WORLD);
 
-    const unsigned long rows = static_cast<unsigned long>(n*hoProportion);
     BigArray<T>* Xva = new BigArray<T>(opt.getOptAsString("files.Xva_filename"), rows, d);
     BigArray<T>* Yva = new BigArray<T>(opt.getOptAsString("files.Yva_filename"), rows, t);
 
-    unsigned long* indices = new unsigned long[lastRows];
 
-    randperm(lastRows, indices, true, 0);
+    // allocated cells: the two partial products, up to as many reduced ones,
+    // and readRows*(d+t) cells for the rows read plus as many for the validation ones among them
+    const unsigned long cells = static_cast<unsigned long>(opt.getOptAsNumber("memlimit")/sizeof(T));
+    const unsigned long reserved = 2*d*(d+t);
+    const unsigned long rowCells = 2*(d+t);
+
+    if(cells < reserved + rowCells)
+        throw gException("Not enough memory available to complete the operation");
+
+    const unsigned long readRows = std::min((cells - reserved)/rowCells, std::max(lastRows, 1ul));
 
-    const unsigned long blockRows = numRows*hoProportion;
-    const unsigned long lastBlockRows = lastRows*hoProportion;
+    // every process takes part in the same number of collective transfers
+    unsigned long numChunks = (lastRows + readRows - 1)/readRows;
+    unsigned long rounds;
+    MPI_Allreduce(&numChunks, &rounds, 1, MPI_UNSIGNED_LONG, MPI_MAX, MPI_COMM_WORLD);
 
-    const unsigned long begin = myid*blockRows;
 
+    T* XvatXva_sum = new T[d*d];
+    T* XvatYva_sum = new T[d*t];
+    set(XvatXva_sum, (T)0.0, d*d);
+    set(XvatYva_sum, (T)0.0, d*t);
 
-    gMat2D<T> X_block(lastRows, d);
-    gMat2D<T> Y_block(lastRows, t);
-    gMat2D<T> Xva_block(lastBlockRows, d);
-    gMat2D<T> Yva_block(lastBlockRows, t);
+    gMat2D<T> X_chunk;
+    gMat2D<T> Y_chunk;
+    T* Xva_chunk = new T[readRows*d];
+    T* Yva_chunk = new T[readRows*t];
 
-    X.getMatrix(numRows*myid, 0, X_block);
-    Y.getMatrix(numRows*myid, 0, Y_block);
+    unsigned long written = 0;
 
-    for(unsigned long i = 0; i < lastBlockRows; ++i)
+    for(unsigned long r = 0; r < rounds; ++r)
     {
-        const unsigned long row = indices[i];
+        const unsigned long offset = std::min(r*readRows, lastRows);
+        const unsigned long chunkRows = std::min(readRows, lastRows-offset);
 
-        copy(Xva_block.getData()+i, X_block.getData()+row, d, lastBlockRows, lastRows);
-        copy(Yva_block.getData()+i, Y_block.getData()+row, t, lastBlockRows, lastRows);
+        // validation rows falling in this chunk
+        unsigned long* first = std::lower_bound(indices+written, indices+lastBlockRows, offset);
+        unsigned long* last = std::lower_bound(first, indices+lastBlockRows, offset+chunkRows);
+        const unsigned long vaRows = last-first;
+
+        // chunks without validation rows are not read
+        const unsigned long readChunkRows = (vaRows > 0)? chunkRows: 0;
+
+        X.getMatrixCollective(firstRow+offset, 0, readChunkRows, d, X_chunk);
+        Y.getMatrixCollective(firstRow+offset, 0, readChunkRows, t, Y_chunk);
+
+        for(unsigned long i = 0; i < vaRows; ++i)
+        {
+            const unsigned long row = first[i]-offset;
+
+            copy(Xva_chunk+i, X_chunk.getData()+row, d, vaRows, readChunkRows);
+            copy(Yva_chunk+i, Y_chunk.getData()+row, t, vaRows, readChunkRows);
+        }
+
+        Xva->setMatrixCollective(begin+written, 0, Xva_chunk, vaRows, d);
+        Yva->setMatrixCollective(begin+written, 0, Yva_chunk, vaRows, t);
+
+        if(vaRows > 0)
+        {
+            syrk(CblasUpper, CblasTrans, d, vaRows, (T)1.0, Xva_chunk, vaRows, (T)1.0, XvatXva_sum, d);
+            gemm(CblasTrans, CblasNoTrans, d, t, vaRows, (T)1.0, Xva_chunk, vaRows, Yva_chunk, vaRows, (T)1.0, XvatYva_sum, d);
+        }
+
+        written += vaRows;
     }
 
     delete[] indices;
+    delete[] Xva_chunk;
+    delete[] Yva_chunk;
 
-    Xva->setMatrix(begin, 0, Xva_block);
-    Yva->setMatrix(begin, 0, Yva_block);
+    // syrk only updates the upper triangle
+    for(unsigned long j = 0; j < d; ++j)
+        for(unsigned long i = j+1; i < d; ++i)
+            XvatXva_sum[i + j*d] = XvatXva_sum[j + i*d];
 
+    BigArray<T>* XvatXva = reduceAtB(XvatXva_sum, d, d, opt.getOptAsString("files.XvatXva_filename"), atbReduction(opt));
+    BigArray<T>* XvatYva = reduceAtB(XvatYva_sum, d, t, opt.getOptAsString("files.XvatYva_filename"), atbReduction(opt));
 
+    delete[] XvatXva_sum;
+    delete[] XvatYva_sum;
 
     MPI_Barrier(MPI_COMM_WORLD);
 
-    BigArray<T>* XvatXva = matMult_AtB(*Xva, *Xva, opt.getOptAsString("files.XvatXva_filename"));
-    BigArray<T>* XvatYva = matMult_AtB(*Xva, *Yva, opt.getOptAsString("files.XvatYva_filename"));
-
 
     GurlsOptionsList* split = new GurlsOptionsList("split");
     split->addOpt("Xva", new OptMatrix<BigArray<T> >(*Xva));
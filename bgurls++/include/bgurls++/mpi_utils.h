@@ -44,9 +44,17 @@
 
 #include <mpi.h>
 
+#include <algorithm>
+#include <climits>
+
 namespace gurls
 {
 
+/**
+  * Largest number of elements moved by a single MPI call, since MPI counts are int
+  */
+const unsigned long mpiMaxCount = static_cast<unsigned long>(INT_MAX);
+
 template<typename T>
 int MPI_ReduceT(T *sendbuf, T *recvbuf, int count, MPI_Op op, int root, MPI_Comm comm);
 
@@ -56,6 +64,30 @@ int MPI_AllReduceT(T *sendbuf, T *recvbuf, int count, MPI_Op op, MPI_Comm comm);
 template<typename T>
 int MPI_BcastT(T *buffer, int count, int root, MPI_Comm comm);
 
+template<typename T>
+int MPI_ReduceScatterT(T *sendbuf, T *recvbuf, int *recvcounts, MPI_Op op, MPI_Comm comm);
+
+template<typename T>
+int MPI_SendrecvT(T *sendbuf, int sendcount, int dest, T *recvbuf, int recvcount, int source, int tag, MPI_Comm comm);
+
+/**
+  * MPI_ReduceT for buffers of any size: the reduction is split in calls of at most mpiMaxCount elements
+  */
+template<typename T>
+int MPI_ReduceLargeT(T *sendbuf, T *recvbuf, unsigned long count, MPI_Op op, int root, MPI_Comm comm)
+{
+    for(unsigned long i = 0; i < count; i += mpiMaxCount)
+    {
+        const int n = static_cast<int>(std::min(count-i, mpiMaxCount));
+
+        const int ret = MPI_ReduceT(sendbuf+i, (recvbuf != NULL)? recvbuf+i: recvbuf, n, op, root, comm);
+        if(ret != MPI_SUCCESS)
+            return ret;
+    }
+
+    return MPI_SUCCESS;
+}
+
 }
 
 #endif
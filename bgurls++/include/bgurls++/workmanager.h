@@ -0,0 +1,134 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-2013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _GURLS_WORKMANAGER_H_
+#define _GURLS_WORKMANAGER_H_
+
+#include "gurls++/exports.h"
+
+#include <cstdio>
+#include <string>
+
+#include <boost/interprocess/sync/file_lock.hpp>
+
+namespace gurls
+{
+
+/**
+  * \brief WorkManager distributes a set of numbered blocks of work among the processes, or threads, sharing a state file.
+  *
+  * Every block is free, booked by a worker or done. Workers book blocks with getWork and mark them as done with
+  * reportWork. A block booked for longer than the timeout of the job is booked again by the next worker asking for
+  * work, so that the blocks of a crashed worker are taken over by the others, and a job can be restarted on the same
+  * state file skipping the blocks already done.
+  *
+  * The state file is binary: a header, the state of each block and the queue of the bookings, oldest first.
+  * Every operation holds an exclusive lock on the file and takes constant (amortized) time: blocks never booked are
+  * taken from a cursor, and only the oldest booking needs to be checked for a timeout.
+  */
+class GURLS_EXPORT WorkManager
+{
+public:
+
+    static const long NoWork = -1;   ///< the remaining blocks are booked by other workers
+    static const long AllDone = -2;  ///< all the blocks are done
+
+    /**
+      * Creates the state file of a job made of numBlocks blocks. Must be called by a single process,
+      * before the workers open the file.
+      * \param stateFile name of the state file, on a filesystem shared by all the workers
+      * \param numBlocks number of blocks
+      * \param timeout seconds after which a booked block is booked again
+      * \param resume if true and stateFile describes a job with the same number of blocks, the blocks already done
+      * are kept and the booked ones can be booked again immediately
+      */
+    static void setup(const std::string& stateFile, unsigned long numBlocks, double timeout, bool resume = false);
+
+    /**
+      * Removes the state file
+      */
+    static void dismiss(const std::string& stateFile);
+
+    /**
+      * Opens the state file of a job created with setup
+      */
+    explicit WorkManager(const std::string& stateFile);
+
+    ~WorkManager();
+
+    /**
+      * Books a block
+      * \return the index of the block, NoWork or AllDone
+      */
+    long getWork();
+
+    /**
+      * Books a block, waiting while the remaining blocks are booked by other workers
+      * \param pollSeconds seconds between two attempts
+      * \return the index of the block or AllDone
+      */
+    long waitWork(double pollSeconds = 1.0);
+
+    /**
+      * Marks a block as done
+      */
+    void reportWork(unsigned long block);
+
+    /**
+      * Number of blocks of the job
+      */
+    unsigned long numBlocks() const;
+
+protected:
+    std::string fileName;
+    FILE* file;                                 ///< unbuffered, so that every read sees the writes of the other workers
+    boost::interprocess::file_lock fileLock;
+    unsigned long blocks;
+
+private:
+    WorkManager(const WorkManager&);
+    WorkManager& operator=(const WorkManager&);
+};
+
+}
+
+#endif //_GURLS_WORKMANAGER_H_
@@ -0,0 +1,247 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-2013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \ingroup Tutorials
+ * \file
+ * \brief Throughput of BigArray reads and writes with different HDF5 layouts and transfer modes
+ */
+
+#include <mpi.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <ctime>
+
+#include "gurls++/gmat2d.h"
+#include "gurls++/gmath.h"
+#include "bgurls++/bigarray.h"
+
+#include <boost/filesystem/path.hpp>
+
+using namespace gurls;
+using namespace std;
+using namespace boost::filesystem;
+
+typedef double T;
+
+/**
+  * Returns the largest time measured by the processes since \a begin
+  */
+double elapsed(double begin)
+{
+    double t = MPI_Wtime() - begin;
+    double t_max;
+    MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    return t_max;
+}
+
+/**
+  * Writes an n x d BigArray by row blocks, one per process, and reads it back as whole row blocks
+  * and as sequences of smaller row blocks of batch rows, for every combination of layout and transfer mode.
+  * Then times element-wise writes and reads with and without the block cache.
+  * Throughputs are aggregated over all processes.
+  */
+int main(int argc, char *argv[])
+{
+    // BigArray blocks are read ahead by a background thread when MPI can be called from more than one thread
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    if(argc < 4)
+    {
+        if(myid == 0)
+        {
+            cout << "Usage: " << argv[0] << " <shared dir> <rows> <cols> [batch rows]" << endl;
+            cout << "\t - <shared dir> is a directory accessible by all processes (all processes must be able to access the same path)" << endl;
+        }
+
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    srand(static_cast<unsigned int>(time(NULL)) + myid);
+
+    const path shared_directory(argv[1]);
+    const unsigned long n = strtoul(argv[2], NULL, 10);
+    const unsigned long d = strtoul(argv[3], NULL, 10);
+    const unsigned long batch = (argc > 4)? strtoul(argv[4], NULL, 10): 1024;
+
+    const unsigned long blockSize = n/numprocs;
+    const unsigned long remainder = (myid == numprocs-1)? (n%numprocs): 0;
+    const unsigned long blockRows = blockSize + remainder;
+    const unsigned long firstRow = myid*blockSize;
+
+    gMat2D<T> block(blockRows, d);
+    for(T *it = block.getData(), *end = it+block.getSize(); it != end; ++it)
+        *it = static_cast<T>(rand())/RAND_MAX;
+
+    gMat2D<T> readBack;
+
+    const double MB = static_cast<double>(n)*d*sizeof(T)/(1024.0*1024.0);
+
+    if(myid == 0)
+    {
+        cout << n << " x " << d << " matrix (" << MB << " MB), " << numprocs << " processes, batch rows: " << batch << endl << endl;
+        cout << setw(12) << "layout" << setw(12) << "transfer" << setw(14) << "write MB/s" << setw(14) << "read MB/s" << setw(16) << "batch read MB/s" << endl;
+    }
+
+    const char* layouts[] = {"contiguous", "chunked"};
+    const char* transfers[] = {"independent", "collective"};
+
+    for(int l = 0; l < 2; ++l)
+    {
+        for(int c = 0; c < 2; ++c)
+        {
+            BigArrayIO::chunked = (l == 1);
+            BigArrayIO::collective = (c == 1);
+            BigArrayIO::cacheBytes = 64ul << 20;
+
+            const string fileName = path(shared_directory / "benchmarkbigarray.h5").native();
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            double begin = MPI_Wtime();
+
+            BigArray<T>* A = new BigArray<T>(fileName, n, d);
+
+            if(c == 1)
+                A->setMatrixCollective(firstRow, 0, block);
+            else
+                A->setMatrix(firstRow, 0, block);
+
+            A->flush();
+            const double t_write = elapsed(begin);
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            begin = MPI_Wtime();
+
+            if(c == 1)
+                A->getMatrixCollective(firstRow, 0, blockRows, d, readBack);
+            else
+                A->getMatrix(firstRow, 0, blockRows, d, readBack);
+
+            const double t_read = elapsed(begin);
+
+            // every process takes part in the same number of collective reads
+            const unsigned long maxBlockRows = blockSize + n%numprocs;
+            const unsigned long rounds = (maxBlockRows + batch - 1)/batch;
+
+            MPI_Barrier(MPI_COMM_WORLD);
+            begin = MPI_Wtime();
+
+            for(unsigned long r = 0; r < rounds; ++r)
+            {
+                const unsigned long offset = std::min(r*batch, blockRows);
+                const unsigned long rows = std::min(batch, blockRows-offset);
+
+                if(c == 1)
+                    A->getMatrixCollective(firstRow+offset, 0, rows, d, readBack);
+                else if(rows > 0)
+                    A->getMatrix(firstRow+offset, 0, rows, d, readBack);
+            }
+
+            const double t_batch = elapsed(begin);
+
+            delete A;
+
+            if(myid == 0)
+                cout << setw(12) << layouts[l] << setw(12) << transfers[c]
+                     << setw(14) << MB/t_write << setw(14) << MB/t_read << setw(16) << MB/t_batch << endl;
+        }
+    }
+
+    // element-wise accesses to the first rows of each process, with and without the block cache
+    const unsigned long walkRows = std::min(blockRows, 256ul);
+    const double elements = static_cast<double>(walkRows*d*numprocs);
+
+    if(myid == 0)
+        cout << endl << setw(12) << "block cache" << setw(16) << "setValue el/s" << setw(16) << "getValue el/s" << setw(12) << "hit rate" << endl;
+
+    const unsigned long cacheSizes[] = {0, 16ul << 20};
+
+    for(int k = 0; k < 2; ++k)
+    {
+        BigArrayIO::blockCacheBytes = cacheSizes[k];
+
+        BigArray<T>* A = new BigArray<T>(path(shared_directory / "benchmarkbigarray.h5").native(), n, d);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        double begin = MPI_Wtime();
+
+        for(unsigned long i = 0; i < walkRows; ++i)
+            for(unsigned long j = 0; j < d; ++j)
+                A->setValue(firstRow+i, j, block(i, j));
+
+        A->flush();
+        const double t_set = elapsed(begin);
+
+        MPI_Barrier(MPI_COMM_WORLD);
+        begin = MPI_Wtime();
+
+        T sum = 0;
+        for(unsigned long i = 0; i < walkRows; ++i)
+            for(unsigned long j = 0; j < d; ++j)
+                sum += A->getValue(firstRow+i, j);
+
+        const double t_get = elapsed(begin);
+
+        const BigArrayCacheStats& stats = A->cacheStatistics();
+        const double lookups = static_cast<double>(stats.hits + stats.misses);
+
+        if(myid == 0)
+            cout << setw(12) << cacheSizes[k] << setw(16) << elements/t_set << setw(16) << elements/t_get
+                 << setw(12) << ((lookups > 0)? stats.hits/lookups: 0.0) << endl;
+
+        delete A;
+    }
+
+    MPI_Finalize();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,221 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-2013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \ingroup Tutorials
+ * \file
+ * \brief Scaling of the distributed X'X and X'Y products (matMult_AtB) with the number of processes
+ */
+
+#include <mpi.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <ctime>
+
+#include "gurls++/gmat2d.h"
+#include "gurls++/gmath.h"
+#include "bgurls++/bigarray.h"
+#include "bgurls++/bigmath.h"
+
+#include <boost/filesystem/path.hpp>
+
+using namespace gurls;
+using namespace std;
+using namespace boost::filesystem;
+
+typedef double T;
+
+/**
+  * Returns the largest time measured by the processes since \a begin
+  */
+double elapsed(double begin)
+{
+    double t = MPI_Wtime() - begin;
+    double t_max;
+    MPI_Reduce(&t, &t_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+
+    return t_max;
+}
+
+/**
+  * Returns the largest absolute difference between two BigArrays, computed by process 0
+  */
+T maxDifference(const BigArray<T>& A, const BigArray<T>& B)
+{
+    int myid;
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    T diff = 0;
+    if(myid == 0)
+    {
+        gMat2D<T> a, b;
+        A.getMatrix(0, 0, A.rows(), A.cols(), a);
+        B.getMatrix(0, 0, B.rows(), B.cols(), b);
+
+        for(const T *it = a.getData(), *jt = b.getData(), *end = it+a.getSize(); it != end; ++it, ++jt)
+            diff = std::max(diff, std::abs(*it - *jt));
+    }
+
+    return diff;
+}
+
+/**
+  * Computes X'X and X'Y for an n x d matrix X and an n x t matrix Y with every matMult_AtB reduction scheme,
+  * both with one block of rows per process in memory and with the memory limited version.
+  * Run it on a single node with an increasing number of processes to measure the scaling, e.g.
+  *
+  *     for p in 1 2 4 8; do mpirun -np $p benchmarkmatmult /tmp 100000 1000 10; done
+  */
+int main(int argc, char *argv[])
+{
+    // BigArray blocks are read ahead by a background thread when MPI can be called from more than one thread
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
+
+    int numprocs;
+    int myid;
+    MPI_Comm_size(MPI_COMM_WORLD, &numprocs);
+    MPI_Comm_rank(MPI_COMM_WORLD, &myid);
+
+    if(argc < 4)
+    {
+        if(myid == 0)
+        {
+            cout << "Usage: " << argv[0] << " <shared dir> <rows> <cols> [outputs] [memory MB]" << endl;
+            cout << "\t - <shared dir> is a directory accessible by all processes (all processes must be able to access the same path)" << endl;
+        }
+
+        MPI_Finalize();
+        return EXIT_SUCCESS;
+    }
+
+    srand(static_cast<unsigned int>(time(NULL)) + myid);
+
+    const path shared_directory(argv[1]);
+    const unsigned long n = strtoul(argv[2], NULL, 10);
+    const unsigned long d = strtoul(argv[3], NULL, 10);
+    const unsigned long t = (argc > 4)? strtoul(argv[4], NULL, 10): 1;
+    const unsigned long memB = ((argc > 5)? strtoul(argv[5], NULL, 10): 256) << 20;
+
+    const unsigned long blockSize = n/numprocs;
+    const unsigned long remainder = (myid == numprocs-1)? (n%numprocs): 0;
+    const unsigned long blockRows = blockSize + remainder;
+    const unsigned long firstRow = myid*blockSize;
+
+    BigArray<T>* X = new BigArray<T>(path(shared_directory / "benchmarkmatmult_X.h5").native(), n, d);
+    BigArray<T>* Y = new BigArray<T>(path(shared_directory / "benchmarkmatmult_Y.h5").native(), n, t);
+    {
+        gMat2D<T> block(blockRows, d+t);
+        for(T *it = block.getData(), *end = it+block.getSize(); it != end; ++it)
+            *it = static_cast<T>(rand())/RAND_MAX;
+
+        X->setMatrixCollective(firstRow, 0, block.getData(), blockRows, d);
+        Y->setMatrixCollective(firstRow, 0, block.getData()+blockRows*d, blockRows, t);
+        X->flush();
+        Y->flush();
+    }
+
+    if(myid == 0)
+    {
+        cout << n << " x " << d << " X, " << t << " outputs, " << numprocs << " processes, memory limit " << (memB >> 20) << " MB" << endl << endl;
+        cout << setw(10) << "schedule" << setw(10) << "reduction" << setw(10) << "memory" << setw(12) << "X'X s" << setw(12) << "X'Y s"
+             << setw(14) << "X'X GFlop/s" << setw(14) << "max diff" << endl;
+    }
+
+    const char* modes[] = {"block", "limited"};
+    const char* names[] = {"root", "tree", "ring"};
+    const AtBReduction reductions[] = {AtBReduceRoot, AtBReduceTree, AtBReduceRing};
+    const char* schedules[] = {"static", "dynamic"};
+    const AtBSchedule schedulings[] = {AtBStatic, AtBDynamic};
+
+    BigArray<T>* reference = NULL;
+
+    for(int s = 0; s < 2; ++s)
+    {
+        for(int m = 0; m < 2; ++m)
+        {
+            for(int r = 0; r < 3; ++r)
+            {
+                const string XtXFile = path(shared_directory / (string("benchmarkmatmult_XtX_") + schedules[s] + "_" + modes[m] + "_" + names[r] + ".h5")).native();
+                const string XtYFile = path(shared_directory / "benchmarkmatmult_XtY.h5").native();
+
+                MPI_Barrier(MPI_COMM_WORLD);
+                double begin = MPI_Wtime();
+
+                BigArray<T>* XtX = (m == 0)? matMult_AtB(*X, *X, XtXFile, reductions[r], schedulings[s]): matMult_AtB(*X, *X, XtXFile, memB, reductions[r], schedulings[s]);
+                const double t_XtX = elapsed(begin);
+
+                MPI_Barrier(MPI_COMM_WORLD);
+                begin = MPI_Wtime();
+
+                BigArray<T>* XtY = (m == 0)? matMult_AtB(*X, *Y, XtYFile, reductions[r], schedulings[s]): matMult_AtB(*X, *Y, XtYFile, memB, reductions[r], schedulings[s]);
+                const double t_XtY = elapsed(begin);
+
+                delete XtY;
+
+                XtX->flush();
+                T diff = 0;
+                if(reference == NULL)
+                    reference = XtX;
+                else
+                {
+                    diff = maxDifference(*reference, *XtX);
+                    delete XtX;
+                }
+
+                if(myid == 0)
+                    cout << setw(10) << schedules[s] << setw(10) << names[r] << setw(10) << modes[m] << setw(12) << t_XtX << setw(12) << t_XtY
+                         << setw(14) << static_cast<double>(n)*d*(d+1)/t_XtX*1e-9 << setw(14) << diff << endl;
+            }
+        }
+    }
+
+    delete reference;
+    delete X;
+    delete Y;
+
+    MPI_Finalize();
+
+    return EXIT_SUCCESS;
+}
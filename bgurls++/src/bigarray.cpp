@@ -1,4 +1,5 @@
 #include "bgurls++/bigarray.h"
+#include "gurls++/optlist.h"
 
 namespace gurls
 {
@@ -27,4 +28,62 @@ GURLS_EXPORT hid_t getHdfType<unsigned int>()
     return H5T_NATIVE_UINT;
 }
 
+
+bool BigArrayIO::chunked = true;
+unsigned long BigArrayIO::chunkRows = 0;
+unsigned long BigArrayIO::minChunkedBytes = 1ul << 20;
+bool BigArrayIO::collective = true;
+int BigArrayIO::compression = 0;
+unsigned long BigArrayIO::cacheBytes = 0;
+unsigned long BigArrayIO::alignment = 0;
+unsigned long BigArrayIO::blockCacheBytes = 0;
+unsigned long BigArrayIO::blockCacheSide = 64;
+unsigned long BigArrayIO::bytesRead = 0;
+unsigned long BigArrayIO::bytesWritten = 0;
+
+void BigArrayIO::configure(const GurlsOptionsList& opt)
+{
+    if(opt.hasOpt("hdf5_layout"))
+    {
+        const std::string layout = opt.getOptAsString("hdf5_layout");
+
+        if(layout == "chunked")
+            chunked = true;
+        else if(layout == "contiguous")
+            chunked = false;
+        else
+            throw gException(Exception_Illegal_Argument_Value);
+    }
+
+    if(opt.hasOpt("hdf5_chunkrows"))
+        chunkRows = static_cast<unsigned long>(opt.getOptAsNumber("hdf5_chunkrows"));
+
+    if(opt.hasOpt("hdf5_collective"))
+        collective = opt.getOptAsNumber("hdf5_collective") > 0;
+
+    if(opt.hasOpt("hdf5_compression"))
+        compression = std::min(std::max(static_cast<int>(opt.getOptAsNumber("hdf5_compression")), 0), 9);
+
+    // parallel HDF5 can only write filtered datasets collectively
+    if(compression > 0 && !collective)
+        throw gException("hdf5_compression requires hdf5_collective: compressed datasets cannot be written independently");
+
+    if(opt.hasOpt("hdf5_alignment"))
+        alignment = static_cast<unsigned long>(opt.getOptAsNumber("hdf5_alignment"));
+
+    if(opt.hasOpt("block_cache"))
+        blockCacheBytes = static_cast<unsigned long>(opt.getOptAsNumber("block_cache"));
+
+    if(opt.hasOpt("block_cache_side"))
+        blockCacheSide = std::max(static_cast<unsigned long>(opt.getOptAsNumber("block_cache_side")), 1ul);
+
+    if(opt.hasOpt("hdf5_cache"))
+    {
+        cacheBytes = static_cast<unsigned long>(opt.getOptAsNumber("hdf5_cache"));
+
+        if(cacheBytes == 0 && opt.hasOpt("memlimit"))
+            cacheBytes = static_cast<unsigned long>(opt.getOptAsNumber("memlimit")/4);
+    }
+}
+
 }
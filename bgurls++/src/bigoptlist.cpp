@@ -24,6 +24,32 @@ void BGurlsOptionsList::init(const std::string& sharedDir, bool usedefopt)
         (*table)["nb_pred"] = new OptNumber(1);
         (*table)["memlimit"] = new OptNumber(std::pow(2.0, 30)); // default 1 GB
 
+        // big pegasos: mini-batches between two model averages, model averages between two accuracy checks (0 = never)
+        (*table)["syncperiod"] = new OptNumber(16);
+        (*table)["testperiod"] = new OptNumber(0);
+
+        // HDF5 tuning of the BigArrays, see BigArrayIO (hdf5_cache = 0 uses memlimit/4)
+        (*table)["hdf5_layout"] = new OptString("chunked");
+        (*table)["hdf5_chunkrows"] = new OptNumber(0);
+        (*table)["hdf5_collective"] = new OptNumber(1);
+        (*table)["hdf5_compression"] = new OptNumber(0);
+        (*table)["hdf5_cache"] = new OptNumber(0);
+        (*table)["hdf5_alignment"] = new OptNumber(0);
+
+        // write-back cache of square blocks serving element, row and column accesses of the BigArrays, in bytes
+        // (0 disables it). Private to each process: blocks do not see the writes of other processes until flush()
+        (*table)["block_cache"] = new OptNumber(0);
+        (*table)["block_cache_side"] = new OptNumber(64);
+
+        // reduction of the distributed X'X and X'y products: "root", "tree" (MPI_Reduce_scatter) or "ring"
+        (*table)["atb_reduction"] = new OptString("tree");
+
+        // assignment of the rows of X to the processes in the X'X and X'y products: "static" or "dynamic" (see WorkManager)
+        (*table)["atb_schedule"] = new OptString("static");
+
+        // d x d systems of primal RLS: "root" (process 0), "jacobi" (all processes, see eig_sm_jacobi) or "auto"
+        (*table)["gram_solver"] = new OptString("auto");
+
         (*table)["shared_dir"] = new OptString(sharedDir);
 
         path sharedDirPath(sharedDir);
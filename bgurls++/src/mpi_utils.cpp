@@ -83,4 +83,28 @@ GURLS_EXPORT int MPI_BcastT(double *buffer, int count, int root, MPI_Comm comm)
     return MPI_Bcast(buffer, count, MPI_DOUBLE, root, comm);
 }
 
+template<>
+GURLS_EXPORT int MPI_ReduceScatterT(float *sendbuf, float *recvbuf, int *recvcounts, MPI_Op op, MPI_Comm comm)
+{
+    return MPI_Reduce_scatter(sendbuf, recvbuf, recvcounts, MPI_FLOAT, op, comm);
+}
+
+template<>
+GURLS_EXPORT int MPI_ReduceScatterT(double *sendbuf, double *recvbuf, int *recvcounts, MPI_Op op, MPI_Comm comm)
+{
+    return MPI_Reduce_scatter(sendbuf, recvbuf, recvcounts, MPI_DOUBLE, op, comm);
+}
+
+template<>
+GURLS_EXPORT int MPI_SendrecvT(float *sendbuf, int sendcount, int dest, float *recvbuf, int recvcount, int source, int tag, MPI_Comm comm)
+{
+    return MPI_Sendrecv(sendbuf, sendcount, MPI_FLOAT, dest, tag, recvbuf, recvcount, MPI_FLOAT, source, tag, comm, MPI_STATUS_IGNORE);
+}
+
+template<>
+GURLS_EXPORT int MPI_SendrecvT(double *sendbuf, int sendcount, int dest, double *recvbuf, int recvcount, int source, int tag, MPI_Comm comm)
+{
+    return MPI_Sendrecv(sendbuf, sendcount, MPI_DOUBLE, dest, tag, recvbuf, recvcount, MPI_DOUBLE, source, tag, comm, MPI_STATUS_IGNORE);
+}
+
 }
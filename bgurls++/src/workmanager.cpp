@@ -0,0 +1,312 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-2013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * author:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "gurls++/exports.h"
+#include "bgurls++/workmanager.h"
+#include "gurls++/exceptions.h"
+
+#include <cstdio>
+#include <ctime>
+
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/sync/scoped_lock.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+namespace gurls
+{
+
+namespace
+{
+
+const boost::uint32_t stateFileMagic = 0x4b524f57; // "WORK"
+
+enum BlockState {Free = 0, Booked = 1, Done = 2};
+
+struct StateHeader
+{
+    boost::uint32_t magic;
+    boost::uint32_t reserved;
+    boost::uint64_t numBlocks;
+    boost::uint64_t next;       ///< blocks from next on have never been booked
+    boost::uint64_t head;       ///< position in the queue of the oldest booking
+    boost::uint64_t queued;     ///< number of bookings in the queue
+    boost::uint64_t done;       ///< number of blocks done
+    double timeout;
+};
+
+struct BlockRecord
+{
+    boost::uint64_t state;
+    double bookedAt;
+};
+
+// fcntl locks do not exclude the threads of the same process
+boost::mutex processMutex;
+
+long recordOffset(boost::uint64_t block)
+{
+    return static_cast<long>(sizeof(StateHeader) + block*sizeof(BlockRecord));
+}
+
+long queueOffset(boost::uint64_t numBlocks, boost::uint64_t position)
+{
+    return static_cast<long>(sizeof(StateHeader) + numBlocks*sizeof(BlockRecord) + (position%numBlocks)*sizeof(boost::uint64_t));
+}
+
+void readAt(FILE* file, long offset, void* data, size_t size)
+{
+    if(fseek(file, offset, SEEK_SET) != 0 || fread(data, size, 1, file) != 1)
+        throw gException("Error reading the work state file");
+}
+
+void writeAt(FILE* file, long offset, const void* data, size_t size)
+{
+    if(fseek(file, offset, SEEK_SET) != 0 || fwrite(data, size, 1, file) != 1)
+        throw gException("Error writing the work state file");
+}
+
+}
+
+const long WorkManager::NoWork;
+const long WorkManager::AllDone;
+
+void WorkManager::setup(const std::string& stateFile, unsigned long numBlocks, double timeout, bool resume)
+{
+    if(resume)
+    {
+        FILE* file = fopen(stateFile.c_str(), "r+b");
+
+        if(file != NULL)
+        {
+            StateHeader header;
+            const bool valid = fread(&header, sizeof(StateHeader), 1, file) == 1
+                    && header.magic == stateFileMagic && header.numBlocks == numBlocks;
+
+            if(valid)
+            {
+                // the workers of the previous run are gone: their bookings are released, and stay queued
+                for(boost::uint64_t i = 0; i < header.queued; ++i)
+                {
+                    boost::uint64_t block;
+                    readAt(file, queueOffset(header.numBlocks, header.head+i), &block, sizeof(block));
+
+                    BlockRecord record;
+                    readAt(file, recordOffset(block), &record, sizeof(record));
+
+                    if(record.state == Booked)
+                    {
+                        record.state = Free;
+                        writeAt(file, recordOffset(block), &record, sizeof(record));
+                    }
+                }
+
+                header.timeout = timeout;
+                writeAt(file, 0, &header, sizeof(header));
+            }
+
+            fclose(file);
+
+            if(valid)
+                return;
+        }
+    }
+
+    FILE* file = fopen(stateFile.c_str(), "wb");
+    if(file == NULL)
+        throw gException("Cannot create the work state file " + stateFile);
+
+    StateHeader header = {stateFileMagic, 0, numBlocks, 0, 0, 0, 0, timeout};
+    const BlockRecord record = {Free, 0};
+    const boost::uint64_t position = 0;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for(unsigned long i = 0; ok && i < numBlocks; ++i)
+        ok = fwrite(&record, sizeof(record), 1, file) == 1;
+    for(unsigned long i = 0; ok && i < numBlocks; ++i)
+        ok = fwrite(&position, sizeof(position), 1, file) == 1;
+
+    fclose(file);
+
+    if(!ok)
+        throw gException("Error writing the work state file " + stateFile);
+}
+
+void WorkManager::dismiss(const std::string& stateFile)
+{
+    std::remove(stateFile.c_str());
+}
+
+WorkManager::WorkManager(const std::string& stateFile): fileName(stateFile), file(NULL), blocks(0)
+{
+    file = fopen(stateFile.c_str(), "r+b");
+    if(file == NULL)
+        throw gException("Cannot open the work state file " + stateFile);
+
+    setvbuf(file, NULL, _IONBF, 0);
+
+    try
+    {
+        boost::interprocess::file_lock lock(stateFile.c_str());
+        fileLock.swap(lock);
+    }
+    catch(boost::interprocess::interprocess_exception&)
+    {
+        fclose(file);
+        throw gException("Cannot lock the work state file " + stateFile);
+    }
+
+    StateHeader header;
+    readAt(file, 0, &header, sizeof(header));
+
+    if(header.magic != stateFileMagic)
+    {
+        fclose(file);
+        throw gException("Invalid work state file " + stateFile);
+    }
+
+    blocks = static_cast<unsigned long>(header.numBlocks);
+}
+
+WorkManager::~WorkManager()
+{
+    // closing a descriptor of the file releases the fcntl locks of the whole process
+    boost::mutex::scoped_lock guard(processMutex);
+
+    fclose(file);
+}
+
+long WorkManager::getWork()
+{
+    boost::mutex::scoped_lock guard(processMutex);
+    boost::interprocess::scoped_lock<boost::interprocess::file_lock> lock(fileLock);
+
+    StateHeader header;
+    readAt(file, 0, &header, sizeof(header));
+
+    // bookings at the head of the queue may have been done since
+    BlockRecord record;
+    boost::uint64_t oldest = 0;
+
+    while(header.queued > 0)
+    {
+        readAt(file, queueOffset(header.numBlocks, header.head), &oldest, sizeof(oldest));
+        readAt(file, recordOffset(oldest), &record, sizeof(record));
+
+        if(record.state != Done)
+            break;
+
+        header.head = (header.head+1)%header.numBlocks;
+        --header.queued;
+    }
+
+    const double now = static_cast<double>(std::time(NULL));
+    long block;
+
+    if(header.next < header.numBlocks)
+    {
+        block = static_cast<long>(header.next++);
+    }
+    else if(header.queued > 0 && (record.state == Free || record.bookedAt + header.timeout <= now))
+    {
+        // the oldest booking expired or was released: move it to the back of the queue
+        block = static_cast<long>(oldest);
+        header.head = (header.head+1)%header.numBlocks;
+        --header.queued;
+    }
+    else
+    {
+        writeAt(file, 0, &header, sizeof(header));
+        return (header.done == header.numBlocks)? AllDone: NoWork;
+    }
+
+    const BlockRecord booked = {Booked, now};
+    const boost::uint64_t position = static_cast<boost::uint64_t>(block);
+
+    writeAt(file, recordOffset(position), &booked, sizeof(booked));
+    writeAt(file, queueOffset(header.numBlocks, header.head+header.queued), &position, sizeof(position));
+    ++header.queued;
+    writeAt(file, 0, &header, sizeof(header));
+
+    return block;
+}
+
+long WorkManager::waitWork(double pollSeconds)
+{
+    long block;
+
+    while((block = getWork()) == NoWork)
+        boost::this_thread::sleep(boost::posix_time::milliseconds(static_cast<long>(pollSeconds*1000)));
+
+    return block;
+}
+
+void WorkManager::reportWork(unsigned long block)
+{
+    if(block >= blocks)
+        throw gException(Exception_Index_Out_of_Bound);
+
+    boost::mutex::scoped_lock guard(processMutex);
+    boost::interprocess::scoped_lock<boost::interprocess::file_lock> lock(fileLock);
+
+    BlockRecord record;
+    readAt(file, recordOffset(block), &record, sizeof(record));
+
+    if(record.state == Done)
+        return;
+
+    StateHeader header;
+    readAt(file, 0, &header, sizeof(header));
+
+    record.state = Done;
+    writeAt(file, recordOffset(block), &record, sizeof(record));
+
+    ++header.done;
+    writeAt(file, 0, &header, sizeof(header));
+}
+
+unsigned long WorkManager::numBlocks() const
+{
+    return blocks;
+}
+
+}
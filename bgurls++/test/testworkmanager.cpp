@@ -0,0 +1,240 @@
+#include "bgurls++/workmanager.h"
+#include "gurls++/exceptions.h"
+
+#include <set>
+#include <vector>
+
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE workmanager
+
+#include <boost/test/unit_test.hpp>
+
+using gurls::WorkManager;
+
+namespace
+{
+
+std::string stateFileName()
+{
+    return (boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("workmanager-%%%%-%%%%")).string();
+}
+
+// books and completes blocks until all are done, recording the ones it booked
+struct Worker
+{
+    std::string stateFile;
+    std::vector<long>* booked;
+    boost::mutex* mutex;
+
+    void operator()()
+    {
+        WorkManager work(stateFile);
+
+        long block;
+        while((block = work.waitWork(0.001)) != WorkManager::AllDone)
+        {
+            {
+                boost::mutex::scoped_lock lock(*mutex);
+                booked->push_back(block);
+            }
+
+            work.reportWork(block);
+        }
+    }
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkManagerBooking)
+{
+    const std::string stateFile = stateFileName();
+    const unsigned long numBlocks = 10;
+
+    WorkManager::setup(stateFile, numBlocks, 3600);
+
+    {
+        WorkManager work(stateFile);
+        BOOST_CHECK_EQUAL(work.numBlocks(), numBlocks);
+
+        for(unsigned long i = 0; i < numBlocks; ++i)
+            BOOST_CHECK_EQUAL(work.getWork(), static_cast<long>(i));
+
+        // every block is booked and none timed out
+        BOOST_CHECK_EQUAL(work.getWork(), WorkManager::NoWork);
+
+        for(unsigned long i = 0; i < numBlocks; ++i)
+            work.reportWork(i);
+
+        // reporting twice is harmless
+        work.reportWork(0);
+
+        BOOST_CHECK_EQUAL(work.getWork(), WorkManager::AllDone);
+        BOOST_CHECK_THROW(work.reportWork(numBlocks), gurls::gException);
+    }
+
+    WorkManager::dismiss(stateFile);
+    BOOST_CHECK(!boost::filesystem::exists(stateFile));
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkManagerTimeout)
+{
+    // with a zero timeout a booked block can be booked again at once, oldest booking first
+    const std::string stateFile = stateFileName();
+
+    WorkManager::setup(stateFile, 3, 0);
+
+    {
+        WorkManager work(stateFile);
+
+        BOOST_CHECK_EQUAL(work.getWork(), 0);
+        BOOST_CHECK_EQUAL(work.getWork(), 1);
+        BOOST_CHECK_EQUAL(work.getWork(), 2);
+
+        work.reportWork(1);
+
+        BOOST_CHECK_EQUAL(work.getWork(), 0);
+        BOOST_CHECK_EQUAL(work.getWork(), 2);
+
+        work.reportWork(0);
+        work.reportWork(2);
+
+        BOOST_CHECK_EQUAL(work.getWork(), WorkManager::AllDone);
+    }
+
+    WorkManager::dismiss(stateFile);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkManagerResume)
+{
+    const std::string stateFile = stateFileName();
+
+    WorkManager::setup(stateFile, 5, 3600);
+
+    {
+        WorkManager work(stateFile);
+        for(int i = 0; i < 5; ++i)
+            work.getWork();
+
+        work.reportWork(0);
+        work.reportWork(3);
+    }
+
+    // the bookings of the previous run are released, the blocks done are kept
+    WorkManager::setup(stateFile, 5, 3600, true);
+
+    {
+        WorkManager work(stateFile);
+
+        BOOST_CHECK_EQUAL(work.getWork(), 1);
+        BOOST_CHECK_EQUAL(work.getWork(), 2);
+        BOOST_CHECK_EQUAL(work.getWork(), 4);
+        BOOST_CHECK_EQUAL(work.getWork(), WorkManager::NoWork);
+
+        work.reportWork(1);
+        work.reportWork(2);
+        work.reportWork(4);
+
+        BOOST_CHECK_EQUAL(work.getWork(), WorkManager::AllDone);
+    }
+
+    // a job with a different number of blocks starts from scratch
+    WorkManager::setup(stateFile, 4, 3600, true);
+
+    {
+        WorkManager work(stateFile);
+
+        BOOST_CHECK_EQUAL(work.numBlocks(), 4ul);
+        BOOST_CHECK_EQUAL(work.getWork(), 0);
+    }
+
+    WorkManager::dismiss(stateFile);
+}
+
+BOOST_AUTO_TEST_CASE(TestWorkManagerConcurrent)
+{
+    // threads of this process and forked processes share the state file: every block is booked exactly once
+    const std::string stateFile = stateFileName();
+    const unsigned long numBlocks = 2000;
+    const int numProcesses = 2;
+    const int numThreads = 4;
+
+    WorkManager::setup(stateFile, numBlocks, 3600);
+
+    std::vector<long> booked;
+    boost::mutex mutex;
+
+    int pipes[numProcesses][2];
+    pid_t children[numProcesses];
+
+    for(int p = 0; p < numProcesses; ++p)
+    {
+        BOOST_REQUIRE_EQUAL(pipe(pipes[p]), 0);
+
+        children[p] = fork();
+        BOOST_REQUIRE_GE(children[p], 0);
+
+        if(children[p] == 0)
+        {
+            close(pipes[p][0]);
+
+            std::vector<long> own;
+            boost::mutex ownMutex;
+            Worker worker = {stateFile, &own, &ownMutex};
+
+            try
+            {
+                worker();
+            }
+            catch(...)
+            {
+                _exit(1);
+            }
+
+            for(size_t i = 0; i < own.size(); ++i)
+                if(write(pipes[p][1], &own[i], sizeof(long)) != sizeof(long))
+                    _exit(1);
+
+            _exit(0);
+        }
+
+        close(pipes[p][1]);
+    }
+
+    boost::thread_group threads;
+    for(int i = 0; i < numThreads; ++i)
+    {
+        Worker worker = {stateFile, &booked, &mutex};
+        threads.create_thread(worker);
+    }
+
+    threads.join_all();
+
+    for(int p = 0; p < numProcesses; ++p)
+    {
+        long block;
+        while(read(pipes[p][0], &block, sizeof(long)) == sizeof(long))
+            booked.push_back(block);
+
+        close(pipes[p][0]);
+
+        int status;
+        waitpid(children[p], &status, 0);
+        BOOST_CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    }
+
+    std::set<long> unique(booked.begin(), booked.end());
+
+    BOOST_CHECK_EQUAL(booked.size(), numBlocks);
+    BOOST_CHECK_EQUAL(unique.size(), numBlocks);
+    BOOST_CHECK_EQUAL(*unique.begin(), 0);
+    BOOST_CHECK_EQUAL(*unique.rbegin(), static_cast<long>(numBlocks-1));
+
+    WorkManager::dismiss(stateFile);
+}
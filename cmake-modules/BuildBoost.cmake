@@ -52,6 +52,7 @@ ExternalProject_add(buildBoost
                 --with-test
                 --with-system
                 --with-signals
+                --with-thread
                 install
     INSTALL_COMMAND ""
 )
@@ -0,0 +1,295 @@
+/*
+  * The GURLS Package in C++
+  *
+  * Copyright (C) 2011-1013, IIT@MIT Lab
+  * All rights reserved.
+  *
+  * author:  M. Santoro
+  * email:   msantoro@mit.edu
+  * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions
+  * are met:
+  *
+  *     * Redistributions of source code must retain the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer.
+  *     * Redistributions in binary form must reproduce the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer in the documentation and/or other materials
+  *       provided with the distribution.
+  *     * Neither the name(s) of the copyright holders nor the names
+  *       of its contributors or of the Massacusetts Institute of
+  *       Technology or of the Italian Institute of Technology may be
+  *       used to endorse or promote products derived from this software
+  *       without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  * POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#ifndef GURLS_BALLTREE_H
+#define GURLS_BALLTREE_H
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+namespace gurls
+{
+
+/**
+  * \ingroup Prediction
+  * \brief BallTree is a spatial index over a set of points, answering fixed-radius neighbor queries.
+  *
+  * Each node stores a ball (center and radius) enclosing the points of its subtree, nodes are split
+  * at the median of the coordinate with the largest spread. A query visits only the nodes whose ball
+  * intersects the query ball. The indexed points are copied, so the tree does not depend on the input buffer.
+  */
+template<typename T>
+class BallTree
+{
+public:
+
+    /**
+      * Constructor, builds the tree
+      *
+      * \param X points, n x d column major
+      * \param n number of points
+      * \param d number of variables
+      * \param leafSize maximum number of points in a leaf
+      */
+    BallTree(const T* X, unsigned long n, unsigned long d, unsigned long leafSize = 32);
+
+    /**
+      * Finds the points within distance sqrt(\a radius2) from \a x
+      *
+      * \param[in] x query point, d elements
+      * \param[in] radius2 squared radius of the query ball
+      * \param[out] indices indices of the points found, in no particular order
+      * \param[out] distances2 squared distances of the points found from \a x
+      * \param stack work vector, reused across queries
+      */
+    void rangeSearch(const T* x, T radius2, std::vector<unsigned long>& indices, std::vector<T>& distances2,
+                     std::vector<unsigned long>& stack) const;
+
+    /**
+      * Returns the number of indexed points
+      */
+    unsigned long size() const {return n;}
+
+    /**
+      * Returns the number of variables of the indexed points
+      */
+    unsigned long dims() const {return d;}
+
+protected:
+
+    /**
+      * \brief A node of the tree, covering points [begin, end) of the permuted points
+      */
+    struct Node
+    {
+        unsigned long begin;
+        unsigned long end;
+        unsigned long left;     ///< Index of the left child, 0 for leaves
+        unsigned long right;    ///< Index of the right child
+        T radius;               ///< Distance of the farthest point from the center
+    };
+
+    /**
+      * Builds the subtree over points [begin, end), returns the index of its root
+      */
+    unsigned long build(unsigned long begin, unsigned long end);
+
+    /**
+      * Returns the squared distance between \a x and the d-elements vector \a y
+      */
+    T distance2(const T* x, const T* y) const;
+
+    /**
+      * \brief Compares point indices by one coordinate
+      */
+    struct CoordinateLess
+    {
+        const T* X;
+        unsigned long n;
+        unsigned long k;
+
+        CoordinateLess(const T* X, unsigned long n, unsigned long k): X(X), n(n), k(k) {}
+        bool operator()(unsigned long a, unsigned long b) const {return X[a + n*k] < X[b + n*k];}
+    };
+
+    unsigned long n;                    ///< Number of points
+    unsigned long d;                    ///< Number of variables
+    unsigned long leafSize;             ///< Maximum number of points in a leaf
+
+    const T* X;                         ///< Input points, used only while building
+    std::vector<unsigned long> index;   ///< Original index of each permuted point
+    std::vector<T> points;              ///< Points in tree order, one row of d elements each
+    std::vector<T> centers;             ///< Node centers, one row of d elements each
+    std::vector<Node> nodes;            ///< Tree nodes, the root is nodes[0]
+};
+
+template <typename T>
+BallTree<T>::BallTree(const T* X, unsigned long n, unsigned long d, unsigned long leafSize):
+    n(n), d(d), leafSize(std::max(leafSize, 1ul)), X(X), index(n)
+{
+    for(unsigned long i = 0; i < n; ++i)
+        index[i] = i;
+
+    if(n > 0)
+        build(0, n);
+
+    // store the points in tree order, so that each leaf is contiguous in memory
+    points.resize(n*d);
+    for(unsigned long i = 0; i < n; ++i)
+        for(unsigned long k = 0; k < d; ++k)
+            points[i*d + k] = X[index[i] + n*k];
+
+    this->X = NULL;
+}
+
+template <typename T>
+unsigned long BallTree<T>::build(unsigned long begin, unsigned long end)
+{
+    const unsigned long id = nodes.size();
+
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    node.left = node.right = 0;
+    node.radius = 0;
+    nodes.push_back(node);
+
+    centers.resize(centers.size() + d, (T)0.0);
+    T* center = &centers[id*d];
+
+    // center = mean of the points, split coordinate = largest spread
+    unsigned long split = 0;
+    T maxSpread = -1;
+    for(unsigned long k = 0; k < d; ++k)
+    {
+        const T* X_k = X + n*k;
+        T minv = X_k[index[begin]];
+        T maxv = minv;
+        T sum = 0;
+        for(unsigned long i = begin; i < end; ++i)
+        {
+            const T v = X_k[index[i]];
+            sum += v;
+            minv = std::min(minv, v);
+            maxv = std::max(maxv, v);
+        }
+        center[k] = sum/(end-begin);
+
+        if(maxv - minv > maxSpread)
+        {
+            maxSpread = maxv - minv;
+            split = k;
+        }
+    }
+
+    T radius2 = 0;
+    for(unsigned long i = begin; i < end; ++i)
+    {
+        T dist = 0;
+        for(unsigned long k = 0; k < d; ++k)
+        {
+            const T v = X[index[i] + n*k] - center[k];
+            dist += v*v;
+        }
+        radius2 = std::max(radius2, dist);
+    }
+    nodes[id].radius = std::sqrt(radius2);
+
+    if(end - begin <= leafSize || maxSpread <= 0)
+        return id;
+
+    const unsigned long middle = begin + (end-begin)/2;
+    std::nth_element(index.begin()+begin, index.begin()+middle, index.begin()+end, CoordinateLess(X, n, split));
+
+    const unsigned long left = build(begin, middle);
+    const unsigned long right = build(middle, end);
+
+    nodes[id].left = left;
+    nodes[id].right = right;
+
+    return id;
+}
+
+template <typename T>
+T BallTree<T>::distance2(const T* x, const T* y) const
+{
+    T dist = 0;
+    for(unsigned long k = 0; k < d; ++k)
+    {
+        const T v = x[k] - y[k];
+        dist += v*v;
+    }
+    return dist;
+}
+
+template <typename T>
+void BallTree<T>::rangeSearch(const T* x, T radius2, std::vector<unsigned long>& indices, std::vector<T>& distances2,
+                              std::vector<unsigned long>& stack) const
+{
+    indices.clear();
+    distances2.clear();
+
+    if(n == 0 || radius2 < 0)
+        return;
+
+    const T radius = std::sqrt(radius2);
+
+    stack.clear();
+    stack.push_back(0);
+
+    while(!stack.empty())
+    {
+        const Node& node = nodes[stack.back()];
+        const T* center = &centers[stack.back()*d];
+        stack.pop_back();
+
+        // skip balls not intersecting the query ball
+        const T dist = std::sqrt(distance2(x, center));
+        if(dist - node.radius > radius)
+            continue;
+
+        // every point of balls contained in the query ball is a neighbor
+        const bool inside = (dist + node.radius <= radius);
+
+        if(node.left == 0 || inside)
+        {
+            for(unsigned long i = node.begin; i < node.end; ++i)
+            {
+                const T dist2 = distance2(x, &points[i*d]);
+                if(inside || dist2 <= radius2)
+                {
+                    indices.push_back(index[i]);
+                    distances2.push_back(dist2);
+                }
+            }
+        }
+        else
+        {
+            stack.push_back(node.right);
+            stack.push_back(node.left);
+        }
+    }
+}
+
+}
+
+#endif //GURLS_BALLTREE_H
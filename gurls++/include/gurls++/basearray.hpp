@@ -35,8 +35,7 @@ template <typename T>
 void BaseArray<T>::alloc(unsigned long n) {
     this->isowner = true;
     this->size = n;
-    if ( this->size > 0 )
-        this->data = new T[this->size];
+    this->data = (this->size > 0)? new T[this->size]: NULL;
 }
 
 template <typename T>
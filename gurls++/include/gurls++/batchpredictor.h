@@ -0,0 +1,198 @@
+/*
+  * The GURLS Package in C++
+  *
+  * Copyright (C) 2011-1013, IIT@MIT Lab
+  * All rights reserved.
+  *
+  * author:  M. Santoro
+  * email:   msantoro@mit.edu
+  * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions
+  * are met:
+  *
+  *     * Redistributions of source code must retain the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer.
+  *     * Redistributions in binary form must reproduce the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer in the documentation and/or other materials
+  *       provided with the distribution.
+  *     * Neither the name(s) of the copyright holders nor the names
+  *       of its contributors or of the Massacusetts Institute of
+  *       Technology or of the Italian Institute of Technology may be
+  *       used to endorse or promote products derived from this software
+  *       without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  * POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#ifndef GURLS_BATCHPREDICTOR_H
+#define GURLS_BATCHPREDICTOR_H
+
+#include "gurls++/wrapper.h"
+#include "gurls++/compiledpredictor.h"
+
+#include <deque>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/future.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/random/mersenne_twister.hpp>
+
+namespace gurls
+{
+
+/**
+  * \ingroup Wrappers
+  * \brief BatchPredictor serves single-point predictions from many threads by grouping them in batches.
+  *
+  * Requests submitted with submit() are queued and evaluated by a worker thread. A batch is closed
+  * when it holds maxBatchSize points or when its oldest request has waited maxWaitMicroseconds, and
+  * is evaluated with a single matrix-matrix product by a CompiledPredictor taken from the trained wrapper.
+  */
+template<typename T>
+class BatchPredictor
+{
+public:
+
+    static const unsigned long latencySamples = 8192;   ///< Size of the latency reservoir
+
+    /**
+      * \brief Throughput and latency statistics, latencies are in microseconds
+      *
+      * Counts, mean and maximum are exact. Percentiles are estimated on a uniform sample
+      * of at most latencySamples requests, so that memory stays bounded on long-running servers.
+      */
+    struct Stats
+    {
+        unsigned long requests;     ///< Number of evaluated requests
+        unsigned long batches;      ///< Number of evaluated batches
+        double meanBatchSize;       ///< Average number of requests per batch
+        double throughput;          ///< Evaluated requests per second
+        double latencyMean;         ///< Average time from submission to result
+        double latencyP50;          ///< Median latency (estimated)
+        double latencyP90;          ///< 90th percentile of the latency (estimated)
+        double latencyP99;          ///< 99th percentile of the latency (estimated)
+        double latencyMax;          ///< Maximum latency
+    };
+
+    /**
+      * Constructor, takes a snapshot of the trained model and starts the worker thread
+      *
+      * \param model trained wrapper, must support GurlsWrapper::compile()
+      * \param maxBatchSize maximum number of requests evaluated together
+      * \param maxWaitMicroseconds maximum time a request waits for its batch to fill up
+      */
+    BatchPredictor(GurlsWrapper<T>& model, unsigned long maxBatchSize = 64, unsigned long maxWaitMicroseconds = 500);
+
+    /**
+      * Destructor, evaluates the pending requests and stops the worker thread
+      */
+    ~BatchPredictor();
+
+    /**
+      * Queues an input point for evaluation
+      *
+      * \param[in] x input point, inputs() elements
+      * \returns A future holding the outputs()-long prediction
+      */
+    boost::unique_future<std::vector<T> > submit(const T* x);
+
+    /**
+      * Estimates the outputs for a single input point, blocking until its batch has been evaluated
+      *
+      * \param[in] x input point, inputs() elements
+      * \param[out] out predicted outputs, outputs() elements
+      */
+    void predict(const T* x, T* out);
+
+    /**
+      * Returns the number of input variables
+      */
+    unsigned long inputs() const {return predictor->inputs();}
+
+    /**
+      * Returns the number of outputs
+      */
+    unsigned long outputs() const {return predictor->outputs();}
+
+    /**
+      * Returns the statistics collected since construction or since the last call to resetStats()
+      */
+    Stats stats() const;
+
+    /**
+      * Clears the collected statistics
+      */
+    void resetStats();
+
+protected:
+
+    /**
+      * \brief A queued input point
+      */
+    struct Request
+    {
+        std::vector<T> x;
+        boost::promise<std::vector<T> > result;
+        boost::posix_time::ptime submitted;
+    };
+
+    /**
+      * Main loop of the worker thread
+      */
+    void serve();
+
+    /**
+      * Evaluates a batch of requests and fulfils their futures
+      */
+    void evaluate(std::vector<Request*>& batch);
+
+    CompiledPredictor<T> *predictor;        ///< Snapshot of the model
+    const unsigned long maxBatchSize;       ///< Maximum number of requests per batch
+    const boost::posix_time::time_duration maxWait; ///< Maximum waiting time of a request
+
+    std::deque<Request*> queue;             ///< Pending requests
+    bool stopping;                          ///< True when the worker has to quit
+
+    mutable boost::mutex queueMutex;        ///< Protects queue and stopping
+    boost::condition_variable queueCond;    ///< Signals new requests to the worker
+
+    std::vector<T> X;       ///< Batch input buffer, maxBatchSize x inputs() column major
+    std::vector<T> Y;       ///< Batch output buffer, maxBatchSize x outputs() column major
+    std::vector<T> work;    ///< Work buffer of the predictor
+
+    mutable boost::mutex statsMutex;        ///< Protects the statistics
+    unsigned long nBatches;                 ///< Number of evaluated batches
+    unsigned long nRequests;                ///< Number of evaluated requests
+    double latencySum;                      ///< Sum of the latencies of the evaluated requests
+    double latencyMax;                      ///< Maximum latency of the evaluated requests
+    std::vector<double> latencies;          ///< Reservoir sample of the latencies, at most latencySamples
+    boost::random::mt19937 latencyGen;      ///< Generator of the reservoir replacements
+    boost::posix_time::ptime statsBegin;    ///< Beginning of the statistics window
+    boost::posix_time::ptime statsEnd;      ///< Completion time of the last batch
+
+    boost::thread worker;                   ///< Worker thread
+};
+
+}
+
+#include "gurls++/batchpredictor.hpp"
+
+#endif //GURLS_BATCHPREDICTOR_H
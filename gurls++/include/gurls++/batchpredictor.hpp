@@ -0,0 +1,239 @@
+#include "gurls++/batchpredictor.h"
+#include "gurls++/exceptions.h"
+
+#include <algorithm>
+
+#include <boost/bind.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+namespace gurls
+{
+
+template <typename T>
+BatchPredictor<T>::BatchPredictor(GurlsWrapper<T>& model, unsigned long maxBatchSize, unsigned long maxWaitMicroseconds):
+    predictor(model.compile()), maxBatchSize(maxBatchSize), maxWait(boost::posix_time::microseconds(maxWaitMicroseconds)),
+    stopping(false), nBatches(0), nRequests(0), latencySum(0.0), latencyMax(0.0)
+{
+    if(maxBatchSize == 0)
+    {
+        delete predictor;
+        throw gException(Exception_Illegal_Argument_Value);
+    }
+
+    X.resize(maxBatchSize*predictor->inputs());
+    Y.resize(maxBatchSize*predictor->outputs());
+    work.resize(std::max(predictor->workSize(maxBatchSize), 1ul));
+
+    latencies.reserve(latencySamples);
+    statsBegin = statsEnd = boost::posix_time::microsec_clock::universal_time();
+
+    worker = boost::thread(boost::bind(&BatchPredictor<T>::serve, this));
+}
+
+template <typename T>
+BatchPredictor<T>::~BatchPredictor()
+{
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+        stopping = true;
+    }
+    queueCond.notify_one();
+    worker.join();
+
+    delete predictor;
+}
+
+template <typename T>
+boost::unique_future<std::vector<T> > BatchPredictor<T>::submit(const T* x)
+{
+    Request* request = new Request();
+    request->x.assign(x, x+predictor->inputs());
+
+    boost::unique_future<std::vector<T> > ret = request->result.get_future();
+
+    {
+        boost::mutex::scoped_lock lock(queueMutex);
+
+        if(stopping)
+        {
+            delete request;
+            throw gException("BatchPredictor has been stopped");
+        }
+
+        request->submitted = boost::posix_time::microsec_clock::universal_time();
+        queue.push_back(request);
+    }
+    queueCond.notify_one();
+
+    return boost::move(ret);
+}
+
+template <typename T>
+void BatchPredictor<T>::predict(const T* x, T* out)
+{
+    boost::unique_future<std::vector<T> > result = submit(x);
+    const std::vector<T>& y = result.get();
+
+    std::copy(y.begin(), y.end(), out);
+}
+
+template <typename T>
+void BatchPredictor<T>::serve()
+{
+    std::vector<Request*> batch;
+    batch.reserve(maxBatchSize);
+
+    for(;;)
+    {
+        {
+            boost::mutex::scoped_lock lock(queueMutex);
+
+            while(queue.empty() && !stopping)
+                queueCond.wait(lock);
+
+            if(queue.empty())
+                return;
+
+            // the batch is closed when full or when its oldest request expires
+            const boost::posix_time::ptime deadline = queue.front()->submitted + maxWait;
+            while(queue.size() < maxBatchSize && !stopping)
+            {
+                if(boost::posix_time::microsec_clock::universal_time() >= deadline)
+                    break;
+
+                queueCond.timed_wait(lock, deadline);
+            }
+
+            const unsigned long size = std::min(static_cast<unsigned long>(queue.size()), maxBatchSize);
+            batch.assign(queue.begin(), queue.begin()+size);
+            queue.erase(queue.begin(), queue.begin()+size);
+        }
+
+        evaluate(batch);
+    }
+}
+
+template <typename T>
+void BatchPredictor<T>::evaluate(std::vector<Request*>& batch)
+{
+    const unsigned long rows = batch.size();
+    const unsigned long d = predictor->inputs();
+    const unsigned long t = predictor->outputs();
+
+    for(unsigned long i = 0; i < rows; ++i)
+    {
+        const T* x = &(batch[i]->x[0]);
+        for(unsigned long j = 0; j < d; ++j)
+            X[i + rows*j] = x[j];
+    }
+
+    bool failed = false;
+    try
+    {
+        predictor->predictBatch(&X[0], rows, &Y[0], &work[0]);
+    }
+    catch(...)
+    {
+        failed = true;
+        for(unsigned long i = 0; i < rows; ++i)
+            batch[i]->result.set_exception(boost::current_exception());
+    }
+
+    const boost::posix_time::ptime now = boost::posix_time::microsec_clock::universal_time();
+
+    {
+        boost::mutex::scoped_lock lock(statsMutex);
+
+        ++nBatches;
+        statsEnd = now;
+        for(unsigned long i = 0; i < rows; ++i)
+        {
+            const double latency = static_cast<double>((now - batch[i]->submitted).total_microseconds());
+
+            ++nRequests;
+            latencySum += latency;
+            latencyMax = std::max(latencyMax, latency);
+
+            // reservoir sampling: the k-th request replaces a random element with probability latencySamples/k
+            if(latencies.size() < latencySamples)
+                latencies.push_back(latency);
+            else
+            {
+                boost::random::uniform_int_distribution<unsigned long> slot(0, nRequests-1);
+                const unsigned long j = slot(latencyGen);
+                if(j < latencySamples)
+                    latencies[j] = latency;
+            }
+        }
+    }
+
+    for(unsigned long i = 0; i < rows; ++i)
+    {
+        if(!failed)
+        {
+            std::vector<T> y(t);
+            for(unsigned long j = 0; j < t; ++j)
+                y[j] = Y[i + rows*j];
+
+            batch[i]->result.set_value(y);
+        }
+        delete batch[i];
+    }
+    batch.clear();
+}
+
+template <typename T>
+typename BatchPredictor<T>::Stats BatchPredictor<T>::stats() const
+{
+    Stats ret;
+    std::vector<double> lat;
+
+    {
+        boost::mutex::scoped_lock lock(statsMutex);
+
+        lat = latencies;
+        ret.requests = nRequests;
+        ret.batches = nBatches;
+        ret.latencyMean = (nRequests > 0)? latencySum/nRequests: 0.0;
+        ret.latencyMax = latencyMax;
+        const double seconds = (statsEnd - statsBegin).total_microseconds()/1.0e6;
+        ret.throughput = (seconds > 0)? nRequests/seconds: 0.0;
+    }
+
+    ret.meanBatchSize = (ret.batches > 0)? static_cast<double>(ret.requests)/ret.batches: 0.0;
+
+    const unsigned long n = lat.size();
+    if(n == 0)
+    {
+        ret.latencyP50 = ret.latencyP90 = ret.latencyP99 = 0.0;
+        return ret;
+    }
+
+    // nearest-rank percentiles, ascending so that each selection works on the upper part only
+    const double p[] = {0.5, 0.9, 0.99};
+    double* const v[] = {&ret.latencyP50, &ret.latencyP90, &ret.latencyP99};
+    std::vector<double>::iterator begin = lat.begin();
+    for(int i = 0; i < 3; ++i)
+    {
+        std::vector<double>::iterator nth = lat.begin() + std::min(static_cast<unsigned long>(p[i]*n), n-1);
+        std::nth_element(begin, nth, lat.end());
+        *(v[i]) = *nth;
+        begin = nth;
+    }
+
+    return ret;
+}
+
+template <typename T>
+void BatchPredictor<T>::resetStats()
+{
+    boost::mutex::scoped_lock lock(statsMutex);
+
+    nBatches = 0;
+    nRequests = 0;
+    latencySum = latencyMax = 0.0;
+    latencies.clear();
+    statsBegin = statsEnd = boost::posix_time::microsec_clock::universal_time();
+}
+
+}
@@ -88,6 +88,17 @@ float sdot_(int *n, float *x, int *incx, float *y, int *incy);
   */
 void sgemm_(char *transa, char *transb, int *m, int *n, int *k, float *alpha, float *a, int *lda, float *b, int *ldb, float *beta, float *c, int *ldc);
 
+/**
+  * \brief Prototype for Blas SSYRK
+  *
+  * Performs one of the symmetric rank k operations
+  * \f[ C = \alpha A A^T + \beta C\f] or \f[ C = \alpha A^T A + \beta C\f],
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$C\f$ is an n by n symmetric matrix of which
+  * only the upper or lower triangular part is referenced and \f$A\f$ is an n by k matrix in the first case
+  * and a k by n matrix in the second case.
+  */
+void ssyrk_(char *uplo, char *trans, int *n, int *k, float *alpha, float *a, int *lda, float *beta, float *c, int *ldc);
+
 /**
   * \brief Prototype for Blas SGEMV
   *
@@ -145,6 +156,45 @@ void strsm_(char *side, char *uplo, char *transa, char *diag, int *m, int *n, fl
   */
 void sswap_(int *n, float *sx, int *incx, float *sy, int *incy);
 
+/**
+  * \brief Prototype for Blas SGER
+  *
+  * Performs the rank 1 operation
+  * \f[A = \alpha x y^T + A\f]
+  * where \f$\alpha\f$ is a scalar, \f$x\f$ is an m element vector, \f$y\f$ is an n element vector and \f$A\f$ is an m by n matrix.
+  */
+void sger_(int *m, int *n, float *alpha, float *x, int *incx, float *y, int *incy, float *a, int *lda);
+
+/**
+  * \brief Prototype for Blas SSYR
+  *
+  * Performs the symmetric rank 1 operation
+  * \f[A = \alpha x x^T + A\f]
+  * where \f$\alpha\f$ is a scalar, \f$x\f$ is an n element vector and \f$A\f$ is an n by n symmetric matrix
+  * of which only the upper or lower triangular part is referenced and updated.
+  */
+void ssyr_(char *uplo, int *n, float *alpha, float *x, int *incx, float *a, int *lda);
+
+/**
+  * \brief Prototype for Blas SSYMV
+  *
+  * Performs the matrix-vector operation
+  * \f[y = \alpha A x + \beta y\f]
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$x\f$ and \f$y\f$ are n element vectors and \f$A\f$ is an n by n
+  * symmetric matrix of which only the upper or lower triangular part is referenced.
+  */
+void ssymv_(char *uplo, int *n, float *alpha, float *a, int *lda, float *x, int *incx, float *beta, float *y, int *incy);
+
+/**
+  * \brief Prototype for Blas SSYMM
+  *
+  * Performs one of the matrix-matrix operations
+  * \f[C = \alpha A B + \beta C\f] or \f[C = \alpha B A + \beta C\f],
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$A\f$ is a symmetric matrix of which only the upper
+  * or lower triangular part is referenced and \f$B\f$ and \f$C\f$ are m by n matrices.
+  */
+void ssymm_(char *side, char *uplo, int *m, int *n, float *alpha, float *a, int *lda, float *b, int *ldb, float *beta, float *c, int *ldc);
+
 /**
   * \brief Prototype for Blas DDOT
   *
@@ -165,6 +215,17 @@ double ddot_(int *n, double *x, int *incx, double *y, int *incy);
   */
 void dgemm_(char *transa, char *transb, int *m, int *n, int *k, double *alpha, double *a, int *lda, double *b, int *ldb, double *beta, double *c, int *ldc);
 
+/**
+  * \brief Prototype for Blas DSYRK
+  *
+  * Performs one of the symmetric rank k operations
+  * \f[ C = \alpha A A^T + \beta C\f] or \f[ C = \alpha A^T A + \beta C\f],
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$C\f$ is an n by n symmetric matrix of which
+  * only the upper or lower triangular part is referenced and \f$A\f$ is an n by k matrix in the first case
+  * and a k by n matrix in the second case.
+  */
+void dsyrk_(char *uplo, char *trans, int *n, int *k, double *alpha, double *a, int *lda, double *beta, double *c, int *ldc);
+
 /**
   * \brief Prototype for Blas DGEMV
   *
@@ -222,6 +283,45 @@ void dtrsm_(char *side, char *uplo, char *transa, char *diag, int *m, int *n, do
   */
 void dswap_(int *n, double *sx, int *incx, double *sy, int *incy);
 
+/**
+  * \brief Prototype for Blas DGER
+  *
+  * Performs the rank 1 operation
+  * \f[A = \alpha x y^T + A\f]
+  * where \f$\alpha\f$ is a scalar, \f$x\f$ is an m element vector, \f$y\f$ is an n element vector and \f$A\f$ is an m by n matrix.
+  */
+void dger_(int *m, int *n, double *alpha, double *x, int *incx, double *y, int *incy, double *a, int *lda);
+
+/**
+  * \brief Prototype for Blas DSYR
+  *
+  * Performs the symmetric rank 1 operation
+  * \f[A = \alpha x x^T + A\f]
+  * where \f$\alpha\f$ is a scalar, \f$x\f$ is an n element vector and \f$A\f$ is an n by n symmetric matrix
+  * of which only the upper or lower triangular part is referenced and updated.
+  */
+void dsyr_(char *uplo, int *n, double *alpha, double *x, int *incx, double *a, int *lda);
+
+/**
+  * \brief Prototype for Blas DSYMV
+  *
+  * Performs the matrix-vector operation
+  * \f[y = \alpha A x + \beta y\f]
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$x\f$ and \f$y\f$ are n element vectors and \f$A\f$ is an n by n
+  * symmetric matrix of which only the upper or lower triangular part is referenced.
+  */
+void dsymv_(char *uplo, int *n, double *alpha, double *a, int *lda, double *x, int *incx, double *beta, double *y, int *incy);
+
+/**
+  * \brief Prototype for Blas DSYMM
+  *
+  * Performs one of the matrix-matrix operations
+  * \f[C = \alpha A B + \beta C\f] or \f[C = \alpha B A + \beta C\f],
+  * where \f$\alpha\f$ and \f$\beta\f$ are scalars, \f$A\f$ is a symmetric matrix of which only the upper
+  * or lower triangular part is referenced and \f$B\f$ and \f$C\f$ are m by n matrices.
+  */
+void dsymm_(char *side, char *uplo, int *m, int *n, double *alpha, double *a, int *lda, double *b, int *ldb, double *beta, double *c, int *ldc);
+
 
 
 // ------ LAPACK
@@ -132,6 +132,42 @@ void gemm(const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE TransB,
           const T *B, const int ldb,
           const T beta, T *C, const int ldc);
 
+/**
+  * Template function to call BLAS *SYRK routines
+  */
+template<typename T>
+void syrk(const CBLAS_UPLO Uplo, const CBLAS_TRANSPOSE Trans, const int N, const int K,
+          const T alpha, const T *A, const int lda, const T beta, T *C, const int ldc);
+
+/**
+  * Template function to call BLAS *GER routines
+  */
+template<typename T>
+void ger(const int M, const int N, const T alpha, const T *X, const int incX,
+         const T *Y, const int incY, T *A, const int lda);
+
+/**
+  * Template function to call BLAS *SYR routines
+  */
+template<typename T>
+void syr(const CBLAS_UPLO Uplo, const int N, const T alpha, const T *X, const int incX,
+         T *A, const int lda);
+
+/**
+  * Template function to call BLAS *SYMV routines
+  */
+template<typename T>
+void symv(const CBLAS_UPLO Uplo, const int N, const T alpha, const T *A, const int lda,
+          const T *X, const int incX, const T beta, T *Y, const int incY);
+
+/**
+  * Template function to call BLAS *SYMM routines
+  */
+template<typename T>
+void symm(const CBLAS_SIDE Side, const CBLAS_UPLO Uplo, const int M, const int N,
+          const T alpha, const T *A, const int lda, const T *B, const int ldb,
+          const T beta, T *C, const int ldc);
+
 /**
   * Template function to call LAPACK *GEQP3 routines
   */
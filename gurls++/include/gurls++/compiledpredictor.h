@@ -0,0 +1,259 @@
+/*
+  * The GURLS Package in C++
+  *
+  * Copyright (C) 2011-1013, IIT@MIT Lab
+  * All rights reserved.
+  *
+  * author:  M. Santoro
+  * email:   msantoro@mit.edu
+  * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions
+  * are met:
+  *
+  *     * Redistributions of source code must retain the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer.
+  *     * Redistributions in binary form must reproduce the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer in the documentation and/or other materials
+  *       provided with the distribution.
+  *     * Neither the name(s) of the copyright holders nor the names
+  *       of its contributors or of the Massacusetts Institute of
+  *       Technology or of the Italian Institute of Technology may be
+  *       used to endorse or promote products derived from this software
+  *       without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  * POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#ifndef GURLS_COMPILEDPREDICTOR_H
+#define GURLS_COMPILEDPREDICTOR_H
+
+#include "gurls++/gmat2d.h"
+
+#include <string>
+
+#include <boost/cstdint.hpp>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace gurls
+{
+
+/**
+  * \ingroup Wrappers
+  * \brief CompiledPredictor is an immutable snapshot of a trained model, obtained from a wrapper with
+  * GurlsWrapper::compile().
+  *
+  * The snapshot owns a copy of the model parameters, so it is not affected by further training of the wrapper.
+  * Predictions are computed into buffers provided by the caller: the const methods allocate nothing and
+  * can be called concurrently from any number of threads, each with its own work buffer.
+  *
+  * All parameters are kept in a single contiguous buffer with the same layout used by save(), so that
+  * load() can map a saved model in memory instead of reading and parsing it.
+  */
+template<typename T>
+class CompiledPredictor
+{
+public:
+
+    enum ModelType
+    {
+        LINEAR,         ///< f(x) = x*W
+        RANDOMFEATURES, ///< f(x) = [cos(x*P) sin(x*P)]*W
+        RBF,            ///< f(x) = sum_i exp(-||x - x_i||^2/sigma^2) C(i,:)
+        SORF            ///< f(x) = [cos(x*P) sin(x*P)]*W, P structured orthogonal projections generated from a seed
+    };
+
+    /**
+      * Constructor
+      *
+      * \param type model type
+      * \param coefficients W (d x t, or 2D x t for RANDOMFEATURES) or C (n x t for RBF)
+      * \param basis random projections P (d x D) for RANDOMFEATURES, training points x_i (n x d) for RBF, NULL for LINEAR
+      * \param sigma kernel parameter, RBF only
+      * \param meanX,stdX if not NULL, each input x is replaced by (x-meanX)./stdX before evaluation (1 x d)
+      * \param meanY,stdY if not NULL, each output f is replaced by f.*stdY+meanY after evaluation (1 x t)
+      */
+    CompiledPredictor(ModelType type, const gMat2D<T>& coefficients, const gMat2D<T>* basis = NULL, T sigma = 0,
+                      const gMat2D<T>* meanX = NULL, const gMat2D<T>* stdX = NULL,
+                      const gMat2D<T>* meanY = NULL, const gMat2D<T>* stdY = NULL);
+
+    /**
+      * Constructor of a SORF model, based on structured random projections. Only the random signs
+      * defining the projections are stored (see rp_sorf_signs()), instead of the dense d x D matrix.
+      *
+      * \param coefficients W, 2D x t
+      * \param d number of input variables
+      * \param seed seed of the structured projections, the one used for training
+      * \param meanX,stdX if not NULL, each input x is replaced by (x-meanX)./stdX before evaluation (1 x d)
+      * \param meanY,stdY if not NULL, each output f is replaced by f.*stdY+meanY after evaluation (1 x t)
+      */
+    CompiledPredictor(const gMat2D<T>& coefficients, unsigned long d, unsigned long seed,
+                      const gMat2D<T>* meanX = NULL, const gMat2D<T>* stdX = NULL,
+                      const gMat2D<T>* meanY = NULL, const gMat2D<T>* stdY = NULL);
+
+    /**
+      * Destructor
+      */
+    ~CompiledPredictor();
+
+    /**
+      * Returns the model type
+      */
+    ModelType modelType() const {return type;}
+
+    /**
+      * Returns the number of input variables
+      */
+    unsigned long inputs() const {return d;}
+
+    /**
+      * Returns the number of outputs
+      */
+    unsigned long outputs() const {return t;}
+
+    /**
+      * Returns the size of the work buffer needed to evaluate \a rows points at a time
+      */
+    unsigned long workSize(unsigned long rows = 1) const;
+
+    /**
+      * Estimates the outputs for a single input point
+      *
+      * \param[in] x input point, d elements
+      * \param[out] out predicted outputs, t elements
+      * \param work work buffer of size >= workSize(1)
+      */
+    void predict(const T* x, T* out, T* work) const;
+
+    /**
+      * Estimates the outputs for a block of input points
+      *
+      * \param[in] X input matrix, rows x d column major
+      * \param[in] rows number of input points
+      * \param[out] out predicted outputs, rows x t column major
+      * \param work work buffer of size >= workSize(rows)
+      */
+    void predictBatch(const T* X, unsigned long rows, T* out, T* work) const;
+
+    /**
+      * Writes the model to a binary file: a fixed size header followed by the parameters buffer.
+      * The file uses the native byte order and floating point representation.
+      *
+      * \param fileName name of the file where data will be saved
+      */
+    void save(const std::string& fileName) const;
+
+    /**
+      * Maps a model written by save() in memory. The parameters are used directly from the mapped
+      * file, which is paged in on demand.
+      *
+      * \param fileName name of the file containing the model
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    static CompiledPredictor<T>* load(const std::string& fileName);
+
+protected:
+
+    /**
+      * \brief Binary header of a saved model
+      */
+    struct Header
+    {
+        char magic[8];              ///< "GURLSCP"
+        boost::uint32_t version;    ///< Format version
+        boost::uint32_t scalarSize; ///< sizeof(T)
+        boost::uint32_t type;       ///< ModelType
+        boost::uint32_t normalized; ///< Bit 0: input normalization, bit 1: output normalization
+        boost::uint64_t d;          ///< Number of input variables
+        boost::uint64_t t;          ///< Number of outputs
+        boost::uint64_t basisRows;  ///< Rows of the basis matrix, number of random signs (SORF)
+        boost::uint64_t basisCols;  ///< Columns of the basis matrix, number of projections (SORF)
+        double gamma;               ///< 1/sigma^2 (RBF)
+        boost::uint64_t seed;       ///< Seed of the structured projections (SORF)
+        char reserved[56];          ///< Pads the header to 128 bytes, keeping the parameters aligned
+    };
+
+    /**
+      * Empty constructor, used by load()
+      */
+    CompiledPredictor();
+
+    /**
+      * Checks the normalization parameters, allocates the parameters buffer and copies them into it,
+      * the header has to be filled in before
+      */
+    void setup(const gMat2D<T>& coefficients, const gMat2D<T>* basis,
+               const gMat2D<T>* meanX, const gMat2D<T>* stdX, const gMat2D<T>* meanY, const gMat2D<T>* stdY);
+
+    /**
+      * Sets the parameter pointers into \a buffer, following the layout described by \a header
+      */
+    void bind(const Header& header, const T* buffer);
+
+    /**
+      * Returns the number of elements of the parameters buffer described by \a header
+      */
+    static unsigned long bufferSize(const Header& header);
+
+    /**
+      * Computes the number of elements of the parameters buffer described by \a header, which may come
+      * from a corrupted file: every product and sum of its fields is checked before it can wrap around.
+      * Returns false if the buffer would hold more than \a limit elements.
+      */
+    static bool bufferSize(const Header& header, boost::uint64_t limit, boost::uint64_t& size);
+
+    /**
+      * Adds a*b to \a size, returns false if the result would exceed \a limit
+      */
+    static bool addProduct(boost::uint64_t& size, boost::uint64_t a, boost::uint64_t b, boost::uint64_t limit);
+
+    /**
+      * Computes the number of random signs describing \a D structured projections of \a d variables,
+      * as drawn by rp_sorf_signs(). Returns false if \a d is 0 or the number does not fit in 64 bits.
+      */
+    static bool sorfSigns(boost::uint64_t d, boost::uint64_t D, boost::uint64_t& size);
+
+    ModelType type;
+    Header header;              ///< Model description, as saved to file
+
+    const T* coefficients;      ///< W or C
+    const T* basis;             ///< random projections, training points or random signs (SORF)
+    const T* basisNorms;        ///< squared norms of the training points (RBF)
+    const T* meanX;             ///< input means, NULL if inputs are not normalized
+    const T* stdX;              ///< input standard deviations
+    const T* meanY;             ///< output means, NULL if outputs are not normalized
+    const T* stdY;              ///< output standard deviations
+
+    T gamma;                    ///< 1/sigma^2 (RBF)
+    unsigned long d;            ///< number of input variables
+    unsigned long t;            ///< number of outputs
+
+    T* storage;                 ///< parameters buffer, when owned
+    boost::interprocess::file_mapping* mapping;  ///< mapped file, when loaded
+    boost::interprocess::mapped_region* region;  ///< mapped parameters, when loaded
+
+private:
+    CompiledPredictor(const CompiledPredictor<T>&);
+    CompiledPredictor<T>& operator=(const CompiledPredictor<T>&);
+};
+
+}
+
+#include "gurls++/compiledpredictor.hpp"
+
+#endif //GURLS_COMPILEDPREDICTOR_H
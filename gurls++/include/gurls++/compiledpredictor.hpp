@@ -0,0 +1,512 @@
+#include "gurls++/compiledpredictor.h"
+#include "gurls++/gmath.h"
+#include "gurls++/utils.h"
+#include "gurls++/exceptions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace gurls
+{
+
+template <typename T>
+CompiledPredictor<T>::CompiledPredictor():
+    type(LINEAR), coefficients(NULL), basis(NULL), basisNorms(NULL), meanX(NULL), stdX(NULL), meanY(NULL), stdY(NULL),
+    gamma(0), d(0), t(0), storage(NULL), mapping(NULL), region(NULL)
+{
+    memset(&header, 0, sizeof(Header));
+}
+
+template <typename T>
+CompiledPredictor<T>::CompiledPredictor(ModelType type, const gMat2D<T>& coefficients, const gMat2D<T>* basis, T sigma,
+                                        const gMat2D<T>* meanX, const gMat2D<T>* stdX,
+                                        const gMat2D<T>* meanY, const gMat2D<T>* stdY):
+    type(type), coefficients(NULL), basis(NULL), basisNorms(NULL), meanX(NULL), stdX(NULL), meanY(NULL), stdY(NULL),
+    gamma(0), d(0), t(0), storage(NULL), mapping(NULL), region(NULL)
+{
+    memset(&header, 0, sizeof(Header));
+    strcpy(header.magic, "GURLSCP");
+    header.version = 1;
+    header.scalarSize = sizeof(T);
+    header.type = type;
+    header.t = coefficients.cols();
+
+    switch(type)
+    {
+    case LINEAR:
+        header.d = coefficients.rows();
+        break;
+
+    case RANDOMFEATURES:
+        if(basis == NULL || 2*basis->cols() != coefficients.rows())
+            throw gException(Exception_Inconsistent_Size);
+
+        header.d = basis->rows();
+        header.basisRows = basis->rows();
+        header.basisCols = basis->cols();
+        break;
+
+    case RBF:
+        if(basis == NULL || basis->rows() != coefficients.rows())
+            throw gException(Exception_Inconsistent_Size);
+
+        if(sigma <= 0)
+            throw gException(Exception_Illegal_Argument_Value);
+
+        header.d = basis->cols();
+        header.basisRows = basis->rows();
+        header.basisCols = basis->cols();
+        header.gamma = 1.0/(sigma*sigma);
+        break;
+
+    default:
+        throw gException(Exception_Illegal_Argument_Value);
+    }
+
+    setup(coefficients, basis, meanX, stdX, meanY, stdY);
+}
+
+template <typename T>
+CompiledPredictor<T>::CompiledPredictor(const gMat2D<T>& coefficients, unsigned long d, unsigned long seed,
+                                        const gMat2D<T>* meanX, const gMat2D<T>* stdX,
+                                        const gMat2D<T>* meanY, const gMat2D<T>* stdY):
+    type(SORF), coefficients(NULL), basis(NULL), basisNorms(NULL), meanX(NULL), stdX(NULL), meanY(NULL), stdY(NULL),
+    gamma(0), d(0), t(0), storage(NULL), mapping(NULL), region(NULL)
+{
+    if(d == 0 || coefficients.rows() % 2 != 0)
+        throw gException(Exception_Inconsistent_Size);
+
+    const unsigned long D = coefficients.rows()/2;
+
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
+
+    memset(&header, 0, sizeof(Header));
+    strcpy(header.magic, "GURLSCP");
+    header.version = 1;
+    header.scalarSize = sizeof(T);
+    header.type = SORF;
+    header.t = coefficients.cols();
+    header.d = d;
+    header.basisRows = 3*pow2*((D+pow2-1)/pow2);
+    header.basisCols = D;
+    header.seed = seed;
+
+    T* signs = rp_sorf_signs<T>(d, D, seed);
+    gMat2D<T> signs_mat(signs, header.basisRows, 1, true);
+
+    setup(coefficients, &signs_mat, meanX, stdX, meanY, stdY);
+}
+
+template <typename T>
+void CompiledPredictor<T>::setup(const gMat2D<T>& coefficients, const gMat2D<T>* basis,
+                                 const gMat2D<T>* meanX, const gMat2D<T>* stdX, const gMat2D<T>* meanY, const gMat2D<T>* stdY)
+{
+    if((meanX == NULL) != (stdX == NULL) || (meanY == NULL) != (stdY == NULL))
+        throw gException(Exception_Required_Parameter_Missing);
+
+    if(meanX != NULL)
+    {
+        if(meanX->getSize() != header.d || stdX->getSize() != header.d)
+            throw gException(Exception_Inconsistent_Size);
+        header.normalized |= 1;
+    }
+
+    if(meanY != NULL)
+    {
+        if(meanY->getSize() != header.t || stdY->getSize() != header.t)
+            throw gException(Exception_Inconsistent_Size);
+        header.normalized |= 2;
+    }
+
+    storage = new T[std::max(bufferSize(header), 1ul)];
+    bind(header, storage);
+
+    copy(storage, coefficients.getData(), coefficients.getSize());
+
+    if(basis != NULL)
+        copy(const_cast<T*>(this->basis), basis->getData(), basis->getSize());
+
+    if(type == RBF)
+        sum_col_squared(this->basis, const_cast<T*>(basisNorms), header.basisRows, d);
+
+    if(meanX != NULL)
+    {
+        copy(const_cast<T*>(this->meanX), meanX->getData(), d);
+        copy(const_cast<T*>(this->stdX), stdX->getData(), d);
+    }
+
+    if(meanY != NULL)
+    {
+        copy(const_cast<T*>(this->meanY), meanY->getData(), t);
+        copy(const_cast<T*>(this->stdY), stdY->getData(), t);
+    }
+}
+
+template <typename T>
+CompiledPredictor<T>::~CompiledPredictor()
+{
+    delete [] storage;
+    delete region;
+    delete mapping;
+}
+
+template <typename T>
+unsigned long CompiledPredictor<T>::bufferSize(const Header& header)
+{
+    boost::uint64_t size = 0;
+    bufferSize(header, std::numeric_limits<boost::uint64_t>::max(), size);
+
+    return static_cast<unsigned long>(size);
+}
+
+template <typename T>
+bool CompiledPredictor<T>::bufferSize(const Header& header, boost::uint64_t limit, boost::uint64_t& size)
+{
+    size = 0;
+
+    bool ok;
+    switch(header.type)
+    {
+    case RANDOMFEATURES:
+    case SORF:
+        // coefficients, 2*basisCols x t
+        ok = addProduct(size, header.basisCols, header.t, limit) && addProduct(size, header.basisCols, header.t, limit);
+        break;
+    case RBF:
+        // coefficients, basisRows x t, and the norms of the training points
+        ok = addProduct(size, header.basisRows, header.t, limit) && addProduct(size, header.basisRows, 1, limit);
+        break;
+    default:
+        ok = addProduct(size, header.d, header.t, limit);
+    }
+
+    // the signs of the structured projections are stored in place of the basis
+    if(header.type == SORF)
+        ok = ok && addProduct(size, header.basisRows, 1, limit);
+    else
+        ok = ok && addProduct(size, header.basisRows, header.basisCols, limit);
+
+    if(header.normalized & 1)
+        ok = ok && addProduct(size, header.d, 2, limit);
+    if(header.normalized & 2)
+        ok = ok && addProduct(size, header.t, 2, limit);
+
+    return ok;
+}
+
+template <typename T>
+bool CompiledPredictor<T>::addProduct(boost::uint64_t& size, boost::uint64_t a, boost::uint64_t b, boost::uint64_t limit)
+{
+    // size <= limit on entry, so limit-size does not wrap around
+    if(a != 0 && b > (limit - size)/a)
+        return false;
+
+    size += a*b;
+    return true;
+}
+
+template <typename T>
+bool CompiledPredictor<T>::sorfSigns(boost::uint64_t d, boost::uint64_t D, boost::uint64_t& size)
+{
+    const boost::uint64_t limit = std::numeric_limits<boost::uint64_t>::max();
+
+    if(d == 0)
+        return false;
+
+    boost::uint64_t pow2 = 1;
+    while(pow2 < d)
+    {
+        if(pow2 > limit/2)
+            return false;
+
+        pow2 <<= 1;
+    }
+
+    // 3*pow2*ceil(D/pow2)
+    boost::uint64_t blockSize = 0;
+    size = 0;
+
+    return addProduct(blockSize, pow2, 3, limit) && addProduct(size, blockSize, D/pow2 + ((D%pow2 != 0)? 1 : 0), limit);
+}
+
+template <typename T>
+void CompiledPredictor<T>::bind(const Header& header, const T* buffer)
+{
+    type = static_cast<ModelType>(header.type);
+    d = header.d;
+    t = header.t;
+    gamma = static_cast<T>(header.gamma);
+
+    unsigned long coeffRows = d;
+    if(type == RANDOMFEATURES || type == SORF)
+        coeffRows = 2*header.basisCols;
+    else if(type == RBF)
+        coeffRows = header.basisRows;
+
+    const T* it = buffer;
+
+    coefficients = it;
+    it += coeffRows*t;
+
+    basis = (type != LINEAR)? it: NULL;
+    it += (type == SORF)? header.basisRows: header.basisRows*header.basisCols;
+
+    if(type == RBF)
+    {
+        basisNorms = it;
+        it += header.basisRows;
+    }
+
+    if(header.normalized & 1)
+    {
+        meanX = it;
+        stdX = it + d;
+        it += 2*d;
+    }
+
+    if(header.normalized & 2)
+    {
+        meanY = it;
+        stdY = it + t;
+    }
+}
+
+template <typename T>
+void CompiledPredictor<T>::save(const std::string& fileName) const
+{
+    std::ofstream out(fileName.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    if(!out.is_open())
+        throw gException("Could not open file " + fileName);
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+    out.write(reinterpret_cast<const char*>(coefficients), bufferSize(header)*sizeof(T));
+
+    if(!out.good())
+        throw gException("Error writing file " + fileName);
+}
+
+template <typename T>
+CompiledPredictor<T>* CompiledPredictor<T>::load(const std::string& fileName)
+{
+    using namespace boost::interprocess;
+
+    CompiledPredictor<T>* ret = new CompiledPredictor<T>();
+
+    try
+    {
+        ret->mapping = new file_mapping(fileName.c_str(), read_only);
+        ret->region = new mapped_region(*(ret->mapping), read_only);
+    }
+    catch(interprocess_exception& e)
+    {
+        delete ret;
+        throw gException("Could not map file " + fileName + ": " + e.what());
+    }
+
+    const char* data = static_cast<const char*>(ret->region->get_address());
+    const std::size_t size = ret->region->get_size();
+
+    if(size < sizeof(Header))
+    {
+        delete ret;
+        throw gException("Invalid model file " + fileName);
+    }
+
+    memcpy(&(ret->header), data, sizeof(Header));
+    const Header& header = ret->header;
+
+    if(memcmp(header.magic, "GURLSCP", sizeof(header.magic)) != 0 || header.version != 1 || header.type > SORF)
+    {
+        delete ret;
+        throw gException("Invalid model file " + fileName);
+    }
+
+    boost::uint64_t elements;
+    if(header.scalarSize != sizeof(T) || !bufferSize(header, (size - sizeof(Header))/sizeof(T), elements))
+    {
+        delete ret;
+        throw gException(Exception_Inconsistent_Size);
+    }
+
+    // the basis is walked through according to d, it has to match it
+    bool consistent;
+    boost::uint64_t signs;
+    switch(header.type)
+    {
+    case RANDOMFEATURES:
+        consistent = (header.basisRows == header.d);
+        break;
+    case RBF:
+        consistent = (header.basisCols == header.d);
+        break;
+    case SORF:
+        consistent = sorfSigns(header.d, header.basisCols, signs) && signs == header.basisRows;
+        break;
+    default:
+        consistent = true;
+    }
+
+    if(!consistent)
+    {
+        delete ret;
+        throw gException("Invalid model file " + fileName);
+    }
+
+    ret->bind(header, reinterpret_cast<const T*>(data + sizeof(Header)));
+
+    return ret;
+}
+
+template <typename T>
+unsigned long CompiledPredictor<T>::workSize(unsigned long rows) const
+{
+    const unsigned long normalization = (meanX != NULL)? rows*d : 0;
+
+    switch(type)
+    {
+    case RANDOMFEATURES:
+        return normalization + rows*2*header.basisCols;
+    case SORF:
+    {
+        unsigned long pow2 = 1;
+        while(pow2 < d)
+            pow2 <<= 1;
+
+        // one more row for the Walsh-Hadamard transforms
+        return normalization + rows*2*header.basisCols + pow2;
+    }
+    case RBF:
+        return normalization + rows*(header.basisRows + 1);
+    default:
+        return normalization;
+    }
+}
+
+template <typename T>
+void CompiledPredictor<T>::predict(const T* x, T* out, T* work) const
+{
+    // a point is a 1 x d column major matrix
+    predictBatch(x, 1, out, work);
+}
+
+template <typename T>
+void CompiledPredictor<T>::predictBatch(const T* X, unsigned long rows, T* out, T* work) const
+{
+    if(rows == 0)
+        return;
+
+    const int m = static_cast<int>(rows);
+
+    if(meanX != NULL)
+    {
+//        X = (X - repmat(meanX, n, 1))./repmat(stdX, n, 1);
+        T* Xn = work;
+        work += rows*d;
+
+        for(unsigned long j = 0; j < d; ++j)
+        {
+            const T* X_j = X + rows*j;
+            T* Xn_j = Xn + rows*j;
+            for(unsigned long i = 0; i < rows; ++i)
+                Xn_j[i] = (X_j[i] - meanX[j])/stdX[j];
+        }
+
+        X = Xn;
+    }
+
+    switch(type)
+    {
+    case LINEAR:
+    {
+//        Z = X*W;
+        gemm(CblasNoTrans, CblasNoTrans, m, (int)t, (int)d, (T)1.0, X, m, coefficients, (int)d, (T)0.0, out, m);
+        break;
+    }
+    case RANDOMFEATURES:
+    {
+        const unsigned long D = header.basisCols;
+
+//        V = X*P;
+        T* V = work + rows*D;
+        gemm(CblasNoTrans, CblasNoTrans, m, (int)D, (int)d, (T)1.0, X, m, basis, (int)d, (T)0.0, V, m);
+
+//        G = [cos(V) sin(V)];
+        for(T *G_it = work, *const V_end = V+(rows*D); V != V_end; ++G_it, ++V)
+        {
+            *G_it = cos(*V);
+            *V = sin(*V);
+        }
+
+//        Z = G*W;
+        gemm(CblasNoTrans, CblasNoTrans, m, (int)t, (int)(2*D), (T)1.0, work, m, coefficients, (int)(2*D), (T)0.0, out, m);
+        break;
+    }
+    case SORF:
+    {
+        const unsigned long D = header.basisCols;
+
+//        V = X*P;
+        T* V = work + rows*D;
+        rp_sorf_project(X, rows, rows, d, D, basis, V, rows, work + rows*2*D);
+
+//        G = [cos(V) sin(V)];
+        for(T *G_it = work, *const V_end = V+(rows*D); V != V_end; ++G_it, ++V)
+        {
+            *G_it = cos(*V);
+            *V = sin(*V);
+        }
+
+//        Z = G*W;
+        gemm(CblasNoTrans, CblasNoTrans, m, (int)t, (int)(2*D), (T)1.0, work, m, coefficients, (int)(2*D), (T)0.0, out, m);
+        break;
+    }
+    case RBF:
+    {
+        const unsigned long n = header.basisRows;
+
+        T* K = work;
+        T* norms = work + rows*n;
+
+        // ||x - x_i||^2 = ||x||^2 + ||x_i||^2 - 2 x*x_i'
+        gemm(CblasNoTrans, CblasTrans, m, (int)n, (int)d, (T)-2.0, X, m, basis, (int)n, (T)0.0, K, m);
+
+        std::fill(norms, norms+rows, (T)0.0);
+        for(unsigned long k = 0; k < d; ++k)
+        {
+            const T* X_k = X + rows*k;
+            for(unsigned long i = 0; i < rows; ++i)
+                norms[i] += X_k[i]*X_k[i];
+        }
+
+//        K = exp(-distance/sigma^2);
+        for(unsigned long j = 0; j < n; ++j)
+        {
+            T* K_j = K + rows*j;
+            for(unsigned long i = 0; i < rows; ++i)
+                K_j[i] = std::exp(-std::max(K_j[i] + norms[i] + basisNorms[j], (T)0.0)*gamma);
+        }
+
+//        Z = K*C;
+        gemm(CblasNoTrans, CblasNoTrans, m, (int)t, (int)n, (T)1.0, K, m, coefficients, (int)n, (T)0.0, out, m);
+        break;
+    }
+    }
+
+    if(meanY != NULL)
+    {
+//        Z = Z.*repmat(stdY, n, 1) + repmat(meanY, n, 1);
+        for(unsigned long j = 0; j < t; ++j)
+        {
+            T* out_j = out + rows*j;
+            for(unsigned long i = 0; i < rows; ++i)
+                out_j[i] = out_j[i]*stdY[j] + meanY[j];
+        }
+    }
+}
+
+}
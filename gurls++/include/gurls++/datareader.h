@@ -0,0 +1,328 @@
+/*
+  * The GURLS Package in C++
+  *
+  * Copyright (C) 2011-1013, IIT@MIT Lab
+  * All rights reserved.
+  *
+  * author:  M. Santoro
+  * email:   msantoro@mit.edu
+  * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions
+  * are met:
+  *
+  *     * Redistributions of source code must retain the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer.
+  *     * Redistributions in binary form must reproduce the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer in the documentation and/or other materials
+  *       provided with the distribution.
+  *     * Neither the name(s) of the copyright holders nor the names
+  *       of its contributors or of the Massacusetts Institute of
+  *       Technology or of the Italian Institute of Technology may be
+  *       used to endorse or promote products derived from this software
+  *       without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  * POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#ifndef GURLS_DATAREADER_H
+#define GURLS_DATAREADER_H
+
+#include "gurls++/gmat2d.h"
+#include "gurls++/gmath.h"
+#include "gurls++/exceptions.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/tokenizer.hpp>
+#include <boost/lexical_cast.hpp>
+
+namespace gurls
+{
+
+/**
+  * \ingroup Common
+  * \brief DataReader is the interface for sources of data matrices that are read
+  * sequentially in blocks of rows, so that they never need to fit in memory.
+  */
+template<typename T>
+class DataReader
+{
+public:
+    virtual ~DataReader() {}
+
+    /**
+      * Returns the number of columns of the matrix
+      */
+    virtual unsigned long cols() const = 0;
+
+    /**
+      * Reads the next block of rows
+      *
+      * \param[out] block buffer where the rows are stored, column major with leading dimension \a ld
+      * \param[in] ld leading dimension of \a block
+      * \param[in] maxRows maximum number of rows to read, not greater than \a ld
+      * \returns number of rows actually read, 0 when all the data have been read
+      */
+    virtual unsigned long read(T* block, unsigned long ld, unsigned long maxRows) = 0;
+};
+
+/**
+  * \ingroup Common
+  * \brief MatrixReader reads blocks of rows from a matrix in memory.
+  */
+template<typename T>
+class MatrixReader: public DataReader<T>
+{
+public:
+    /**
+      * Constructor
+      *
+      * \param M matrix to be read. It is not copied, so it must outlive the reader.
+      */
+    MatrixReader(const gMat2D<T>& M): matrix(M), next(0) {}
+
+    unsigned long cols() const
+    {
+        return matrix.cols();
+    }
+
+    unsigned long read(T* block, unsigned long ld, unsigned long maxRows)
+    {
+        const unsigned long n = matrix.rows();
+        const unsigned long rows = std::min(maxRows, n-next);
+
+        for(unsigned long j=0; j<matrix.cols(); ++j)
+            copy(block+(j*ld), matrix.getData()+(j*n)+next, rows);
+
+        next += rows;
+        return rows;
+    }
+
+protected:
+    const gMat2D<T>& matrix;  ///< Matrix to be read
+    unsigned long next;       ///< Next row to be read
+};
+
+/**
+  * \ingroup Common
+  * \brief CSVReader reads blocks of rows from a text file with one row per line,
+  * in the same format accepted by gMat2D::readCSV.
+  */
+template<typename T>
+class CSVReader: public DataReader<T>
+{
+public:
+    /**
+      * Constructor, opens the file and counts the columns of its first row
+      */
+    CSVReader(const std::string& fileName): in(fileName.c_str()), numCols(0), sep(" ;|,")
+    {
+        if(!in.is_open())
+            throw gException("Cannot open file " + fileName);
+
+        std::string line;
+        while(numCols == 0 && std::getline(in, line))
+        {
+            tokenizer tokens(line, sep);
+            numCols = std::distance(tokens.begin(), tokens.end());
+        }
+
+        in.clear();
+        in.seekg(0);
+    }
+
+    unsigned long cols() const
+    {
+        return numCols;
+    }
+
+    unsigned long read(T* block, unsigned long ld, unsigned long maxRows)
+    {
+        unsigned long rows = 0;
+        std::string line;
+
+        while(rows < maxRows && std::getline(in, line))
+        {
+            if(line.empty())
+                continue;
+
+            tokenizer tokens(line, sep);
+
+            unsigned long j = 0;
+            for(tokenizer::iterator it = tokens.begin(); it != tokens.end(); ++it, ++j)
+            {
+                if(j == numCols)
+                    throw gException(Exception_Inconsistent_Size);
+
+                block[rows + j*ld] = boost::lexical_cast<T>(*it);
+            }
+
+            if(j == 0)
+                continue;
+
+            if(j != numCols)
+                throw gException(Exception_Inconsistent_Size);
+
+            ++rows;
+        }
+
+        return rows;
+    }
+
+protected:
+    typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
+
+    std::ifstream in;                   ///< Input file
+    unsigned long numCols;              ///< Number of columns
+    boost::char_separator<char> sep;    ///< Field separators
+};
+
+/**
+  * \ingroup Common
+  * \brief BinaryReader reads blocks of rows from a matrix saved with gMat2D::save.
+  *
+  * Matrices are stored column major, so each block is read with one seek per column.
+  * Only binary archives (USE_BINARY_ARCHIVES) can be read this way.
+  */
+template<typename T>
+class BinaryReader: public DataReader<T>
+{
+public:
+    /**
+      * Constructor, opens the file and reads the matrix size
+      */
+    BinaryReader(const std::string& fileName): numRows(0), numCols(0), next(0)
+    {
+#ifndef USE_BINARY_ARCHIVES
+        throw gException("Reading " + fileName + " in blocks of rows requires binary archives");
+#else
+        in.open(fileName.c_str(), std::ios_base::binary);
+
+        if(!in.is_open())
+            throw gException("Could not open file " + fileName);
+
+        try
+        {
+            Header header;
+            iarchive inar(in);
+            inar >> header;
+
+            numRows = header.rows;
+            numCols = header.cols;
+        }
+        catch(boost::archive::archive_exception&)
+        {
+            throw gException("Invalid file format for " + fileName);
+        }
+
+        dataStart = in.tellg();
+#endif
+    }
+
+    unsigned long cols() const
+    {
+        return numCols;
+    }
+
+    unsigned long read(T* block, unsigned long ld, unsigned long maxRows)
+    {
+        const unsigned long rows = std::min(maxRows, numRows-next);
+
+        for(unsigned long j=0; j<numCols && rows>0; ++j)
+        {
+            in.seekg(dataStart + static_cast<std::streamoff>((j*numRows + next)*sizeof(T)));
+            in.read(reinterpret_cast<char*>(block+(j*ld)), rows*sizeof(T));
+
+            if(!in)
+                throw gException("Unexpected end of file");
+        }
+
+        next += rows;
+        return rows;
+    }
+
+protected:
+    /**
+      * Leading fields of a serialized gMat2D, read with the same archive preamble
+      */
+    struct Header
+    {
+        unsigned long rows;
+        unsigned long cols;
+
+        template<class Archive>
+        void serialize(Archive & ar, const unsigned int /* file_version */)
+        {
+            bool isowner;
+            ar & rows & cols & isowner;
+        }
+    };
+
+    std::ifstream in;           ///< Input file
+    std::streampos dataStart;   ///< Position of the first element
+    unsigned long numRows;      ///< Number of rows
+    unsigned long numCols;      ///< Number of columns
+    unsigned long next;         ///< Next row to be read
+};
+
+/**
+  * \ingroup Common
+  * \brief CallbackReader reads blocks of rows through a user supplied function.
+  */
+template<typename T>
+class CallbackReader: public DataReader<T>
+{
+public:
+    /**
+      * Signature of the reading function, with the same semantics of DataReader::read().
+      * \a userData is passed unchanged.
+      */
+    typedef unsigned long (*Callback)(T* block, unsigned long ld, unsigned long maxRows, void* userData);
+
+    /**
+      * Constructor
+      *
+      * \param cols number of columns of the matrix
+      * \param callback function reading a block of rows
+      * \param userData pointer passed to \a callback
+      */
+    CallbackReader(unsigned long cols, Callback callback, void* userData = NULL):
+        numCols(cols), callback(callback), userData(userData) {}
+
+    unsigned long cols() const
+    {
+        return numCols;
+    }
+
+    unsigned long read(T* block, unsigned long ld, unsigned long maxRows)
+    {
+        return callback(block, ld, maxRows, userData);
+    }
+
+protected:
+    unsigned long numCols;  ///< Number of columns
+    Callback callback;      ///< Reading function
+    void* userData;         ///< User data passed to the reading function
+};
+
+}
+
+#endif // GURLS_DATAREADER_H
@@ -54,6 +54,7 @@
 
 #include "gurls++/pred.h"
 #include "gurls++/primal.h"
+#include "gurls++/balltree.h"
 
 
 namespace gurls {
@@ -67,6 +68,15 @@ template <typename T>
 class PredDual: public Prediction<T> {
 
 public:
+    /**
+      * Constructor
+      *
+      * \param index optional BallTree over optimizer.X, reused by the truncated rbf prediction.
+      * It is not owned by the task and it is ignored if its size does not match optimizer.X;
+      * if NULL the tree is built on each call to execute()
+      */
+    PredDual(const BallTree<T>* index = NULL): index(index) {}
+
     /**
      * Computes the predictions of the linear classifier stored in opt.W and computed using the primal formulation, on the samples passed in the X matrix.
      * \param X input data matrix
@@ -75,10 +85,23 @@ public:
      *  - Kernel (default)
      *  - C, X, W (settable with the class Optimizers and its subclasses RLSDual)
      *  - predkernel (required only if the subfield type of Kernel is different than "linear", and settable with the class PredKernel and its subclasses PredKernelTrainTest)
+     *  - pred_tolerance (default 0). If positive and the subfield type of Kernel is "rbf", predkernel is not used:
+     *    the predictions are computed from optimizer.X and paramsel.sigma with the truncated kernel expansion
+     *    (see executeTruncated), with absolute error at most pred_tolerance
      *
      * \return pred matrix of predicted labels
      */
     OptMatrix<gMat2D<T> >* execute( const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList& opt);
+
+protected:
+    /**
+      * Computes the predictions of a rbf model keeping only the training points closer than a cutoff radius r
+      * to each test point, found with a BallTree over optimizer.X (the one given to the constructor, if any). Dropping point i changes the predictions
+      * by at most exp(-r^2/sigma^2)*|C(i,:)|, so r is chosen as r^2 = sigma^2*log(max_j(sum_i |C(i,j)|)/tol).
+      */
+    gMat2D<T>* executeTruncated(const gMat2D<T>& X, const GurlsOptionsList& opt, const T tol);
+
+    const BallTree<T>* index;   ///< Prebuilt index over optimizer.X, NULL if none
 };
 
 template <typename T>
@@ -91,6 +114,10 @@ OptMatrix<gMat2D<T> >* PredDual<T>::execute(const gMat2D<T>& X, const gMat2D<T>&
             PredPrimal<T> pred;
             return pred.execute(X, Y, opt);
         }
+
+        const T tol = opt.hasOpt("pred_tolerance")? static_cast<T>(opt.getOptAsNumber("pred_tolerance")): (T)0.0;
+        if(tol > 0 && opt.getOptValue<OptString>("kernel.type") == "rbf")
+            return new OptMatrix<gMat2D<T> >(*executeTruncated(X, opt, tol));
     }
 
     const gMat2D<T> &K = opt.getOptValue<OptMatrix<gMat2D<T> > >("predkernel.K");
@@ -104,6 +131,83 @@ OptMatrix<gMat2D<T> >* PredDual<T>::execute(const gMat2D<T>& X, const gMat2D<T>&
     return new OptMatrix<gMat2D<T> >(*Z);
 }
 
+template <typename T>
+gMat2D<T>* PredDual<T>::executeTruncated(const gMat2D<T>& X, const GurlsOptionsList& opt, const T tol)
+{
+    const gMat2D<T> &rls_X = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X");
+    const gMat2D<T> &C = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.C");
+    const T sigma = static_cast<T>(opt.getOptAsNumber("paramsel.sigma"));
+
+    const unsigned long n = X.rows();
+    const unsigned long d = X.cols();
+    const unsigned long nt = C.rows();
+    const unsigned long t = C.cols();
+
+    if(rls_X.cols() != d || rls_X.rows() != nt)
+        throw gException(Exception_Inconsistent_Size);
+
+    gMat2D<T>* Z = new gMat2D<T>(n, t);
+    set(Z->getData(), (T)0.0, n*t);
+
+//    bound = max(sum(abs(C)));
+    T bound = 0;
+    for(unsigned long j = 0; j < t; ++j)
+    {
+        const T* C_j = C.getData() + nt*j;
+        T sum = 0;
+        for(unsigned long i = 0; i < nt; ++i)
+            sum += std::abs(C_j[i]);
+        bound = std::max(bound, sum);
+    }
+
+    // every kernel term is below tolerance
+    if(bound <= tol)
+        return Z;
+
+    const T gamma = (T)1.0/(sigma*sigma);
+    const T radius2 = sigma*sigma*std::log(bound/tol);
+
+    const BallTree<T>* tree = index;
+    if(tree == NULL || tree->size() != nt || tree->dims() != d)
+        tree = new BallTree<T>(rls_X.getData(), nt, d);
+
+    const T* const X_data = X.getData();
+    const T* const C_data = C.getData();
+    T* const Z_data = Z->getData();
+
+#pragma omp parallel
+    {
+        std::vector<T> x(d);
+        std::vector<unsigned long> indices;
+        std::vector<T> distances2;
+        std::vector<unsigned long> stack;
+
+#pragma omp for schedule(dynamic, 16)
+        for(long i = 0; i < static_cast<long>(n); ++i)
+        {
+            for(unsigned long k = 0; k < d; ++k)
+                x[k] = X_data[i + n*k];
+
+            tree->rangeSearch(&x[0], radius2, indices, distances2, stack);
+
+//            Z(i,:) = exp(-distance/sigma^2)*C(neighbors,:);
+            for(unsigned long h = 0; h < indices.size(); ++h)
+            {
+                const T K_ih = std::exp(-distances2[h]*gamma);
+                const T* C_it = C_data + indices[h];
+                T* Z_it = Z_data + i;
+                for(unsigned long j = 0; j < t; ++j, C_it += nt, Z_it += n)
+                    *Z_it += K_ih*(*C_it);
+            }
+        }
+    }
+
+    if(tree != index)
+        delete tree;
+
+    return Z;
+}
+
 }
 
 #endif // _GURLS_DUAL_H
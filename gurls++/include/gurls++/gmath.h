@@ -1185,6 +1185,67 @@ void indicesOfMax(const T* A, const int A_rows, const int A_cols, unsigned long*
 
 }
 
+/**
+  * Returns the indices of the largest elements of each row of a matrix, as indicesOfMax with dimension == 2,
+  * visiting the matrix once by columns instead of transposing it.
+  *
+  * \param A input matrix
+  * \param rows number of rows of the input matrix
+  * \param cols number of columns of the input matrix
+  * \param ind vector of length rows containing the computed indices (the first one in case of ties)
+  * \param maxv vector of length rows containing the largest elements
+  */
+template<typename T>
+void rowIndicesOfMax(const T* A, const unsigned long rows, const unsigned long cols, unsigned long* ind, T* maxv)
+{
+    if(cols == 0)
+        return;
+
+    copy(maxv, A, rows);
+    std::fill(ind, ind+rows, 0ul);
+
+    const T* col = A+rows;
+    for(unsigned long j = 1; j < cols; ++j, col += rows)
+    {
+        for(unsigned long i = 0; i < rows; ++i)
+        {
+            if(maxv[i] < col[i])
+            {
+                maxv[i] = col[i];
+                ind[i] = j;
+            }
+        }
+    }
+}
+
+/**
+  * Computes the position that a given element of each row of a matrix would take if the row were sorted
+  * in descending order, ties broken by column index. The element of row i is among the k largest of the row
+  * if and only if ranks[i] < k.
+  *
+  * The matrix is visited once by columns, in O(rows*cols) time and without sorting.
+  *
+  * \param A input matrix
+  * \param rows number of rows of the input matrix
+  * \param cols number of columns of the input matrix
+  * \param ind vector of length rows containing the column of the element of each row
+  * \param ranks vector of length rows containing the computed positions, starting from 0
+  * \param work work buffer of size >= rows
+  */
+template<typename T>
+void rowRanks(const T* A, const unsigned long rows, const unsigned long cols, const unsigned long* ind, unsigned long* ranks, T* work)
+{
+    for(unsigned long i = 0; i < rows; ++i)
+        work[i] = A[i + rows*ind[i]];
+
+    std::fill(ranks, ranks+rows, 0ul);
+
+    const T* col = A;
+    for(unsigned long j = 0; j < cols; ++j, col += rows)
+        for(unsigned long i = 0; i < rows; ++i)
+            ranks[i] += (col[i] > work[i]) || (col[i] == work[i] && j < ind[i]);
+}
+
 /**
   * Returns the largest elements along different dimensions of a matrix.
   *
@@ -1435,6 +1496,25 @@ void randperm(const unsigned long n, T* seq, bool generate = true, unsigned long
         std::swap(seq[rand()%n], seq[rand()%n]);
 }
 
+/**
+  * In place, unnormalized fast Walsh-Hadamard transform of a vector
+  *
+  * \param v vector. On exit it contains H*v, where H is the Hadamard matrix of order \c length
+  * \param length number of elements of v, must be a power of 2
+  */
+template<typename T>
+void fwht(T* v, const unsigned long length)
+{
+    for(unsigned long h = 1; h < length; h <<= 1)
+        for(unsigned long i = 0; i < length; i += (h << 1))
+            for(T *a = v+i, *b = v+i+h, *const end = v+i+h; a != end; ++a, ++b)
+            {
+                const T sum = *a + *b;
+                *b = *a - *b;
+                *a = sum;
+            }
+}
+
 /**
   * Generates a vector containing a copy of a row of an input matrix
   *
@@ -58,6 +58,13 @@ public:
       */
     gMat2D<T>* eval(const gMat2D<T> &X, gMat2D<T> &vars);
 
+    /**
+      * Takes an immutable snapshot of the trained model, which computes the predictive means only
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
 protected:
 
     GurlsOptionsList *norm;
@@ -180,4 +180,33 @@ gMat2D<T>* GPRWrapper<T>::eval(const gMat2D<T> &X, gMat2D<T> &vars)
     return &predMeans;
 }
 
+template <typename T>
+CompiledPredictor<T>* GPRWrapper<T>::compile()
+{
+    if(norm == NULL || !this->trainedModel())
+        throw gException("Error, Train Model First");
+
+    GurlsOptionsList *opt = this->opt;
+
+    const gMat2D<T> &alpha = opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.alpha");
+    const gMat2D<T> &X_mat = opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X");
+
+    const gMat2D<T> &meanX = norm->getOptValue<OptMatrix<gMat2D<T> > >("meanX");
+    const gMat2D<T> &stdX = norm->getOptValue<OptMatrix<gMat2D<T> > >("stdX");
+    const gMat2D<T> &meanY = norm->getOptValue<OptMatrix<gMat2D<T> > >("meanY");
+    const gMat2D<T> &stdY = norm->getOptValue<OptMatrix<gMat2D<T> > >("stdY");
+
+    if(this->kType == KernelWrapper<T>::LINEAR)
+    {
+//        W = X'*alpha;
+        gMat2D<T> W(X_mat.cols(), alpha.cols());
+        dot(X_mat.getData(), alpha.getData(), W.getData(), X_mat.rows(), X_mat.cols(), alpha.rows(), alpha.cols(), W.rows(), W.cols(), CblasTrans, CblasNoTrans, CblasColMajor);
+
+        return new CompiledPredictor<T>(CompiledPredictor<T>::LINEAR, W, NULL, 0, &meanX, &stdX, &meanY, &stdY);
+    }
+
+    return new CompiledPredictor<T>(CompiledPredictor<T>::RBF, alpha, &X_mat, static_cast<T>(opt->getOptAsNumber("paramsel.sigma")),
+                                    &meanX, &stdX, &meanY, &stdY);
+}
+
 }
@@ -76,6 +76,7 @@
 #include "gurls++/rlsdual.h"
 #include "gurls++/rlsdualr.h"
 #include "gurls++/rlspegasos.h"
+#include "gurls++/rlspegasosbatch.h"
 #include "gurls++/rlsgp.h"
 #include "gurls++/rlsprimalrecinit.h"
 #include "gurls++/rlsprimalrecupdate.h"
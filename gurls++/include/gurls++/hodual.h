@@ -133,8 +133,11 @@ template<typename T>
 void ParamSelHoDualr<T>::eig_function(T* A, T* L, int A_rows_cols, unsigned long n, const GurlsOptionsList &opt)
 {
     T* V = NULL;
-    unsigned long k = static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0));
-    random_svd(A, A_rows_cols, A_rows_cols, A, L, V, k);
+    unsigned long k = std::max(1ul, static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0)));
+    random_svd(A, A_rows_cols, A_rows_cols, A, L, V, k, opt);
+
+    set(A+(A_rows_cols*k), (T)0.0, A_rows_cols*(A_rows_cols-k));
+    set(L+k, (T)0.0, A_rows_cols-k);
 }
 
 template<typename T>
@@ -149,7 +152,7 @@ unsigned long ParamSelHoDual<T>::getRank(unsigned long last, unsigned long , uns
 template<typename T>
 unsigned long ParamSelHoDualr<T>::getRank(unsigned long , unsigned long n, unsigned long , bool , const GurlsOptionsList &opt)
 {
-    return static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0));
+    return std::max(1ul, static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0)));
 }
 
 template <typename T>
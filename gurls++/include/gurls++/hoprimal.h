@@ -83,6 +83,10 @@ public:
      *  - hoperf (default)
      *  - smallnumber (default)
      *  - split (settable with the class Split and its subclasses)
+     *  - kernel.XtX, kernel.Xty (optional) precomputed statistics of the whole training set;
+     *    X and Y then only need to contain the validation samples
+     *  - nTot (optional, with kernel.XtX) total number of samples; the split may then
+     *    list only the validation indices
      *
      * \return paramsel, a GurlsOptionList with the following fields:
      *  - lambdas = array of values of the regularization parameter lambda minimizing the validation error for each class
@@ -130,10 +134,13 @@ template<typename T>
 unsigned long ParamSelHoPrimalr<T>::eig_function(T* A, T* L, int A_rows_cols, unsigned long d, const GurlsOptionsList &opt, unsigned long )
 {
     T* V = NULL;
-    T k = gurls::round((opt.getOptAsNumber("eig_percentage")*d)/100.0);
-    random_svd(A, A_rows_cols, A_rows_cols, A, L, V, A_rows_cols, k);
+    unsigned long k = std::max(1ul, static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*d)/100.0)));
+    random_svd(A, A_rows_cols, A_rows_cols, A, L, V, k, opt);
 
-    return static_cast<unsigned long>(k);
+    set(A+(A_rows_cols*k), (T)0.0, A_rows_cols*(A_rows_cols-k));
+    set(L+k, (T)0.0, A_rows_cols-k);
+
+    return k;
 }
 
 template <typename T>
@@ -151,7 +158,11 @@ GurlsOptionsList *ParamSelHoPrimal<T>::execute(const gMat2D<T>& X, const gMat2D<
     const gMat2D< unsigned long > &indices_mat = split->getOptValue<OptMatrix<gMat2D< unsigned long > > >("indices");
     const gMat2D< unsigned long > &lasts_mat = split->getOptValue<OptMatrix<gMat2D< unsigned long > > >("lasts");
 
-    const unsigned long n = indices_mat.cols();
+    bool hasXt = opt.hasOpt("kernel.XtX") && opt.hasOpt("kernel.Xty");
+
+    // Validation indices are always the trailing n-last ones of each split
+    const unsigned long nIdx = indices_mat.cols();
+    const unsigned long n = (hasXt && opt.hasOpt("nTot"))? static_cast<unsigned long>(opt.getOptAsNumber("nTot")) : nIdx;
 
     const unsigned long *lasts = lasts_mat.getData();
     const unsigned long* indices_buffer = indices_mat.getData();
@@ -189,19 +200,21 @@ GurlsOptionsList *ParamSelHoPrimal<T>::execute(const gMat2D<T>& X, const gMat2D<
     optimizer->addOpt("W", new OptMatrix<gMat2D<T> >(*W));
 
 
-    bool hasXt = opt.hasOpt("kernel.XtX") && opt.hasOpt("kernel.Xty");
-
     for(int nh=0; nh<nholdouts; ++nh)
     {
         unsigned long last = lasts[nh];
-        unsigned long* tr = new unsigned long[last];
+        unsigned long* tr = NULL;
         unsigned long* va = new unsigned long[n-last];
 
         //copy int tr indices_ from n*nh to last
-        copy< unsigned long >(tr,indices_buffer + n*nh,last,1,1);
+        if(!hasXt)
+        {
+            tr = new unsigned long[last];
+            copy< unsigned long >(tr,indices_buffer + n*nh,last,1,1);
+        }
 
         //copy int va indices_ from n*nh+last to n*nh+n
-        copy< unsigned long >(va,(indices_buffer+ n*nh+last), n-last,1,1);
+        copy< unsigned long >(va,(indices_buffer+ nIdx*nh+(nIdx-(n-last))), n-last,1,1);
 
 
         gMat2D<T> Xva(n-last, d);
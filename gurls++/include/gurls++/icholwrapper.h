@@ -44,6 +44,8 @@
 
 #include "gurls++/wrapper.h"
 
+#include <vector>
+
 namespace gurls
 {
 
@@ -67,7 +69,11 @@ public:
     void train(const gMat2D<T> &X, const gMat2D<T> &y);
 
     /**
-      * Estimator update
+      * Estimator update. Appends the new sample to the incomplete Cholesky factor and updates its QR
+      * decomposition without retraining, in O(n*rank) time. The sample becomes a new pivot,
+      * increasing the rank up to rank_max, when its residual is not smaller than the ones of the current pivots.
+      * The factorization is kept in buffers whose capacity doubles when full, alpha and the paramsel
+      * fields are recomputed only when the model is read (eval(), compile(), getOpt(), saveModel()).
       *
       * \param X Input data vector
       * \param Y Labels vector
@@ -82,6 +88,13 @@ public:
       */
     gMat2D<T>* eval(const gMat2D<T> &X);
 
+    /**
+      * Takes an immutable snapshot of the trained model
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
     gMat2D<T>* eval_ls(const gMat2D<T> &X);
 
     using GurlsWrapper<T>::eval;
@@ -92,6 +105,20 @@ public:
     void setXva(const gMat2D<T>& Xva);
     void setyva(const gMat2D<T>& yva);
 
+    /**
+      * Returns a reference to the options structure
+      */
+    const GurlsOptionsList& getOpt() const;
+
+    /**
+      * Saves the computed model to file
+      */
+    void saveModel(const std::string &fileName);
+
+    /**
+      * Loads a computed model from a file
+      */
+    void loadModel(const std::string &fileName);
 
 
 protected:
@@ -100,6 +127,36 @@ protected:
                          const unsigned long* pVec,
                          const unsigned long start, const unsigned long n);
 
+    /**
+      * Copies the factorization stored in paramsel and optimizer.X into the update buffers
+      */
+    void loadBuffers();
+
+    /**
+      * Stores the factorization held in the update buffers, and the corresponding alpha, in paramsel and optimizer.X
+      */
+    void flushBuffers() const;
+
+    /**
+      * Moves the columns of a column major buffer to a larger leading dimension
+      */
+    template <typename U>
+    static void resizeRows(std::vector<U>& buffer, const unsigned long ld, const unsigned long newLd);
+
+    mutable bool pending;       ///< True when the buffers hold updates not yet stored in opt
+    unsigned long nBuf;         ///< Number of samples in the buffers, 0 when they are not loaded
+    unsigned long rBuf;         ///< Rank of the factorization in the buffers
+    unsigned long capacity;     ///< Allocated rows, leading dimension of X, G, Q and yP
+
+    std::vector<T> Xbuf;        ///< Training inputs, capacity x d
+    std::vector<T> Gbuf;        ///< Incomplete Cholesky factor, capacity x rBuf
+    std::vector<T> Qbuf;        ///< Q part of the QR decomposition of G, capacity x rBuf
+    std::vector<T> Rbuf;        ///< R part of the QR decomposition of G, rBuf x rBuf
+    std::vector<T> yPbuf;       ///< Permuted labels, capacity x t
+    std::vector<unsigned long> pVecBuf; ///< Permutation of the samples, capacity elements
+
+    std::vector<unsigned long> kIdx;    ///< Workspace for the indices passed to computeNewKcol
+    std::vector<T> work;                ///< Workspace for the Givens rotations
 };
 
 }
@@ -16,7 +16,8 @@ namespace gurls
 {
 
 template <typename T>
-ICholWrapper<T>::ICholWrapper(const std::string& name):GurlsWrapper<T>(name)
+ICholWrapper<T>::ICholWrapper(const std::string& name):GurlsWrapper<T>(name),
+    pending(false), nBuf(0), rBuf(0), capacity(0)
 {
     this->opt = new GurlsOptionsList(name, true);
 
@@ -32,6 +33,10 @@ void ICholWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
 {
     GurlsOptionsList*opt = this->opt;
 
+    // the update buffers refer to the previous model
+    nBuf = 0;
+    pending = false;
+
     const unsigned long m = static_cast<unsigned long>(opt->getOptAsNumber("paramsel.rank_max"));
     const unsigned long n_rank = static_cast<unsigned long>(opt->getOptAsNumber("paramsel.n_rank"));
 
@@ -402,6 +407,27 @@ void ICholWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     delete perf_opt;
     delete perfTask;
 
+    // keeps the factorization at the selected rank for update()
+    const unsigned long r = maxRank+1;
+
+    gMat2D<T> *G_mat = new gMat2D<T>(n, r);
+    copy(G_mat->getData(), G, n*r);
+
+    gMat2D<T> *Q_mat = new gMat2D<T>(n, r);
+    copy(Q_mat->getData(), Q, n*r);
+
+//    R = triu(Q(:,1:r)'*G(:,1:r));
+    gMat2D<T> *R_mat = new gMat2D<T>(r, r);
+    dot(Q, G, R_mat->getData(), n, r, n, r, r, r, CblasTrans, CblasNoTrans, CblasColMajor);
+    for(unsigned long j = 0; j < r; ++j)
+        set(R_mat->getData()+(r*j)+j+1, (T)0.0, r-j-1);
+
+    gMat2D<T> *yP_mat = new gMat2D<T>(n, t);
+    copy(yP_mat->getData(), yPvec, n*t);
+
+    gMat2D<unsigned long> *pVec_mat = new gMat2D<unsigned long>(1, n);
+    copy(pVec_mat->getData(), pVec, n);
+
     delete [] G;
     delete [] diagG;
 
@@ -415,6 +441,18 @@ void ICholWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     delete predKernel_K;
 
     GurlsOptionsList* paramsel = opt->getOptAs<GurlsOptionsList>("paramsel");
+    paramsel->removeOpt("G");
+    paramsel->removeOpt("Q");
+    paramsel->removeOpt("R");
+    paramsel->removeOpt("yP");
+    paramsel->removeOpt("pVec");
+
+    paramsel->addOpt("G", new OptMatrix<gMat2D<T> >(*G_mat));
+    paramsel->addOpt("Q", new OptMatrix<gMat2D<T> >(*Q_mat));
+    paramsel->addOpt("R", new OptMatrix<gMat2D<T> >(*R_mat));
+    paramsel->addOpt("yP", new OptMatrix<gMat2D<T> >(*yP_mat));
+    paramsel->addOpt("pVec", new OptMatrix<gMat2D<unsigned long> >(*pVec_mat));
+
     paramsel->removeOpt("alpha");
     paramsel->removeOpt("acc");
     paramsel->removeOpt("maxRank");
@@ -434,6 +472,355 @@ void ICholWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
 template <typename T>
 void ICholWrapper<T>::update(const gVec<T> &X, const gVec<T> &y)
 {
+    GurlsOptionsList *opt = this->opt;
+
+    if(!opt->hasOpt("paramsel.G") || !opt->hasOpt("optimizer.X"))
+        throw gException("Error, Train Model First");
+
+    if(nBuf == 0)
+        loadBuffers();
+
+    const unsigned long n = nBuf;
+    const unsigned long d = Xbuf.size()/capacity;
+    const unsigned long r = rBuf;
+    const unsigned long t = yPbuf.size()/capacity;
+    const unsigned long n1 = n+1;
+
+    if(X.getSize() != d || y.getSize() != t)
+        throw gException(Exception_Inconsistent_Size);
+
+    const unsigned long m = static_cast<unsigned long>(opt->getOptAsNumber("paramsel.rank_max"));
+    const double sigma = opt->getOptAsNumber("paramsel.sigma");
+
+    // the buffers grow by doubling, so that appending a sample costs O(d+rank+t) amortized
+    if(n1 > capacity)
+    {
+        const unsigned long newCapacity = 2*capacity;
+
+        resizeRows(Xbuf, capacity, newCapacity);
+        resizeRows(Gbuf, capacity, newCapacity);
+        resizeRows(Qbuf, capacity, newCapacity);
+        resizeRows(yPbuf, capacity, newCapacity);
+        resizeRows(pVecBuf, capacity, newCapacity);
+
+        capacity = newCapacity;
+    }
+
+    const unsigned long ld = capacity;
+
+//    X = [X; x];
+    copy(&Xbuf[0]+n, X.getData(), d, ld, 1);
+
+//    Pvec = [Pvec n+1];
+    unsigned long* pVec = &pVecBuf[0];
+    pVec[n] = n;
+
+    // indices for computeNewKcol: the new point followed by the permuted points
+    kIdx.resize(n1+1);
+    kIdx[0] = n;
+    std::copy(pVec, pVec+n1, kIdx.begin()+1);
+
+//    newKcol = exp(-1/sigma^2*square_distance(X(Pvec(1:r),:)',x'));
+    T* kPiv = computeNewKcol(&Xbuf[0], ld, d, sigma, &kIdx[0], 1, r+1);
+
+    T* G = &Gbuf[0];
+
+    // row of the new point in the incomplete Cholesky factor, g*G(1:r,:)' = newKcol'
+    T* g = new T[r];
+    for(unsigned long j = 0; j < r; ++j)
+        g[j] = (kPiv[j] - dot(j, G+j, ld, g, 1)) / G[j+(ld*j)];
+
+    delete [] kPiv;
+
+    // the point becomes a new pivot if its residual is at least the smallest one of the current pivots
+    const T delta = (T)1.0 - dot(r, g, 1, g, 1);
+    T minPivot = G[0];
+    for(unsigned long j = 1; j < r; ++j)
+        minPivot = std::min(minPivot, G[j+(ld*j)]);
+
+    const bool grow = (r < m) && (delta > opt->getOptAsNumber("smallnumber")) && (delta >= minPivot*minPivot);
+    const unsigned long rn = grow? r+1: r;
+
+    if(grow)
+    {
+        Gbuf.resize(ld*rn, (T)0.0);
+        Qbuf.resize(ld*rn, (T)0.0);
+
+        // R(1:r,1:r) moves to a rn x rn matrix
+        std::vector<T> Rn(rn*rn, (T)0.0);
+        for(unsigned long j = 0; j < r; ++j)
+            copy(&Rn[0]+(rn*j), &Rbuf[0]+(r*j), r);
+        Rbuf.swap(Rn);
+
+        G = &Gbuf[0];
+    }
+
+    T* Qn = &Qbuf[0];
+    T* Rn = &Rbuf[0];
+    T* yPn = &yPbuf[0];
+
+//    G = [G; g]; Q = [Q; zeros(1,rn)]; yP = [yP; y];
+    for(unsigned long j = 0; j < rn; ++j)
+    {
+        Qn[(ld*j)+n] = (T)0.0;
+        G[(ld*j)+n] = (j < r)? g[j]: (T)0.0;
+    }
+    copy(yPn+n, y.getData(), t, ld, 1);
+
+    // QR update for the appended row:
+    // [G; g] = [Q 0; 0 1]*[R; g], Givens rotations take [R; g] back to triangular form
+    T* v = new T[r];
+    copy(v, g, r);
+
+    work.resize(n1);
+    T* z = &work[0];
+    set(z, (T)0.0, n1);
+    z[n] = (T)1.0;
+
+    for(unsigned long j = 0; j < r; ++j)
+    {
+        T* R_jj = Rn+(rn*j)+j;
+        const T rho = sqrt((*R_jj)*(*R_jj) + v[j]*v[j]);
+        if(rho == 0)
+            continue;
+
+        const T c = (*R_jj)/rho;
+        const T s = v[j]/rho;
+
+        for(unsigned long l = j; l < r; ++l)
+        {
+            T* R_jl = Rn+(rn*l)+j;
+            const T a = *R_jl;
+            *R_jl = c*a + s*v[l];
+            v[l] = -s*a + c*v[l];
+        }
+
+        T* Q_j = Qn+(ld*j);
+        for(unsigned long i = 0; i < n1; ++i)
+        {
+            const T a = Q_j[i];
+            Q_j[i] = c*a + s*z[i];
+            z[i] = -s*a + c*z[i];
+        }
+    }
+
+    delete [] v;
+
+    if(grow)
+    {
+        // moves the new point to the pivot position r
+//        Pvec( [r+1 n+1] ) = Pvec( [n+1 r+1] );
+        std::swap(pVec[r], pVec[n]);
+        gurls::swap(r, G+r, ld, G+n, ld);
+        gurls::swap(r, Qn+r, ld, Qn+n, ld);
+        gurls::swap(t, yPn+r, ld, yPn+n, ld);
+
+//        newKcol = exp(-1/sigma^2*square_distance(X(Pvec,:)',x'));
+        kIdx[0] = pVec[r];
+        std::copy(pVec, pVec+n1, kIdx.begin()+1);
+        T* Gcol = computeNewKcol(&Xbuf[0], ld, d, sigma, &kIdx[0], 1, n1+1);
+
+//        G(:,r+1) = (newKcol - G(:,1:r)*g')/sqrt(delta);
+        const T G_rr = sqrt(delta);
+        gemv(CblasNoTrans, n1, r, (T)-1.0/G_rr, G, ld, g, 1, (T)1.0/G_rr, Gcol, 1);
+        set(Gcol, (T)0.0, r);
+        Gcol[r] = G_rr;
+        copy(G+(ld*r), Gcol, n1);
+
+//        Rcol = Q'*Gcol; Q(:,r+1) = Gcol - Q*Rcol;
+        // orthogonalized twice to keep Q orthonormal along the updates
+        T* Rcol = Rn+(rn*r);
+        T* Rcol2 = new T[r];
+        T* Q_r = Qn+(ld*r);
+        copy(Q_r, Gcol, n1);
+
+        gemv(CblasTrans, n1, r, (T)1.0, Qn, ld, Q_r, 1, (T)0.0, Rcol, 1);
+        gemv(CblasNoTrans, n1, r, (T)-1.0, Qn, ld, Rcol, 1, (T)1.0, Q_r, 1);
+        gemv(CblasTrans, n1, r, (T)1.0, Qn, ld, Q_r, 1, (T)0.0, Rcol2, 1);
+        gemv(CblasNoTrans, n1, r, (T)-1.0, Qn, ld, Rcol2, 1, (T)1.0, Q_r, 1);
+        axpy(r, (T)1.0, Rcol2, 1, Rcol, 1);
+
+//        Rii = norm(Q(:,r+1)); Q(:,r+1) = Q(:,r+1) / Rii;
+        const T Rii = nrm2(n1, Q_r, 1);
+        scal(n1, (T)1.0/Rii, Q_r, 1);
+        Rn[(rn*r)+r] = Rii;
+
+        delete [] Rcol2;
+        delete [] Gcol;
+    }
+
+    delete [] g;
+
+    nBuf = n1;
+    rBuf = rn;
+    pending = true;
+}
+
+template <typename T>
+void ICholWrapper<T>::loadBuffers()
+{
+    GurlsOptionsList* paramsel = this->opt->template getOptAs<GurlsOptionsList>("paramsel");
+
+    const gMat2D<T> &Xtr = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X");
+    const gMat2D<T> &G_mat = paramsel->getOptValue<OptMatrix<gMat2D<T> > >("G");
+    const gMat2D<T> &Q_mat = paramsel->getOptValue<OptMatrix<gMat2D<T> > >("Q");
+    const gMat2D<T> &R_mat = paramsel->getOptValue<OptMatrix<gMat2D<T> > >("R");
+    const gMat2D<T> &yP_mat = paramsel->getOptValue<OptMatrix<gMat2D<T> > >("yP");
+    const gMat2D<unsigned long> &pVec_mat = paramsel->getOptValue<OptMatrix<gMat2D<unsigned long> > >("pVec");
+
+    const unsigned long n = Xtr.rows();
+    const unsigned long d = Xtr.cols();
+    const unsigned long r = G_mat.cols();
+    const unsigned long t = yP_mat.cols();
+
+    if(G_mat.rows() != n || Q_mat.rows() != n || Q_mat.cols() != r || R_mat.rows() != r || R_mat.cols() != r
+       || yP_mat.rows() != n || pVec_mat.getSize() != n)
+        throw gException(Exception_Inconsistent_Size);
+
+    capacity = 2*n;
+
+    Xbuf.assign(capacity*d, (T)0.0);
+    Gbuf.assign(capacity*r, (T)0.0);
+    Qbuf.assign(capacity*r, (T)0.0);
+    yPbuf.assign(capacity*t, (T)0.0);
+    pVecBuf.assign(capacity, 0);
+
+    for(unsigned long j = 0; j < d; ++j)
+        copy(&Xbuf[0]+(capacity*j), Xtr.getData()+(n*j), n);
+
+    for(unsigned long j = 0; j < r; ++j)
+    {
+        copy(&Gbuf[0]+(capacity*j), G_mat.getData()+(n*j), n);
+        copy(&Qbuf[0]+(capacity*j), Q_mat.getData()+(n*j), n);
+    }
+
+    for(unsigned long j = 0; j < t; ++j)
+        copy(&yPbuf[0]+(capacity*j), yP_mat.getData()+(n*j), n);
+
+    Rbuf.assign(R_mat.getData(), R_mat.getData()+(r*r));
+    std::copy(pVec_mat.getData(), pVec_mat.getData()+n, pVecBuf.begin());
+
+    nBuf = n;
+    rBuf = r;
+    pending = false;
+}
+
+template <typename T>
+void ICholWrapper<T>::flushBuffers() const
+{
+    if(!pending)
+        return;
+
+    const unsigned long n = nBuf;
+    const unsigned long r = rBuf;
+    const unsigned long d = Xbuf.size()/capacity;
+    const unsigned long t = yPbuf.size()/capacity;
+
+    gMat2D<T> *X_mat = new gMat2D<T>(n, d);
+    for(unsigned long j = 0; j < d; ++j)
+        copy(X_mat->getData()+(n*j), &Xbuf[0]+(capacity*j), n);
+
+    gMat2D<T> *G_mat = new gMat2D<T>(n, r);
+    gMat2D<T> *Q_mat = new gMat2D<T>(n, r);
+    for(unsigned long j = 0; j < r; ++j)
+    {
+        copy(G_mat->getData()+(n*j), &Gbuf[0]+(capacity*j), n);
+        copy(Q_mat->getData()+(n*j), &Qbuf[0]+(capacity*j), n);
+    }
+
+    gMat2D<T> *R_mat = new gMat2D<T>(r, r);
+    copy(R_mat->getData(), &Rbuf[0], r*r);
+
+    gMat2D<T> *yP_mat = new gMat2D<T>(n, t);
+    for(unsigned long j = 0; j < t; ++j)
+        copy(yP_mat->getData()+(n*j), &yPbuf[0]+(capacity*j), n);
+
+    gMat2D<unsigned long> *pVec_mat = new gMat2D<unsigned long>(1, n);
+    std::copy(pVecBuf.begin(), pVecBuf.begin()+n, pVec_mat->getData());
+
+//    alpha = Q*inv(R*R')*(Q'*y(Pvec,:));
+    const T* Q = Q_mat->getData();
+    const T* R = R_mat->getData();
+
+    T* QtYp = new T[r*t];
+    dot(Q, yP_mat->getData(), QtYp, n, r, n, t, r, t, CblasTrans, CblasNoTrans, CblasColMajor);
+    mldivide_squared(R, QtYp, r, r, r, t, CblasNoTrans);
+    mldivide_squared(R, QtYp, r, r, r, t, CblasTrans);
+
+    T* alpha_p = new T[n*t];
+    dot(Q, QtYp, alpha_p, n, r, r, t, n, t, CblasNoTrans, CblasNoTrans, CblasColMajor);
+    delete [] QtYp;
+
+//    vout.alpha(Pvec, :) = vout.alpha;
+    gMat2D<T>* alpha = new gMat2D<T>(n, t);
+    T *const alpha_it = alpha->getData();
+    const unsigned long* pVec = pVec_mat->getData();
+    for(unsigned long j = 0; j < n; ++j)
+        copy(alpha_it+pVec[j], alpha_p+j, t, n, n);
+
+    delete [] alpha_p;
+
+    GurlsOptionsList* paramsel = this->opt->template getOptAs<GurlsOptionsList>("paramsel");
+
+    paramsel->removeOpt("G");
+    paramsel->removeOpt("Q");
+    paramsel->removeOpt("R");
+    paramsel->removeOpt("yP");
+    paramsel->removeOpt("pVec");
+    paramsel->removeOpt("alpha");
+    paramsel->removeOpt("maxRank");
+
+    paramsel->addOpt("G", new OptMatrix<gMat2D<T> >(*G_mat));
+    paramsel->addOpt("Q", new OptMatrix<gMat2D<T> >(*Q_mat));
+    paramsel->addOpt("R", new OptMatrix<gMat2D<T> >(*R_mat));
+    paramsel->addOpt("yP", new OptMatrix<gMat2D<T> >(*yP_mat));
+    paramsel->addOpt("pVec", new OptMatrix<gMat2D<unsigned long> >(*pVec_mat));
+    paramsel->addOpt("alpha", new OptMatrix<gMat2D<T> >(*alpha));
+    paramsel->addOpt("maxRank", new OptNumber(r-1));
+
+    GurlsOptionsList* optimizer = this->opt->template getOptAs<GurlsOptionsList>("optimizer");
+    optimizer->removeOpt("X");
+    optimizer->addOpt("X", new OptMatrix<gMat2D<T> >(*X_mat));
+
+    pending = false;
+}
+
+template <typename T>
+template <typename U>
+void ICholWrapper<T>::resizeRows(std::vector<U>& buffer, const unsigned long ld, const unsigned long newLd)
+{
+    const unsigned long cols = buffer.size()/ld;
+
+    std::vector<U> tmp(newLd*cols, U());
+    for(unsigned long j = 0; j < cols; ++j)
+        std::copy(buffer.begin()+(ld*j), buffer.begin()+(ld*(j+1)), tmp.begin()+(newLd*j));
+
+    buffer.swap(tmp);
+}
+
+template <typename T>
+const GurlsOptionsList& ICholWrapper<T>::getOpt() const
+{
+    flushBuffers();
+
+    return GurlsWrapper<T>::getOpt();
+}
+
+template <typename T>
+void ICholWrapper<T>::saveModel(const std::string &fileName)
+{
+    flushBuffers();
+
+    GurlsWrapper<T>::saveModel(fileName);
+}
+
+template <typename T>
+void ICholWrapper<T>::loadModel(const std::string &fileName)
+{
+    GurlsWrapper<T>::loadModel(fileName);
+
+    nBuf = 0;
+    pending = false;
 }
 
 template <typename T>
@@ -441,6 +828,8 @@ gMat2D<T>* ICholWrapper<T>::eval(const gMat2D<T> &X)
 {
     GurlsOptionsList *opt = this->opt;
 
+    flushBuffers();
+
     const gMat2D<T> &alpha_mat = opt->getOptValue<OptMatrix<gMat2D<T> > >("paramsel.alpha");
     const T *const alpha = alpha_mat.getData();
 
@@ -479,11 +868,29 @@ gMat2D<T>* ICholWrapper<T>::eval(const gMat2D<T> &X)
     return y;
 }
 
+template <typename T>
+CompiledPredictor<T>* ICholWrapper<T>::compile()
+{
+    GurlsOptionsList *opt = this->opt;
+
+    flushBuffers();
+
+    if(!opt->hasOpt("paramsel.alpha"))
+        throw gException("Error, Train Model First");
+
+    return new CompiledPredictor<T>(CompiledPredictor<T>::RBF,
+                                    opt->getOptValue<OptMatrix<gMat2D<T> > >("paramsel.alpha"),
+                                    &(opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X")),
+                                    static_cast<T>(opt->getOptAsNumber("paramsel.sigma")));
+}
+
 template <typename T>
 gMat2D<T>* ICholWrapper<T>::eval_ls(const gMat2D<T> &X)
 {
     GurlsOptionsList *opt = this->opt;
 
+    flushBuffers();
+
     const gMat2D<T> &alpha_mat = opt->getOptValue<OptMatrix<gMat2D<T> > >("paramsel.alpha");
     const T *const alpha = alpha_mat.getData();
 
@@ -43,6 +43,7 @@
 #define GURLS_KERNELRLSWRAPPER_H
 
 #include "gurls++/wrapper.h"
+#include "gurls++/balltree.h"
 
 namespace gurls
 {
@@ -64,6 +65,11 @@ public:
       */
     KernelRLSWrapper(const std::string& name);
 
+    /**
+      * Destructor
+      */
+    ~KernelRLSWrapper();
+
     /**
       * Initial parameter selection and training
       *
@@ -79,6 +85,37 @@ public:
       * \returns Matrix of predicted labels
       */
     gMat2D<T>* eval(const gMat2D<T> &X);
+
+    /**
+      * Takes an immutable snapshot of the trained model
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
+    /**
+      * Sets the absolute error allowed to rbf predictions. If positive, eval() only evaluates
+      * the kernel on the training points close to each input, found with a spatial index
+      *
+      * \param[in] value error tolerance, 0 for exact predictions
+      */
+    void setPredTolerance(double value);
+
+    /**
+      * Loads a computed model from a file
+      *
+      * \param[in] fileName name of the file containing the data to load
+      */
+    void loadModel(const std::string &fileName);
+
+protected:
+    /**
+      * Returns the spatial index over optimizer.X used by the truncated rbf prediction,
+      * building it the first time it is needed after training
+      */
+    const BallTree<T>* predIndex();
+
+    BallTree<T>* index;     ///< Spatial index over optimizer.X, NULL until needed
 };
 
 }
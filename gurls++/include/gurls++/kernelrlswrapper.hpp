@@ -10,7 +10,13 @@ namespace gurls
 {
 
 template <typename T>
-KernelRLSWrapper<T>::KernelRLSWrapper(const std::string &name): KernelWrapper<T>(name) { }
+KernelRLSWrapper<T>::KernelRLSWrapper(const std::string &name): KernelWrapper<T>(name), index(NULL) { }
+
+template <typename T>
+KernelRLSWrapper<T>::~KernelRLSWrapper()
+{
+    delete index;
+}
 
 template <typename T>
 void KernelRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
@@ -18,6 +24,8 @@ void KernelRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     this->opt->removeOpt("split");
     this->opt->removeOpt("optimizer");
 
+    delete index;
+    index = NULL;
 
     const unsigned long nlambda = static_cast<unsigned long>(this->opt->getOptAsNumber("nlambda"));
     const unsigned long nsigma = static_cast<unsigned long>(this->opt->getOptAsNumber("nsigma"));
@@ -97,6 +105,8 @@ void KernelRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     GURLS G;
     G.run(X, y, *(this->opt), "one");
 
+    if(this->kType == KernelWrapper<T>::RBF && this->opt->hasOpt("pred_tolerance") && this->opt->getOptAsNumber("pred_tolerance") > 0)
+        predIndex();
 }
 
 template <typename T>
@@ -113,9 +123,15 @@ gMat2D<T>* KernelRLSWrapper<T>::eval(const gMat2D<T> &X)
         pred = new PredPrimal<T>();
         break;
     case KernelWrapper<T>::RBF:
-        pred = new PredDual<T>();
         this->opt->removeOpt("predkernel");
-        this->opt->addOpt("predkernel", predkTrainTest.execute(X, empty, *(this->opt)));
+        // the truncated prediction does not need the test kernel
+        if(this->opt->hasOpt("pred_tolerance") && this->opt->getOptAsNumber("pred_tolerance") > 0)
+            pred = new PredDual<T>(predIndex());
+        else
+        {
+            pred = new PredDual<T>();
+            this->opt->addOpt("predkernel", predkTrainTest.execute(X, empty, *(this->opt)));
+        }
     }
 
     OptMatrix<gMat2D<T> >* result = OptMatrix<gMat2D<T> >::dynacast(pred->execute(X, empty, *(this->opt)));
@@ -128,4 +144,55 @@ gMat2D<T>* KernelRLSWrapper<T>::eval(const gMat2D<T> &X)
     return ret;
 }
 
+template <typename T>
+CompiledPredictor<T>* KernelRLSWrapper<T>::compile()
+{
+    if(!this->trainedModel())
+        throw gException("Error, Train Model First");
+
+    GurlsOptionsList *opt = this->opt;
+
+    switch (this->kType)
+    {
+    case KernelWrapper<T>::LINEAR:
+        return new CompiledPredictor<T>(CompiledPredictor<T>::LINEAR, opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W"));
+    case KernelWrapper<T>::RBF:
+    default:
+        return new CompiledPredictor<T>(CompiledPredictor<T>::RBF,
+                                        opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.C"),
+                                        &(opt->getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X")),
+                                        static_cast<T>(opt->getOptAsNumber("paramsel.sigma")));
+    }
+}
+
+template <typename T>
+void KernelRLSWrapper<T>::setPredTolerance(double value)
+{
+    if(this->opt->hasOpt("pred_tolerance"))
+        this->opt->template getOptValue<OptNumber>("pred_tolerance") = value;
+    else
+        this->opt->addOpt("pred_tolerance", new OptNumber(value));
+}
+
+template <typename T>
+void KernelRLSWrapper<T>::loadModel(const std::string &fileName)
+{
+    GurlsWrapper<T>::loadModel(fileName);
+
+    delete index;
+    index = NULL;
+}
+
+template <typename T>
+const BallTree<T>* KernelRLSWrapper<T>::predIndex()
+{
+    if(index == NULL)
+    {
+        const gMat2D<T> &X = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.X");
+        index = new BallTree<T>(X.getData(), X.rows(), X.cols());
+    }
+
+    return index;
+}
+
 }
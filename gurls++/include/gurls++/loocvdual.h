@@ -90,6 +90,42 @@ public:
    GurlsOptionsList* execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList& opt);
 };
 
+/**
+ * \ingroup ParameterSelection
+ * \brief ParamSelLoocvDualr is the randomized version of \ref ParamSelLoocvDual
+ *
+ * Only the leading k eigenpairs of the kernel matrix are computed by means of \ref random_svd.
+ * k starts from opt.eig_percentage percent of the number of samples and is doubled until the
+ * smallest computed eigenvalue falls below opt.eig_tol times the largest one.
+ * The missing tail of the spectrum is approximated by its mean value when computing the leave-one-out residuals.
+ */
+
+template <typename T>
+class ParamSelLoocvDualr: public ParamSelLoocvDual<T>{
+
+public:
+    /**
+     * Performs parameter selection when the dual formulation of RLS is used.
+     * The leave-one-out approach is used on a rank-k approximation of the kernel matrix.
+     * \param X input data matrix
+     * \param Y labels matrix
+     * \param opt options with the following:
+     *  - nlambda (default)
+     *  - hoperf (default)
+     *  - smallnumber (default)
+     *  - eig_percentage (default)
+     *  - eig_tol (default)
+     *  - kernel (settable with the class Kernel and its subclasses)
+     *
+     * \return paramsel, a GurlsOptionList with the following fields:
+     *  - lambdas = array of values of the regularization parameter lambda minimizing the validation error for each class
+     *  - guesses = array of guesses for the regularization parameter lambda
+     *  - perf = matrix of validation accuracies for each lambda guess and for each class
+     *  - rank = number of eigenpairs used
+     */
+   GurlsOptionsList* execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList& opt);
+};
+
 template <typename T>
 GurlsOptionsList* ParamSelLoocvDual<T>::execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList &opt)
 {
@@ -239,6 +275,175 @@ GurlsOptionsList* ParamSelLoocvDual<T>::execute(const gMat2D<T>& X, const gMat2D
 
 }
 
+template <typename T>
+GurlsOptionsList* ParamSelLoocvDualr<T>::execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList &opt)
+{
+    const unsigned long n = Y.rows();
+    const unsigned long t = Y.cols();
+
+    const unsigned long d = X.cols();
+
+    int tot = static_cast<int>(std::ceil( opt.getOptAsNumber("nlambda")));
+
+    const GurlsOptionsList* kernel = opt.getOptAs<GurlsOptionsList>("kernel");
+    const gMat2D<T> &K = kernel->getOptValue<OptMatrix<gMat2D<T> > >("K");
+
+    const T eig_tol = static_cast<T>(opt.getOptAsNumber("eig_tol"));
+
+//    k = round(opt.eig_percentage*n/100);
+    unsigned long k = static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0));
+    k = std::min(std::max(k, 1ul), n);
+
+//    [Q,L] = tygert_svd(K,k), doubling k until the spectrum has decayed below eig_tol
+    T *Q = NULL;
+    T *L = NULL;
+    T* V = NULL;
+
+    for(;;)
+    {
+        Q = new T[n*k];
+        L = new T[k];
+
+        random_svd(K.getData(), n, n, Q, L, V, k, opt);
+
+        if(k == n || le(L[k-1], eig_tol*L[0]))
+            break;
+
+        delete [] Q;
+        delete [] L;
+
+        k = std::min(2*k, n);
+    }
+
+//    tail = (trace(K) - sum(L))/(n-k);
+    T tail = (T)0.0;
+    if(k < n)
+    {
+        for(unsigned long i=0; i<n; ++i)
+            tail += K.getData()[i*(n+1)];
+
+        tail = std::max((tail - sumv(L, k))/(n-k), (T)0.0);
+    }
+
+    int r = k;
+    if(kernel->getOptAsString("type") == "linear")
+        r = std::min(k,d);
+
+//    Qty = Q'*y;
+    T* Qty = new T[k*t];
+    dot(Q, Y.getData(), Qty, n, k, n, t, k, t, CblasTrans, CblasNoTrans, CblasColMajor);
+
+//    R = y - Q*Qty;  (component of y outside the span of Q)
+    T* R = new T[n*t];
+    copy(R, Y.getData(), n*t);
+    gemm(CblasNoTrans, CblasNoTrans, n, t, k, (T)-1.0, Q, n, Qty, k, (T)1.0, R, n);
+
+    T* guesses = lambdaguesses(L, k, r, n, tot, (T)(opt.getOptAsNumber("smallnumber")));
+
+
+    GurlsOptionsList* nestedOpt = new GurlsOptionsList("nested");
+
+    gMat2D<T>* pred = new gMat2D<T>(n, t);
+    OptMatrix<gMat2D<T> >* pred_opt = new OptMatrix<gMat2D<T> >(*pred);
+    nestedOpt->addOpt("pred", pred_opt);
+
+
+    Performance<T>* perfClass = Performance<T>::factory(opt.getOptAsString("hoperf"));
+
+    gMat2D<T>* perf = new gMat2D<T>(tot, t);
+    T* ap = perf->getData();
+
+    T* C_div_Z = new T[n];
+    T* C = new T[n*t];
+    T* Z = new T[n];
+    T* work = new T[(n+1)*(k+1)];
+
+    for(int i = 0; i < tot; ++i)
+    {
+//        C = rls_eigen(Q,L,Qty,guesses(i),n) + R/(tail + n*guesses(i));
+        rls_eigen(Q, L, Qty, C, guesses[i], n, n, k, k, k, t, work);
+        axpy(n*t, ((T)1.0)/(tail + n*guesses[i]), R, 1, C, 1);
+
+        GInverseDiagonalTruncated(Q, L, guesses+i, tail, Z, n, k, k, 1, work);
+
+        for(unsigned long j = 0; j< t; ++j)
+        {
+            rdivide(C + (n*j), Z, C_div_Z, n);
+
+//            opt.pred(:,t) = y(:,t) - (C(:,t)./Z);
+            copy(pred->getData()+(n*j), Y.getData() + (n*j), n);
+            axpy(n, (T)-1.0, C_div_Z, 1, pred->getData() + (n*j), 1);
+        }
+
+//        opt.perf = opt.hoperf([],y,opt);
+        const gMat2D<T> dummy;
+        GurlsOptionsList* perf_opt = perfClass->execute(dummy, Y, *nestedOpt);
+
+        gMat2D<T> &forho_vec = perf_opt->getOptValue<OptMatrix<gMat2D<T> > >("forho");
+
+        copy(ap+i, forho_vec.getData(), t, tot, 1);
+
+        delete perf_opt;
+    }
+
+    delete nestedOpt;
+    delete[] work;
+    delete [] C;
+    delete [] Z;
+    delete [] C_div_Z;
+    delete perfClass;
+    delete [] Qty;
+    delete [] R;
+
+    delete[] L;
+    delete[] Q;
+
+    unsigned long* idx = new unsigned long[t];
+    work = NULL;
+    indicesOfMax(ap, tot, t, idx, work, 1);
+
+
+    gMat2D<T> *LAMBDA = new gMat2D<T>(1, t);
+    copyLocations(idx, guesses, t, tot, LAMBDA->getData());
+
+    delete[] idx;
+
+
+    GurlsOptionsList* paramsel;
+
+    if(opt.hasOpt("paramsel"))
+    {
+        GurlsOptionsList* tmp_opt = new GurlsOptionsList("tmp");
+        tmp_opt->copyOpt("paramsel", opt);
+
+        paramsel = GurlsOptionsList::dynacast(tmp_opt->getOpt("paramsel"));
+        tmp_opt->removeOpt("paramsel", false);
+        delete tmp_opt;
+
+        paramsel->removeOpt("guesses");
+        paramsel->removeOpt("perf");
+        paramsel->removeOpt("lambdas");
+        paramsel->removeOpt("rank");
+    }
+    else
+        paramsel = new GurlsOptionsList("paramsel");
+
+
+    paramsel->addOpt("lambdas", new OptMatrix<gMat2D<T> >(*LAMBDA));
+
+    paramsel->addOpt("perf", new OptMatrix<gMat2D<T> >(*perf));
+
+    gMat2D<T> *guesses_mat = new gMat2D<T>(guesses, 1, tot, true);
+    paramsel->addOpt("guesses", new OptMatrix<gMat2D<T> >(*guesses_mat));
+
+    paramsel->addOpt("rank", new OptNumber(k));
+
+    delete[] guesses;
+
+    return paramsel;
+
+}
+
 
 }
 
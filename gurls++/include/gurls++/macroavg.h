@@ -145,15 +145,15 @@ GurlsOptionsList* PerfMacroAvg<T>::execute(const gMat2D<T>& /*X*/, const gMat2D<
     {
 //        %% Assumes single label prediction.
 //        [dummy, predlab] = max(y_pred,[],2);
-        T* work = new T[std::max(Y.getSize(), y_pred.getSize() )];
+        T* work = new T[rows];
 
         unsigned long* predLab = new unsigned long[rows];
-        indicesOfMax(y_pred.getData(), rows, y_pred.cols(), predLab, work, 2);
+        rowIndicesOfMax(y_pred.getData(), rows, y_pred.cols(), predLab, work);
 
 //        [dummy, truelab] = max(y_true,[],2);
 //        unsigned long* trueLab = indicesOfMax(y_true, rows, cols, 2);
         unsigned long* trueLab = new unsigned long[rows];
-        indicesOfMax(y_true, rows, cols, trueLab, work, 2);
+        rowIndicesOfMax(y_true, rows, cols, trueLab, work);
 
         delete[] work;
 
@@ -224,29 +224,27 @@ void PerfMacroAvg<T>::macroavg(const unsigned long* trueY, const unsigned long*
 //     perClass = new T[perClass_length];
     perClass = new T[totClasses];
 
-    unsigned long* ty_and_py = new unsigned long[length];
-    unsigned long* num = new unsigned long[1];
-    unsigned long* den = new unsigned long[1];
+    // a single pass over the labels counts the samples of each class and the correct predictions
+    unsigned long* num = new unsigned long[perClass_length];
+    unsigned long* den = new unsigned long[perClass_length];
+    std::fill(num, num+perClass_length, 0ul);
+    std::fill(den, den+perClass_length, 0ul);
+
+    for(int j=0; j<length; ++j)
+    {
+        ++den[trueY[j]];
+
+        if(predY[j] == trueY[j])
+            ++num[trueY[j]];
+    }
 
 //    for i = 1:nClasses,
     for(unsigned long i=0; i<perClass_length; ++i)
     {
 //    acc(i) = sum((TrueY == i) & (PredY == i))/(sum(TrueY == i) + eps);
-        unsigned long* tyEqI = compare<unsigned long>(trueY, i, length, &eq);
-        unsigned long* pyEqI = compare<unsigned long>(predY, i, length, &eq);
-
-        mult(tyEqI, pyEqI, ty_and_py, length);
-
-        sum(ty_and_py, num, length, 1, 1);
-        sum(tyEqI, den, length, 1, 1);
-
-        perClass[i] = ((T)(*num))/((*den) + std::numeric_limits<T>::epsilon());
-
-        delete [] tyEqI;
-        delete [] pyEqI;
+        perClass[i] = ((T)num[i])/(den[i] + std::numeric_limits<T>::epsilon());
     }
 
-    delete [] ty_and_py;
     delete [] num;
     delete [] den;
 
@@ -92,6 +92,13 @@ public:
       */
     gMat2D<T>* eval(const gMat2D<T> &X);
 
+    /**
+      * Takes an immutable snapshot of the trained model
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
     /**
       * Estimates label for an input matrix, optimized for large_scale data
       *
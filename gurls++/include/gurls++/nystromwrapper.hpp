@@ -690,6 +690,30 @@ gMat2D<T>* NystromWrapper<T>::eval(const gMat2D<T> &X)
     return y;
 }
 
+template <typename T>
+CompiledPredictor<T>* NystromWrapper<T>::compile()
+{
+    GurlsOptionsList *opt = this->opt;
+
+    const char* coeffs = opt->hasOpt("paramsel.C")? "paramsel.C": "paramsel.alpha";
+    if(!opt->hasOpt(coeffs))
+        throw gException("Error, Train Model First");
+
+    const gMat2D<T> &alpha_mat = opt->getOptValue<OptMatrix<gMat2D<T> > >(coeffs);
+    const gMat2D<T> &X_mat = opt->getOptValue<OptMatrix<gMat2D<T> > >("paramsel.X");
+
+    if(opt->getOptAsString("kernel.type") == "linear")
+    {
+//        W = X_mat'*alpha;
+        gMat2D<T> W(X_mat.cols(), alpha_mat.cols());
+        dot(X_mat.getData(), alpha_mat.getData(), W.getData(), X_mat.rows(), X_mat.cols(), alpha_mat.rows(), alpha_mat.cols(), W.rows(), W.cols(), CblasTrans, CblasNoTrans, CblasColMajor);
+
+        return new CompiledPredictor<T>(CompiledPredictor<T>::LINEAR, W);
+    }
+
+    return new CompiledPredictor<T>(CompiledPredictor<T>::RBF, alpha_mat, &X_mat, static_cast<T>(opt->getOptAsNumber("paramsel.sigma")));
+}
+
 template <typename T>
 gMat2D<T>* NystromWrapper<T>::eval_largescale(const gMat2D<T> &X)
 {
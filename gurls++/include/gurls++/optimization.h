@@ -77,6 +77,9 @@ class RLSDualr;
 template <typename T>
 class RLSPegasos;
 
+template <typename T>
+class RLSPegasosBatch;
+
 template <typename T>
 class RLSGPRegr;
 
@@ -141,6 +144,8 @@ public:
         return new RLSDualr<T>;
       if(id == "rlspegasos")
         return new RLSPegasos<T>;
+      if(id == "rlspegasosbatch")
+        return new RLSPegasosBatch<T>;
       if(id == "rlsgpregr")
         return new RLSGPRegr<T>;
       if(id == "rlsprimalrecinit")
@@ -252,6 +252,16 @@ public:
       */
     void load(const std::string& fileName);
 
+    /**
+      * Serializes the list to a stream, opened in binary mode if USE_BINARY_ARCHIVES is defined
+      */
+    void save(std::ostream& outstream) const;
+
+    /**
+      * Deserializes the list from a stream written by save
+      */
+    void load(std::istream& instream);
+
 protected:
     std::string name;   ///< Option name
     ValueType* table;   ///< Options list, indexed by name
@@ -66,6 +66,9 @@ class ParamSelLoocvPrimal;
 template <typename T>
 class ParamSelLoocvDual;
 
+template <typename T>
+class ParamSelLoocvDualr;
+
 template <typename T>
 class ParamSelFixLambda;
 
@@ -149,6 +152,8 @@ public:
             return new ParamSelLoocvPrimal<T>;
         if(id == "loocvdual")
             return new ParamSelLoocvDual<T>;
+        if(id == "loocvdualr")
+            return new ParamSelLoocvDualr<T>;
         if(id == "fixlambda")
             return new ParamSelFixLambda<T>;
         if(id == "calibratesgd")
@@ -73,7 +73,7 @@ public:
      * \param Y labels matrix
      * \param opt structure of options with the following fields (and subfields):
      *  - optimizer.W (set by the optimizer tasks)
-     *  - optimizer.proj (set by the optimizer tasks)
+     *  - optimizer.proj or optimizer.seed (set by the optimizer tasks)
      *
      * \return matrix of predicted labels
      */
@@ -84,13 +84,23 @@ template <typename T>
 GurlsOptionsList *PredRandFeats<T>::execute(const gMat2D<T>& X, const gMat2D<T>& /*Y*/, const GurlsOptionsList &opt)
 {
 
+    const gMat2D<T>& W = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W");
+
+    gMat2D<T> *G;
+
 //    G = rp_apply_real(X, opt.rls.proj);
-    const gMat2D<T>& proj = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.proj");
-    gMat2D<T> *G = rp_apply_real(X, proj);
+    if(opt.hasOpt("optimizer.proj"))
+    {
+        const gMat2D<T>& proj = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.proj");
+        G = rp_apply_real(X, proj);
+    }
+    else
+    {
+        const unsigned long seed = static_cast<unsigned long>(opt.getOptAsNumber("optimizer.seed"));
+        G = rp_apply_sorf(X, W.rows()/2, seed);
+    }
 
 //    scores = G*opt.rls.W;
-    const gMat2D<T>& W = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W");
-
     gMat2D<T> *scores_mat = new gMat2D<T>(G->rows(), W.cols());
     dot(G->getData(), W.getData(), scores_mat->getData(), G->rows(), G->cols(), W.rows(), W.cols(), G->rows(), W.cols(), CblasNoTrans, CblasNoTrans, CblasColMajor);
 
@@ -0,0 +1,447 @@
+/*
+  * The GURLS Package in C++
+  *
+  * Copyright (C) 2011-1013, IIT@MIT Lab
+  * All rights reserved.
+  *
+  * author:  M. Santoro
+  * email:   msantoro@mit.edu
+  * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+  *
+  * Redistribution and use in source and binary forms, with or without
+  * modification, are permitted provided that the following conditions
+  * are met:
+  *
+  *     * Redistributions of source code must retain the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer.
+  *     * Redistributions in binary form must reproduce the above
+  *       copyright notice, this list of conditions and the following
+  *       disclaimer in the documentation and/or other materials
+  *       provided with the distribution.
+  *     * Neither the name(s) of the copyright holders nor the names
+  *       of its contributors or of the Massacusetts Institute of
+  *       Technology or of the Italian Institute of Technology may be
+  *       used to endorse or promote products derived from this software
+  *       without specific prior written permission.
+  *
+  * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+  * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+  * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+  * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+  * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+  * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+  * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+  * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+  * POSSIBILITY OF SUCH DAMAGE.
+  */
+
+#ifndef GURLS_PRIMALACCUMULATOR_H
+#define GURLS_PRIMALACCUMULATOR_H
+
+#include "gurls++/datareader.h"
+#include "gurls++/gmath.h"
+#include "gurls++/optlist.h"
+#include "gurls++/optmatrix.h"
+
+#include <vector>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+
+namespace gurls
+{
+
+/**
+  * \ingroup Common
+  * \brief PrimalAccumulator computes in a single pass the sufficient statistics needed by the
+  * primal RLS solvers, reading the data in blocks of rows from DataReader objects.
+  *
+  * X'*X is accumulated with syrk and X'*y with gemm by all the available threads, each one on
+  * its own blocks; column means and standard deviations are collected at the same time, so the
+  * statistics of the z-score normalized data are available without a second pass.
+  * A subset of the samples can be kept in memory as hold-out set for ParamSelHoPrimal.
+  *
+  * To limit cancellation, the statistics are accumulated on the data shifted by the mean of the
+  * first block and converted back when requested.
+  */
+template<typename T>
+class PrimalAccumulator
+{
+public:
+    /**
+      * Constructor
+      *
+      * \param blockRows number of rows read and processed at once by each thread
+      */
+    PrimalAccumulator(unsigned long blockRows = 4096);
+
+    /**
+      * Sets the samples kept as hold-out set: one every round(1/proportion), up to maxRows
+      * (0 for no bound). When the bound is reached the set is a uniform sample of the candidates.
+      * Must be called before accumulate(); by default no sample is kept.
+      */
+    void setHoldout(double proportion, unsigned long maxRows = 0);
+
+    /**
+      * Reads all the rows of \a X and \a y and adds them to the statistics.
+      * Can be called more than once to accumulate several sources.
+      */
+    void accumulate(DataReader<T>& X, DataReader<T>& y);
+
+    /**
+      * Returns the number of samples accumulated so far
+      */
+    unsigned long samples() const {return n;}
+
+    /**
+      * Returns the number of hold-out candidates seen so far
+      */
+    unsigned long holdoutSamples() const {return nvaSeen;}
+
+    /**
+      * Returns a list named kernel with fields XtX, Xty (the statistics of all the samples)
+      * and Xva, yva (the hold-out set), optionally for the z-score normalized data
+      */
+    GurlsOptionsList* kernel(bool zscore = false) const;
+
+    /**
+      * Returns a list named split with the hold-out split, listing only the validation indices.
+      * ParamSelHoPrimal needs the option nTot set to samples() to use it.
+      */
+    GurlsOptionsList* split() const;
+
+    /**
+      * Returns a list named norm with fields meanX, stdX, meanY, stdY, as computed by NormZScore
+      */
+    GurlsOptionsList* norm() const;
+
+protected:
+    /**
+      * Stores the hold-out candidates of a block, called while holding the reading lock
+      */
+    void holdout(const T* Xi, const T* yi, unsigned long rows);
+
+    /**
+      * Computes the standard deviations of the columns of X and y
+      */
+    void stdDevs(T* stdX, T* stdY) const;
+
+    unsigned long blockRows;    ///< Rows per block
+    unsigned long d;            ///< Number of variables
+    unsigned long t;            ///< Number of outputs
+    unsigned long n;            ///< Number of samples
+
+    std::vector<T> shiftX;      ///< Shift subtracted from X
+    std::vector<T> shiftY;      ///< Shift subtracted from y
+    std::vector<T> XtX;         ///< Upper triangle of the Gram matrix of the shifted X
+    std::vector<T> Xty;         ///< Shifted X' * shifted y
+    std::vector<T> sumX;        ///< Column sums of the shifted X
+    std::vector<T> sumY;        ///< Column sums of the shifted y
+    std::vector<T> sumY2;       ///< Column sums of squares of the shifted y
+
+    unsigned long proportion;   ///< One sample every proportion is a hold-out candidate, 0 for none
+    unsigned long nvaMax;       ///< Maximum number of hold-out samples, 0 for all
+    unsigned long nvaSeen;      ///< Number of hold-out candidates seen
+    unsigned long nva;          ///< Number of hold-out samples stored
+    std::vector<T> XvaRows;     ///< Hold-out inputs, row major
+    std::vector<T> yvaRows;     ///< Hold-out outputs, row major
+};
+
+template<typename T>
+PrimalAccumulator<T>::PrimalAccumulator(unsigned long blockRows): blockRows(blockRows), d(0), t(0), n(0),
+    proportion(0), nvaMax(0), nvaSeen(0), nva(0)
+{
+    if(blockRows == 0)
+        throw gException(Exception_Illegal_Argument_Value);
+}
+
+template<typename T>
+void PrimalAccumulator<T>::setHoldout(double proportion, unsigned long maxRows)
+{
+    if(proportion < 0.0 || proportion > 1.0)
+        throw gException(Exception_Illegal_Argument_Value);
+
+    this->proportion = (proportion > 0.0)? static_cast<unsigned long>(gurls::round(1.0/proportion)) : 0;
+    nvaMax = maxRows;
+}
+
+template<typename T>
+void PrimalAccumulator<T>::accumulate(DataReader<T>& X, DataReader<T>& y)
+{
+    if(n == 0 && XtX.empty())
+    {
+        d = X.cols();
+        t = y.cols();
+
+        XtX.assign(d*d, (T)0.0);
+        Xty.assign(d*t, (T)0.0);
+        sumX.assign(d, (T)0.0);
+        sumY.assign(t, (T)0.0);
+        sumY2.assign(t, (T)0.0);
+    }
+    else if(X.cols() != d || y.cols() != t)
+        throw gException(Exception_Inconsistent_Size);
+
+    const unsigned long ld = blockRows;
+
+    bool failed = false;
+    gException error("");
+
+#pragma omp parallel
+    {
+        std::vector<T> Xi(ld*d), yi(ld*t);
+        std::vector<T> XtX_p(d*d, (T)0.0), Xty_p(d*t, (T)0.0);
+        std::vector<T> sumX_p(d, (T)0.0), sumY_p(t, (T)0.0), sumY2_p(t, (T)0.0);
+
+        for(;;)
+        {
+            unsigned long rows = 0;
+
+            // Readers are sequential, the threads overlap reading with computing
+#pragma omp critical(gurls_primalaccumulator_read)
+            {
+                if(!failed)
+                {
+                    try
+                    {
+                        rows = X.read(&Xi[0], ld, ld);
+
+                        if(y.read(&yi[0], ld, ld) != rows)
+                            throw gException(Exception_Inconsistent_Size);
+
+                        if(rows > 0 && shiftX.empty())
+                        {
+                            shiftX.resize(d);
+                            shiftY.resize(t);
+
+                            for(unsigned long j=0; j<d; ++j)
+                                shiftX[j] = sumv(&Xi[j*ld], rows)/rows;
+
+                            for(unsigned long j=0; j<t; ++j)
+                                shiftY[j] = sumv(&yi[j*ld], rows)/rows;
+                        }
+
+                        holdout(&Xi[0], &yi[0], rows);
+                        n += rows;
+                    }
+                    catch(gException& e)
+                    {
+                        failed = true;
+                        error = e;
+                        rows = 0;
+                    }
+                    catch(std::exception& e)
+                    {
+                        failed = true;
+                        error = gException(e.what());
+                        rows = 0;
+                    }
+                }
+            }
+
+            if(rows == 0)
+                break;
+
+            for(unsigned long j=0; j<d; ++j)
+            {
+                axpy(rows, (T)-1.0, &shiftX[j], 0, &Xi[j*ld], 1);
+                sumX_p[j] += sumv(&Xi[j*ld], rows);
+            }
+
+            for(unsigned long j=0; j<t; ++j)
+            {
+                axpy(rows, (T)-1.0, &shiftY[j], 0, &yi[j*ld], 1);
+                sumY_p[j] += sumv(&yi[j*ld], rows);
+                sumY2_p[j] += dot(rows, &yi[j*ld], 1, &yi[j*ld], 1);
+            }
+
+            // XtX = XtX + Xi'*Xi;
+            syrk(CblasUpper, CblasTrans, d, rows, (T)1.0, &Xi[0], ld, (T)1.0, &XtX_p[0], d);
+
+            // Xty = Xty + Xi'*yi;
+            gemm(CblasTrans, CblasNoTrans, d, t, rows, (T)1.0, &Xi[0], ld, &yi[0], ld, (T)1.0, &Xty_p[0], d);
+        }
+
+#pragma omp critical(gurls_primalaccumulator_reduce)
+        {
+            axpy(d*d, (T)1.0, &XtX_p[0], 1, &XtX[0], 1);
+            axpy(d*t, (T)1.0, &Xty_p[0], 1, &Xty[0], 1);
+            axpy(d, (T)1.0, &sumX_p[0], 1, &sumX[0], 1);
+            axpy(t, (T)1.0, &sumY_p[0], 1, &sumY[0], 1);
+            axpy(t, (T)1.0, &sumY2_p[0], 1, &sumY2[0], 1);
+        }
+    }
+
+    if(failed)
+        throw error;
+}
+
+template<typename T>
+void PrimalAccumulator<T>::holdout(const T* Xi, const T* yi, unsigned long rows)
+{
+    if(proportion == 0)
+        return;
+
+    for(unsigned long i=0; i<rows; ++i)
+    {
+        if((n+i+1) % proportion != 0)
+            continue;
+
+        ++nvaSeen;
+
+        unsigned long row = nva;
+        if(nvaMax == 0 || nva < nvaMax)
+        {
+            XvaRows.resize((nva+1)*d);
+            yvaRows.resize((nva+1)*t);
+            ++nva;
+        }
+        else
+        {
+            row = static_cast<unsigned long>(nvaSeen*(rand()/(RAND_MAX+1.0)));
+            if(row >= nva)
+                continue;
+        }
+
+        copy(&XvaRows[row*d], Xi+i, d, 1, blockRows);
+        copy(&yvaRows[row*t], yi+i, t, 1, blockRows);
+    }
+}
+
+template<typename T>
+void PrimalAccumulator<T>::stdDevs(T* stdX, T* stdY) const
+{
+    const T epsilon = std::numeric_limits<T>::epsilon();
+
+    //    stdX = std(X) + eps;
+    for(unsigned long j=0; j<d; ++j)
+        stdX[j] = sqrt(std::max(XtX[j*(d+1)] - sumX[j]*sumX[j]/n, (T)0.0)/(n-1)) + epsilon;
+
+    for(unsigned long j=0; j<t; ++j)
+        stdY[j] = sqrt(std::max(sumY2[j] - sumY[j]*sumY[j]/n, (T)0.0)/(n-1)) + epsilon;
+}
+
+template<typename T>
+GurlsOptionsList* PrimalAccumulator<T>::kernel(bool zscore) const
+{
+    if(n < 2)
+        throw gException(Exception_Inconsistent_Size);
+
+    std::vector<T> stdX(d), stdY(t);
+    stdDevs(&stdX[0], &stdY[0]);
+
+    const T* cX = &shiftX[0];
+    const T* cY = &shiftY[0];
+    const T nn = static_cast<T>(n);
+
+    gMat2D<T>* XtX_mat = new gMat2D<T>(d, d);
+    T* K = XtX_mat->getData();
+
+    for(unsigned long j=0; j<d; ++j)
+        for(unsigned long i=0; i<=j; ++i)
+        {
+            const T s = XtX[i+j*d];
+
+            // (X-1*meanX)'*(X-1*meanX) ./ (stdX'*stdX)  or  X'*X
+            K[i+j*d] = zscore? (s - sumX[i]*sumX[j]/nn)/(stdX[i]*stdX[j])
+                             : s + cX[i]*sumX[j] + sumX[i]*cX[j] + nn*cX[i]*cX[j];
+            K[j+i*d] = K[i+j*d];
+        }
+
+    gMat2D<T>* Xty_mat = new gMat2D<T>(d, t);
+    T* B = Xty_mat->getData();
+
+    for(unsigned long j=0; j<t; ++j)
+        for(unsigned long i=0; i<d; ++i)
+        {
+            const T s = Xty[i+j*d];
+
+            B[i+j*d] = zscore? (s - sumX[i]*sumY[j]/nn)/(stdX[i]*stdY[j])
+                             : s + sumX[i]*cY[j] + cX[i]*sumY[j] + nn*cX[i]*cY[j];
+        }
+
+    gMat2D<T>* Xva = new gMat2D<T>(nva, d);
+    gMat2D<T>* yva = new gMat2D<T>(nva, t);
+
+    for(unsigned long j=0; j<d; ++j)
+    {
+        T* col = Xva->getData()+(j*nva);
+        copy(col, XvaRows.empty()? NULL : &XvaRows[j], nva, 1, d);
+
+        if(zscore)
+            for(unsigned long i=0; i<nva; ++i)
+                col[i] = (col[i] - (cX[j] + sumX[j]/nn))/stdX[j];
+    }
+
+    for(unsigned long j=0; j<t; ++j)
+    {
+        T* col = yva->getData()+(j*nva);
+        copy(col, yvaRows.empty()? NULL : &yvaRows[j], nva, 1, t);
+
+        if(zscore)
+            for(unsigned long i=0; i<nva; ++i)
+                col[i] = (col[i] - (cY[j] + sumY[j]/nn))/stdY[j];
+    }
+
+    GurlsOptionsList* kernel = new GurlsOptionsList("kernel");
+    kernel->addOpt("XtX", new OptMatrix<gMat2D<T> >(*XtX_mat));
+    kernel->addOpt("Xty", new OptMatrix<gMat2D<T> >(*Xty_mat));
+    kernel->addOpt("Xva", new OptMatrix<gMat2D<T> >(*Xva));
+    kernel->addOpt("yva", new OptMatrix<gMat2D<T> >(*yva));
+
+    return kernel;
+}
+
+template<typename T>
+GurlsOptionsList* PrimalAccumulator<T>::split() const
+{
+    gMat2D<unsigned long>* indices = new gMat2D<unsigned long>(1, nva);
+    gMat2D<unsigned long>* lasts = new gMat2D<unsigned long>(1, 1);
+
+    for(unsigned long i=0; i<nva; ++i)
+        indices->getData()[i] = i;
+
+    lasts->getData()[0] = n-nva;
+
+    GurlsOptionsList* split = new GurlsOptionsList("split");
+    split->addOpt("indices", new OptMatrix<gMat2D<unsigned long> >(*indices));
+    split->addOpt("lasts", new OptMatrix<gMat2D<unsigned long> >(*lasts));
+
+    return split;
+}
+
+template<typename T>
+GurlsOptionsList* PrimalAccumulator<T>::norm() const
+{
+    if(n < 2)
+        throw gException(Exception_Inconsistent_Size);
+
+    gMat2D<T> *meanX = new gMat2D<T>(1, d);
+    gMat2D<T> *meanY = new gMat2D<T>(1, t);
+    gMat2D<T> *stdX = new gMat2D<T>(1, d);
+    gMat2D<T> *stdY = new gMat2D<T>(1, t);
+
+    for(unsigned long j=0; j<d; ++j)
+        meanX->getData()[j] = shiftX[j] + sumX[j]/n;
+
+    for(unsigned long j=0; j<t; ++j)
+        meanY->getData()[j] = shiftY[j] + sumY[j]/n;
+
+    stdDevs(stdX->getData(), stdY->getData());
+
+    GurlsOptionsList* norm = new GurlsOptionsList("norm");
+    norm->addOpt("meanX", new OptMatrix<gMat2D<T> >(*meanX));
+    norm->addOpt("stdX", new OptMatrix<gMat2D<T> >(*stdX));
+    norm->addOpt("meanY", new OptMatrix<gMat2D<T> >(*meanY));
+    norm->addOpt("stdY", new OptMatrix<gMat2D<T> >(*stdY));
+
+    return norm;
+}
+
+}
+
+#endif // GURLS_PRIMALACCUMULATOR_H
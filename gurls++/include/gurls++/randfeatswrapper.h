@@ -87,14 +87,37 @@ public:
       */
     gMat2D<T> *eval(const gMat2D<T> &X);
 
+    /**
+      * Takes an immutable snapshot of the trained model
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
     /**
       *
       * \param value
       */
     void setNRandFeats(unsigned long value);
 
+    /**
+      * Sets the kind of random projections used by train()
+      *
+      * \param value "gaussian" for a dense Gaussian matrix, "sorf" for structured orthogonal projections,
+      * which cost O(D log d) per sample and are regenerated from a seed instead of being stored
+      */
+    void setRandFeatsType(const std::string& value);
+
+    /**
+      * Sets the seed of the structured random projections
+      *
+      * \param value seed, 0 by default: models trained with the same seed share their projections,
+      * different seeds have to be set to get independent ones
+      */
+    void setRandFeatsSeed(unsigned long value);
+
 protected:
-    gMat2D<T> *W;
+    gMat2D<T> *W;   ///< Gaussian random projections, NULL for structured ones
 };
 
 }
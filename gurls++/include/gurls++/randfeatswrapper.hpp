@@ -30,35 +30,64 @@ void RandomFeaturesWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
 //    [n,d] = size(Xtr);
     const unsigned long d = X.cols();
 
-
-//    W = sqrt(2)*randn(d,D);
+    const std::string type = this->opt->getOptAsString("randfeats.type");
+    const unsigned long seed = static_cast<unsigned long>(this->opt->getOptAsNumber("randfeats.seed"));
 
     if(W != NULL)
         delete W;
 
-    W = rp_projections<T>(d, D);
+    W = NULL;
+
+    gMat2D<T> *Xtr;
 
+    if(type == "gaussian")
+    {
+//        W = sqrt(2)*randn(d,D);
+        W = rp_projections<T>(d, D);
 
-//    V = X*W;
-//    Xtr = [cos(V) sin(V)];
-    gMat2D<T> *Xtr = rp_apply_real(X, *W);
+//        V = X*W;
+//        Xtr = [cos(V) sin(V)];
+        Xtr = rp_apply_real(X, *W);
+    }
+    else if(type == "sorf")
+        Xtr = rp_apply_sorf(X, D, seed);
+    else
+        throw gException(Exception_Unknown_Option);
 
     RLSWrapper<T>::train(*Xtr, y);
 
     delete Xtr;
+
+    if(W == NULL)
+    {
+        // Only the seed is kept: the projections are regenerated by eval() and compile()
+        GurlsOptionsList* optimizer = this->opt->template getOptAs<GurlsOptionsList>("optimizer");
+        optimizer->addOpt("seed", new OptNumber(seed));
+        optimizer->addOpt("dim", new OptNumber(d));
+    }
 }
 
 template<typename T>
 gMat2D<T>* RandomFeaturesWrapper<T>::eval(const gMat2D<T> &X)
 {
-    if(W == NULL)
+    gMat2D<T> *Xte;
+
+    if(this->opt->hasOpt("optimizer.seed"))
+    {
+        const unsigned long D = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W").rows()/2;
+        const unsigned long seed = static_cast<unsigned long>(this->opt->getOptAsNumber("optimizer.seed"));
+
+        Xte = rp_apply_sorf(X, D, seed);
+    }
+    else if(W != NULL)
+    {
+//        V = X*W;
+//        Xte = [cos(V) sin(V)];
+        Xte = rp_apply_real(X, *W);
+    }
+    else
         throw gException("Error, Train Model First");
 
-
-//    V = X*W;
-//    Xte = [cos(V) sin(V)];
-    gMat2D<T> *Xte = rp_apply_real(X, *W);
-
     gMat2D<T>* pred = RLSWrapper<T>::eval(*Xte);
 
     delete Xte;
@@ -72,4 +101,37 @@ void RandomFeaturesWrapper<T>::setNRandFeats(unsigned long value)
     this->opt->template getOptValue<OptNumber>("randfeats.D") = value;
 }
 
+template<typename T>
+void RandomFeaturesWrapper<T>::setRandFeatsType(const std::string& value)
+{
+    if(value != "gaussian" && value != "sorf")
+        throw gException(Exception_Unknown_Option);
+
+    this->opt->template getOptValue<OptString>("randfeats.type") = value;
+}
+
+template<typename T>
+void RandomFeaturesWrapper<T>::setRandFeatsSeed(unsigned long value)
+{
+    this->opt->template getOptValue<OptNumber>("randfeats.seed") = value;
+}
+
+template<typename T>
+CompiledPredictor<T>* RandomFeaturesWrapper<T>::compile()
+{
+    if(W == NULL && !this->opt->hasOpt("optimizer.seed"))
+        throw gException("Error, Train Model First");
+
+    const gMat2D<T> &W_rls = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W");
+
+    if(!this->opt->hasOpt("optimizer.seed"))
+        return new CompiledPredictor<T>(CompiledPredictor<T>::RANDOMFEATURES, W_rls, W);
+
+    // the compiled model keeps only the random signs of the structured projections
+    const unsigned long d = static_cast<unsigned long>(this->opt->getOptAsNumber("optimizer.dim"));
+    const unsigned long seed = static_cast<unsigned long>(this->opt->getOptAsNumber("optimizer.seed"));
+
+    return new CompiledPredictor<T>(W_rls, d, seed);
+}
+
 }
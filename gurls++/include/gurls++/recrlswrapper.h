@@ -43,6 +43,10 @@
 #define GURLS_RECRLSWRAPPER_H
 
 #include "gurls++/wrapper.h"
+#include "gurls++/primalaccumulator.h"
+
+#include <vector>
+#include <algorithm>
 
 namespace gurls
 {
@@ -58,6 +62,13 @@ namespace gurls
   * the RLS estimator can be efficiently updated via the method update().
   * Every time a new input-output pair is available, method update() can be invoked again. Parameter selection and RLS estimation ( method retrain()) can be repeated after any number of online updates.
   * Finally, the eval() method estimates the output for new data.
+  *
+  * For non-stationary streams the estimator can either discount old samples
+  * exponentially (setForgettingFactor()) or only fit the most recent ones
+  * (setWindowSize()), in which case the oldest sample is downdated every
+  * time a new one is added. Both modes cost O(d^2) per sample. The hold-out
+  * samples used by retrain() can be bounded with setValidationSize().
+  * These settings must be chosen before calling train().
   */
 template<typename T>
 class RecursiveRLSWrapper: public GurlsWrapper<T>
@@ -78,6 +89,18 @@ public:
       */
     void train(const gMat2D<T> &X, const gMat2D<T> &y);
 
+    /**
+      * Initial parameter selection and training on data read in blocks of rows
+      *
+      * \brief The statistics are accumulated in a single pass by PrimalAccumulator,
+      * so the data never need to fit in memory; only the hold-out samples
+      * (bounded by setValidationSize()) are kept. Not available with setWindowSize().
+      *
+      * \param[in] X Input data reader
+      * \param[in] y Labels reader
+      */
+    void train(DataReader<T> &X, DataReader<T> &y);
+
     /**
       * Estimator update
       *
@@ -86,6 +109,17 @@ public:
       */
     void update(const gVec<T> &X, const gVec<T> &y);
 
+    /**
+      * Estimator update with a block of samples
+      *
+      * \brief The whole block is folded in the estimator at once via the
+      * Woodbury identity, which is cheaper than one update() call per row.
+      *
+      * \param[in] X Input data matrix
+      * \param[in] y Labels matrix
+      */
+    void update(const gMat2D<T> &X, const gMat2D<T> &y);
+
     /**
       * Estimates label for an input matrix
       *
@@ -94,6 +128,13 @@ public:
       */
     gMat2D<T>* eval(const gMat2D<T> &X);
 
+    /**
+      * Takes an immutable snapshot of the trained model
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    CompiledPredictor<T>* compile();
+
     /**
       * Selection of the new regularization parameter.
       * \brief Selection is performed via hold-out validation using the subset
@@ -101,8 +142,98 @@ public:
       */
     void retrain();
 
+    /**
+      * Sets the forgetting factor: after each sample the previous ones are
+      * weighted by value. 1 (default) disables forgetting.
+      * Values below 1 cannot be combined with setWindowSize().
+      */
+    void setForgettingFactor(double value);
+
+    /**
+      * Sets the number of most recent samples the estimator is fitted on.
+      * 0 (default) keeps all the samples. Only the samples seen by this object can be
+      * removed: after loadModel(), or when the window is set after training, the samples
+      * already in the estimator stay in it and the window applies to the following updates.
+      * Cannot be combined with a forgetting factor below 1.
+      */
+    void setWindowSize(unsigned long value);
+
+    /**
+      * Sets the maximum number of hold-out samples kept for retrain().
+      * Once the bound is reached new hold-out samples replace old ones: the oldest
+      * with forgetting or windowing, a random one (reservoir sampling) otherwise.
+      * 0 (default) keeps all of them, or with a sliding window the ones falling in it,
+      * i.e. about windowSize*hoproportion samples.
+      */
+    void setValidationSize(unsigned long value);
+
+    /**
+      * Returns a reference to the options structure
+      */
+    const GurlsOptionsList& getOpt() const;
+
+    /**
+      * Saves the computed model to file
+      */
+    void saveModel(const std::string &fileName);
+
+    /**
+      * Loads a computed model from a file
+      */
+    void loadModel(const std::string &fileName);
+
 protected:
+    /**
+      * Stores a new validation sample, row-major, until the next flush
+      */
+    void appendValidation(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t);
+
+    /**
+      * Appends the pending validation samples to kernel.Xva and kernel.yva
+      */
+    void flushValidation() const;
+
+    /**
+      * Fills the lower triangle of optimizer.Cinv, which the recursive updates leave stale
+      */
+    void flushCinv() const;
+
+    /**
+      * Adds a single sample to the estimator, applying forgetting and windowing
+      */
+    void updateSample(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t);
+
+    /**
+      * Returns the maximum number of hold-out samples, 0 for all
+      */
+    unsigned long validationBound() const;
+
+    /**
+      * Adds a sample to the window, downdating the samples that fall out of it.
+      * The circular buffer is allocated, or grown, here when needed.
+      */
+    void pushWindow(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t);
+
     unsigned long nTot; ///< Total number of samples used for training
+    T nEff;             ///< Effective number of samples in the estimator, used to scale the regularization
+
+    T forgetting;               ///< Forgetting factor
+    unsigned long windowSize;   ///< Number of most recent samples in the estimator, 0 for all
+    unsigned long nvaMax;       ///< Maximum number of hold-out samples, 0 for all
+
+    std::vector<T> window;      ///< Circular buffer with the samples in the window, row-major
+    unsigned long windowHead;   ///< Position of the oldest sample in the window
+    unsigned long windowCount;  ///< Number of samples in the window
+
+    std::vector<unsigned long> vaStamps; ///< Index in the stream of each hold-out sample
+    unsigned long nvaSeen;      ///< Number of hold-out samples seen so far
+    unsigned long vaNext;       ///< Next hold-out sample to be replaced when the bound is reached
+
+    std::vector<T> work; ///< Workspace for the update of the estimator
+
+    mutable std::vector<T> XvaPending;  ///< Validation inputs not yet stored in kernel.Xva
+    mutable std::vector<T> yvaPending;  ///< Validation outputs not yet stored in kernel.yva
+    mutable unsigned long nvaPending;   ///< Number of pending validation samples
 };
 
 }
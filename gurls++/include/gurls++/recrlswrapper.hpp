@@ -6,7 +6,9 @@
 namespace gurls
 {
 template <typename T>
-RecursiveRLSWrapper<T>::RecursiveRLSWrapper(const std::string &name): GurlsWrapper<T>(name)
+RecursiveRLSWrapper<T>::RecursiveRLSWrapper(const std::string &name): GurlsWrapper<T>(name),
+    nTot(0), nEff(0), forgetting(1), windowSize(0), nvaMax(0),
+    windowHead(0), windowCount(0), nvaSeen(0), vaNext(0), nvaPending(0)
 {
     this->opt->template getOptValue<OptNumber>("nholdouts") = 1.0;
 }
@@ -14,11 +16,18 @@ RecursiveRLSWrapper<T>::RecursiveRLSWrapper(const std::string &name): GurlsWrapp
 template <typename T>
 void RecursiveRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
 {
+    if(forgetting < 1 && windowSize > 0)
+        throw gException("Forgetting factor and sliding window cannot be used together");
+
     this->opt->removeOpt("split");
     this->opt->removeOpt("paramsel");
     this->opt->removeOpt("optimizer");
     this->opt->removeOpt("kernel");
 
+    XvaPending.clear();
+    yvaPending.clear();
+    nvaPending = 0;
+
 
     SplitHo<T> splitTask;
     GurlsOptionsList* split = splitTask.execute(X, y, *(this->opt));
@@ -35,14 +44,57 @@ void RecursiveRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     const unsigned long last = split_lasts.getData()[0];
     const unsigned long nva = n-last;
 
+    const unsigned long nvaBound = validationBound();
+    const unsigned long nvaKeep = (nvaBound > 0)? std::min(nva, nvaBound) : nva;
+
     unsigned long* va = new unsigned long[nva];
     copy(va, split_indices.getData()+last, nva);
 
-    gMat2D<T>* Xva = new gMat2D<T>(nva, d);
-    gMat2D<T>* yva = new gMat2D<T>(nva, t);
+    // With a window the most recent hold-out samples are kept, stored from the
+    // oldest so that the ones replaced first are the first to leave the window
+    unsigned long* vaKeep = va;
+    if(windowSize > 0)
+    {
+        std::sort(va, va+nva);
+        vaKeep = va+(nva-nvaKeep);
+    }
+
+    gMat2D<T>* Xva = new gMat2D<T>(nvaKeep, d);
+    gMat2D<T>* yva = new gMat2D<T>(nvaKeep, t);
+
+    subMatrixFromRows(X.getData(), n, d, vaKeep, nvaKeep, Xva->getData());
+    subMatrixFromRows(y.getData(), n, t, vaKeep, nvaKeep, yva->getData());
+
+    // Training samples enter the estimator all at once, so they share the
+    // same weight when forgetting; when windowing they leave it in order
+    vaStamps.resize(nvaKeep);
+    for(unsigned long i=0; i<nvaKeep; ++i)
+        vaStamps[i] = (forgetting < 1)? n : vaKeep[i]+1;
+
+    nvaSeen = nva;
+    vaNext = 0;
+
+    delete[] va;
+
+    if(windowSize > 0)
+    {
+        const unsigned long capacity = std::max(windowSize, n)+1;
+        window.assign(capacity*(d+t), (T)0.0);
+
+        for(unsigned long i=0; i<n; ++i)
+        {
+            copy(&window[i*(d+t)], X.getData()+i, d, 1, n);
+            copy(&window[i*(d+t)+d], y.getData()+i, t, 1, n);
+        }
 
-    subMatrixFromRows(X.getData(), n, d, va, nva, Xva->getData());
-    subMatrixFromRows(y.getData(), n, t, va, nva, yva->getData());
+        windowHead = 0;
+        windowCount = n;
+    }
+    else
+    {
+        window.clear();
+        windowCount = 0;
+    }
 
     gMat2D<T>* XtX = new gMat2D<T>(d, d);
     gMat2D<T>* Xty = new gMat2D<T>(d, t);
@@ -60,6 +112,7 @@ void RecursiveRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     kernel->addOpt("yva", new OptMatrix<gMat2D<T> >(*yva));
 
     nTot = n;
+    nEff = n;
     this->opt->addOpt("kernel", kernel);
 
     ParamSelHoPrimal<T> paramselTask;
@@ -70,86 +123,388 @@ void RecursiveRLSWrapper<T>::train(const gMat2D<T> &X, const gMat2D<T> &y)
     this->opt->addOpt("optimizer", optimizerTask.execute(X, y, *(this->opt)));
 }
 
+template <typename T>
+void RecursiveRLSWrapper<T>::train(DataReader<T> &X, DataReader<T> &y)
+{
+    if(windowSize > 0)
+        throw gException("The sliding window needs the training samples in memory");
+
+    PrimalAccumulator<T> accumulator;
+    accumulator.setHoldout(this->opt->getOptAsNumber("hoproportion"), nvaMax);
+    accumulator.accumulate(X, y);
+
+    const unsigned long n = accumulator.samples();
+
+    this->opt->removeOpt("split");
+    this->opt->removeOpt("paramsel");
+    this->opt->removeOpt("optimizer");
+    this->opt->removeOpt("kernel");
+
+    XvaPending.clear();
+    yvaPending.clear();
+    nvaPending = 0;
+
+    GurlsOptionsList* kernel = accumulator.kernel();
+    this->opt->addOpt("kernel", kernel);
+    this->opt->addOpt("split", accumulator.split());
+
+    const gMat2D<T>& Xva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
+    const gMat2D<T>& yva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
+
+    if(Xva.rows() == 0)
+        throw gException("No hold-out samples available for parameter selection");
+
+    vaStamps.assign(Xva.rows(), n);
+    nvaSeen = accumulator.holdoutSamples();
+    vaNext = 0;
+
+    window.clear();
+    windowCount = 0;
+
+    nTot = n;
+    nEff = n;
+
+    this->opt->addOpt("nTot", new OptNumber(n));
+
+    ParamSelHoPrimal<T> paramselTask;
+    this->opt->addOpt("paramsel", paramselTask.execute(Xva, yva, *(this->opt)));
+
+    RLSPrimalRecInit<T> optimizerTask;
+    gMat2D<T> emptyMat;
+    this->opt->addOpt("optimizer", optimizerTask.execute(emptyMat, emptyMat, *(this->opt)));
+
+    this->opt->removeOpt("nTot");
+}
+
 template <typename T>
 void RecursiveRLSWrapper<T>::update(const gVec<T> &X, const gVec<T> &y)
 {
     if(!this->trainedModel())
         throw gException("Error, Train Model First");
 
-    RLSPrimalRecUpdate<T> optimizer;
+    if(forgetting < 1 && windowSize > 0)
+        throw gException("Forgetting factor and sliding window cannot be used together");
+
+    updateSample(X.getData(), 1, y.getData(), 1, X.getSize(), y.getSize());
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::updateSample(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t)
+{
+    GurlsOptionsList* optimizer = this->opt->template getOptAs<GurlsOptionsList>("optimizer");
+    gMat2D<T>& W = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("W");
+    gMat2D<T>& Cinv = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("Cinv");
+
+    if(W.rows() != d || W.cols() != t)
+        throw gException(Exception_Inconsistent_Size);
 
-    const unsigned long d = X.getSize();
-    const unsigned long t = y.getSize();
+    const unsigned long workSize = RLSPrimalRecUpdate<T>::updateWorkSize(d, t, 1);
+    if(work.size() < workSize)
+        work.resize(workSize);
 
-    gMat2D<T>X_mat(1, d);
-    copy(X_mat.getData(), X.getData(), d);
-    gMat2D<T>y_mat(1, t);
-    copy(y_mat.getData(), y.getData(), t);
+    GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
+    gMat2D<T>& XtX = kernel->getOptValue<OptMatrix<gMat2D<T> > >("XtX");
+    gMat2D<T>& Xty = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xty");
 
-    GurlsOptionsList* ret = optimizer.execute(X_mat, y_mat, *(this->opt));
-    this->opt->removeOpt("optimizer");
-    this->opt->addOpt("optimizer", ret);
+    if(forgetting < 1)
+    {
+        // Cinv = Cinv/beta; XtX = beta*XtX; Xty = beta*Xty;
+        scal(d*d, (T)1.0/forgetting, Cinv.getData(), 1);
+        scal(d*d, forgetting, XtX.getData(), 1);
+        scal(d*t, forgetting, Xty.getData(), 1);
+        nEff *= forgetting;
+    }
+
+    RLSPrimalRecUpdate<T>::update(W.getData(), Cinv.getData(), d, t, x, incx, y, incy, &work[0]);
+
+    // XtX = XtX + X'*X;
+    ger(d, d, (T)1.0, x, incx, x, incx, XtX.getData(), d);
+
+    // Xty = Xty + X'*y;
+    ger(d, t, (T)1.0, x, incx, y, incy, Xty.getData(), d);
 
     ++nTot;
+    nEff += 1;
+
+    if(windowSize > 0)
+        pushWindow(x, incx, y, incy, d, t);
+
+
+    unsigned long proportion = static_cast<unsigned long>(gurls::round(1.0/this->opt->getOptAsNumber("hoproportion")));
+
+    if(nTot % proportion == 0)
+        appendValidation(x, incx, y, incy, d, t);
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::pushWindow(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t)
+{
+    const unsigned long stride = d+t;
+    unsigned long capacity = window.size()/stride;
+
+    // The buffer is empty after loadModel() or when the window is set after
+    // training, and it can be smaller than a window enlarged since then
+    if(windowCount+1 > capacity)
+    {
+        const unsigned long newCapacity = std::max(windowSize, windowCount)+1;
+        std::vector<T> grown(newCapacity*stride);
+
+        for(unsigned long i=0; i<windowCount; ++i)
+            copy(&grown[i*stride], &window[((windowHead+i)%capacity)*stride], stride);
 
-    gMat2D<T>* xtx = new gMat2D<T>(d,d);
-    gMat2D<T>* xty = new gMat2D<T>(d,t);
+        window.swap(grown);
+        windowHead = 0;
+        capacity = newCapacity;
+    }
+
+    T* slot = &window[((windowHead+windowCount)%capacity)*(d+t)];
+    copy(slot, x, d, 1, incx);
+    copy(slot+d, y, t, 1, incy);
+    ++windowCount;
 
-    dot(X.getData(), X.getData(), xtx->getData(), 1, d, 1, d, d, d, CblasTrans, CblasNoTrans, CblasColMajor);
-    dot(X.getData(), y.getData(), xty->getData(), 1, d, 1, t, d, t, CblasTrans, CblasNoTrans, CblasColMajor);
+    GurlsOptionsList* optimizer = this->opt->template getOptAs<GurlsOptionsList>("optimizer");
+    gMat2D<T>& W = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("W");
+    gMat2D<T>& Cinv = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("Cinv");
 
     GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
+    gMat2D<T>& XtX = kernel->getOptValue<OptMatrix<gMat2D<T> > >("XtX");
+    gMat2D<T>& Xty = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xty");
+
+    // A training set larger than the window is drained at the first update
+    while(windowCount > windowSize)
+    {
+        const T* oldest = &window[windowHead*(d+t)];
+
+        RLSPrimalRecUpdate<T>::downdate(W.getData(), Cinv.getData(), d, t, oldest, 1, oldest+d, 1, &work[0]);
+
+        // XtX = XtX - X'*X;
+        ger(d, d, (T)-1.0, oldest, 1, oldest, 1, XtX.getData(), d);
+
+        // Xty = Xty - X'*y;
+        ger(d, t, (T)-1.0, oldest, 1, oldest+d, 1, Xty.getData(), d);
+
+        windowHead = (windowHead+1)%capacity;
+        --windowCount;
+        nEff -= 1;
+    }
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::update(const gMat2D<T> &X, const gMat2D<T> &y)
+{
+    if(!this->trainedModel())
+        throw gException("Error, Train Model First");
+
+    if(forgetting < 1 && windowSize > 0)
+        throw gException("Forgetting factor and sliding window cannot be used together");
+
+    const unsigned long k = X.rows();
+    const unsigned long d = X.cols();
+    const unsigned long t = y.cols();
+
+    GurlsOptionsList* optimizer = this->opt->template getOptAs<GurlsOptionsList>("optimizer");
+    gMat2D<T>& W = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("W");
+    gMat2D<T>& Cinv = optimizer->getOptValue<OptMatrix<gMat2D<T> > >("Cinv");
+
+    if(y.rows() != k || W.rows() != d || W.cols() != t)
+        throw gException(Exception_Inconsistent_Size);
+
+    if(k == 0)
+        return;
+
+    // Forgetting and windowing weigh each sample differently, fall back to
+    // sample by sample updates
+    if(forgetting < 1 || windowSize > 0)
+    {
+        for(unsigned long i=0; i<k; ++i)
+            updateSample(X.getData()+i, k, y.getData()+i, k, d, t);
 
-    const gMat2D<T>& XtX = kernel->getOptValue<OptMatrix<gMat2D<T> > >("XtX");
-    const gMat2D<T>& Xty = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xty");
+        return;
+    }
+
+    const unsigned long workSize = RLSPrimalRecUpdate<T>::updateWorkSize(d, t, k);
+    if(work.size() < workSize)
+        work.resize(workSize);
+
+    RLSPrimalRecUpdate<T>::updateBlock(W.getData(), Cinv.getData(), d, t, X.getData(), y.getData(), k, &work[0]);
 
-    axpy(d*d, (T)1.0, XtX.getData(), 1, xtx->getData(), 1);
-    axpy(d*t, (T)1.0, Xty.getData(), 1, xty->getData(), 1);
+    GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
+    gMat2D<T>& XtX = kernel->getOptValue<OptMatrix<gMat2D<T> > >("XtX");
+    gMat2D<T>& Xty = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xty");
+
+    // XtX = XtX + X'*X;
+    gemm(CblasTrans, CblasNoTrans, d, d, k, (T)1.0, X.getData(), k, X.getData(), k, (T)1.0, XtX.getData(), d);
 
-    kernel->removeOpt("XtX");
-    kernel->addOpt("XtX", new OptMatrix<gMat2D<T> >(*xtx));
+    // Xty = Xty + X'*y;
+    gemm(CblasTrans, CblasNoTrans, d, t, k, (T)1.0, X.getData(), k, y.getData(), k, (T)1.0, Xty.getData(), d);
 
-    kernel->removeOpt("Xty");
-    kernel->addOpt("Xty", new OptMatrix<gMat2D<T> >(*xty));
 
+    nEff += k;
 
     unsigned long proportion = static_cast<unsigned long>(gurls::round(1.0/this->opt->getOptAsNumber("hoproportion")));
 
-    if(nTot % proportion == 0)
+    for(unsigned long i=0; i<k; ++i)
+    {
+        ++nTot;
+
+        if(nTot % proportion == 0)
+            appendValidation(X.getData()+i, k, y.getData()+i, k, d, t);
+    }
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::appendValidation(const T* x, const int incx, const T* y, const int incy, const unsigned long d, const unsigned long t)
+{
+    ++nvaSeen;
+
+    GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
+    const unsigned long nva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva").rows();
+
+    const unsigned long nvaBound = validationBound();
+
+    if(nvaBound == 0 || nva+nvaPending < nvaBound)
+    {
+        for(unsigned long i=0; i<d; ++i)
+            XvaPending.push_back(x[i*incx]);
+
+        for(unsigned long i=0; i<t; ++i)
+            yvaPending.push_back(y[i*incy]);
+
+        vaStamps.push_back(nTot);
+        ++nvaPending;
+
+        // Flushing when the pending rows double the stored ones keeps the
+        // cost of growing Xva and yva amortized O(d+t) per sample
+        if(nvaPending >= std::max(nva, 1ul) || nva+nvaPending == nvaBound)
+            flushValidation();
+
+        return;
+    }
+
+    // The set is full: replace the oldest sample when the estimator tracks
+    // recent data, otherwise keep a uniform sample of the stream
+    unsigned long row;
+    if(forgetting < 1 || windowSize > 0)
     {
-        const gMat2D<T>& Xva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
-        const gMat2D<T>& yva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
+        row = vaNext;
+        vaNext = (vaNext+1)%nva;
+    }
+    else
+    {
+        row = static_cast<unsigned long>(nvaSeen*(rand()/(RAND_MAX+1.0)));
+        if(row >= nva)
+            return;
+    }
+
+    gMat2D<T>& Xva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
+    gMat2D<T>& yva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
+
+    copy(Xva.getData()+row, x, d, nva, incx);
+    copy(yva.getData()+row, y, t, nva, incy);
+    vaStamps[row] = nTot;
+}
 
-        const unsigned long nva = Xva.rows();
-        const unsigned long nva_new = nva+1;
+template <typename T>
+unsigned long RecursiveRLSWrapper<T>::validationBound() const
+{
+    if(nvaMax > 0 || windowSize == 0)
+        return nvaMax;
+
+    // hold-out samples in the window
+    const unsigned long proportion = static_cast<unsigned long>(gurls::round(1.0/this->opt->getOptAsNumber("hoproportion")));
+    return std::max(windowSize/proportion, 1ul);
+}
 
+template <typename T>
+void RecursiveRLSWrapper<T>::flushValidation() const
+{
+    if(nvaPending == 0)
+        return;
 
-        gMat2D<T>* Xva_new = new gMat2D<T>(nva_new, d);
+    GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
 
-        const T* old_it = Xva.getData();
-        T* new_it = Xva_new->getData();
-        for(const T* end = new_it+(nva_new*d); new_it< end; old_it+=nva, new_it +=nva_new)
-            copy(new_it, old_it, nva);
+    const gMat2D<T>& Xva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
+    const gMat2D<T>& yva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
 
-        copy(Xva_new->getData()+nva, X.getData(), d, nva_new, 1);
+    const unsigned long nva = Xva.rows();
+    const unsigned long nva_new = nva+nvaPending;
+    const unsigned long d = XvaPending.size()/nvaPending;
+    const unsigned long t = yvaPending.size()/nvaPending;
 
-        kernel->removeOpt("Xva");
-        kernel->addOpt("Xva", new OptMatrix<gMat2D<T> >(*Xva_new));
 
+    gMat2D<T>* Xva_new = new gMat2D<T>(nva_new, d);
 
-        gMat2D<T>* yva_new = new gMat2D<T>(nva_new, t);
+    for(unsigned long j=0; j<d; ++j)
+    {
+        copy(Xva_new->getData()+(j*nva_new), Xva.getData()+(j*nva), nva);
+        copy(Xva_new->getData()+(j*nva_new)+nva, &XvaPending[j], nvaPending, 1, d);
+    }
 
-        old_it = yva.getData();
-        new_it = yva_new->getData();
-        for(const T* end = new_it+(nva_new*t); new_it< end; old_it+=nva, new_it +=nva_new)
-            copy(new_it, old_it, nva);
+    kernel->removeOpt("Xva");
+    kernel->addOpt("Xva", new OptMatrix<gMat2D<T> >(*Xva_new));
 
-        copy(yva_new->getData()+nva, y.getData(), t, nva_new, 1);
 
-        kernel->removeOpt("yva");
-        kernel->addOpt("yva", new OptMatrix<gMat2D<T> >(*yva_new));
+    gMat2D<T>* yva_new = new gMat2D<T>(nva_new, t);
 
+    for(unsigned long j=0; j<t; ++j)
+    {
+        copy(yva_new->getData()+(j*nva_new), yva.getData()+(j*nva), nva);
+        copy(yva_new->getData()+(j*nva_new)+nva, &yvaPending[j], nvaPending, 1, t);
     }
+
+    kernel->removeOpt("yva");
+    kernel->addOpt("yva", new OptMatrix<gMat2D<T> >(*yva_new));
+
+    XvaPending.clear();
+    yvaPending.clear();
+    nvaPending = 0;
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::flushCinv() const
+{
+    if(!this->opt->hasOpt("optimizer.Cinv"))
+        return;
+
+    gMat2D<T>& Cinv = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.Cinv");
+    RLSPrimalRecUpdate<T>::symmetrize(Cinv.getData(), Cinv.rows());
+}
+
+template <typename T>
+const GurlsOptionsList& RecursiveRLSWrapper<T>::getOpt() const
+{
+    flushValidation();
+    flushCinv();
+
+    return GurlsWrapper<T>::getOpt();
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::saveModel(const std::string &fileName)
+{
+    flushValidation();
+    flushCinv();
+
+    GurlsWrapper<T>::saveModel(fileName);
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::loadModel(const std::string &fileName)
+{
+    GurlsWrapper<T>::loadModel(fileName);
+
+    XvaPending.clear();
+    yvaPending.clear();
+    nvaPending = 0;
+
+    // Stream bookkeeping is not saved with the model
+    const unsigned long nva = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("kernel.Xva").rows();
+    vaStamps.assign(nva, nTot);
+    nvaSeen = nva;
+    vaNext = 0;
+    window.clear();
+    windowHead = 0;
+    windowCount = 0;
 }
 
 template <typename T>
@@ -173,11 +528,68 @@ gMat2D<T>* RecursiveRLSWrapper<T>::eval(const gMat2D<T> &X)
 template <typename T>
 void RecursiveRLSWrapper<T>::retrain()
 {
+    flushValidation();
+
     GurlsOptionsList* kernel = this->opt->template getOptAs<GurlsOptionsList>("kernel");
-    const gMat2D<T> &Xva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
-    const gMat2D<T> &yva = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
+    const gMat2D<T> &Xva_all = kernel->getOptValue<OptMatrix<gMat2D<T> > >("Xva");
+    const gMat2D<T> &yva_all = kernel->getOptValue<OptMatrix<gMat2D<T> > >("yva");
+
+    const gMat2D<T>* Xva_ptr = &Xva_all;
+    const gMat2D<T>* yva_ptr = &yva_all;
+
+    T nTotEff = nTot;
+    T nvaEff = Xva_all.rows();
+
+    gMat2D<T> Xva_w, yva_w;
+
+    if(forgetting < 1 || windowSize > 0)
+    {
+        // Hold-out samples are dropped once out of the window and weighted as
+        // in XtX otherwise, so that XtX - Xva'*Xva only holds training samples
+        const unsigned long nva_all = Xva_all.rows();
+        const unsigned long d = Xva_all.cols();
+        const unsigned long t = yva_all.cols();
+
+        std::vector<unsigned long> rows;
+        for(unsigned long i=0; i<nva_all; ++i)
+            if(windowSize == 0 || vaStamps[i]+windowCount > nTot)
+                rows.push_back(i);
+
+        const unsigned long nva_w = rows.size();
+        if(nva_w == 0)
+            throw gException("No hold-out samples available for retraining");
+
+        Xva_w.resize(nva_w, d);
+        yva_w.resize(nva_w, t);
+
+        nTotEff = nEff;
+        nvaEff = 0;
+
+        for(unsigned long i=0; i<nva_w; ++i)
+        {
+            copy(Xva_w.getData()+i, Xva_all.getData()+rows[i], d, nva_w, nva_all);
+            copy(yva_w.getData()+i, yva_all.getData()+rows[i], t, nva_w, nva_all);
+
+            T weight = 1;
+            if(forgetting < 1)
+            {
+                weight = std::pow(forgetting, (T)(nTot-vaStamps[rows[i]]));
+                scal(d, std::sqrt(weight), Xva_w.getData()+i, nva_w);
+                scal(t, std::sqrt(weight), yva_w.getData()+i, nva_w);
+            }
+
+            nvaEff += weight;
+        }
+
+        Xva_ptr = &Xva_w;
+        yva_ptr = &yva_w;
+    }
+
+    const gMat2D<T> &Xva = *Xva_ptr;
+    const gMat2D<T> &yva = *yva_ptr;
 
     const unsigned long nva = Xva.rows();
+    const unsigned long nTr = static_cast<unsigned long>(gurls::round(std::max(nTotEff-nvaEff, (T)1.0)));
 
     this->opt->removeOpt("paramsel");
     this->opt->removeOpt("optimizer");
@@ -187,15 +599,15 @@ void RecursiveRLSWrapper<T>::retrain()
     split->removeOpt("lasts");
 
 
-    gMat2D<unsigned long>* indices = new gMat2D<unsigned long>(1, nTot);
+    gMat2D<unsigned long>* indices = new gMat2D<unsigned long>(1, nTr+nva);
     gMat2D<unsigned long>* lasts = new gMat2D<unsigned long>(1, 1);
 
-    set(indices->getData(), 0ul, nTot-nva);
-    unsigned long * it = indices->getData() + (nTot-nva);
+    set(indices->getData(), 0ul, nTr);
+    unsigned long * it = indices->getData() + nTr;
     for(unsigned long i=0; i<nva; ++i, ++it)
         *it = i;
 
-    lasts->getData()[0] = (nTot-nva);
+    lasts->getData()[0] = nTr;
 
     split->addOpt("indices", new OptMatrix<gMat2D<unsigned long> >(*indices));
     split->addOpt("lasts", new OptMatrix<gMat2D<unsigned long> >(*lasts));
@@ -207,10 +619,57 @@ void RecursiveRLSWrapper<T>::retrain()
 
     RLSPrimalRecInit<T> optimizerTask;
     gMat2D<T> emptyMat;
-    this->opt->addOpt("nTot", new OptNumber(nTot));
+    this->opt->addOpt("nTot", new OptNumber(nEff));
     this->opt->addOpt("optimizer", optimizerTask.execute(emptyMat, emptyMat, *(this->opt)));
     this->opt->removeOpt("nTot");
 
 }
 
+template <typename T>
+void RecursiveRLSWrapper<T>::setForgettingFactor(double value)
+{
+    if(value <= 0.0 || value > 1.0)
+        throw gException(Exception_Illegal_Argument_Value);
+
+    // the window downdates samples at their original weight
+    if(value < 1.0 && windowSize > 0)
+        throw gException("Forgetting factor and sliding window cannot be used together");
+
+    forgetting = static_cast<T>(value);
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::setWindowSize(unsigned long value)
+{
+    if(value > 0 && forgetting < 1)
+        throw gException("Forgetting factor and sliding window cannot be used together");
+
+    windowSize = value;
+
+    // pushWindow() allocates the buffer again if the window is enabled later
+    if(windowSize == 0)
+    {
+        window.clear();
+        windowHead = 0;
+        windowCount = 0;
+    }
+}
+
+template <typename T>
+void RecursiveRLSWrapper<T>::setValidationSize(unsigned long value)
+{
+    nvaMax = value;
+}
+
+template <typename T>
+CompiledPredictor<T>* RecursiveRLSWrapper<T>::compile()
+{
+    if(!this->trainedModel())
+        throw gException("Error, Train Model First");
+
+    const gMat2D<T> &W = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W");
+
+    return new CompiledPredictor<T>(CompiledPredictor<T>::LINEAR, W);
+}
+
 }
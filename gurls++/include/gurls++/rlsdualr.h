@@ -114,8 +114,12 @@ GurlsOptionsList* RLSDualr<T>::execute(const gMat2D<T>& X, const gMat2D<T>& Y, c
     T *V = NULL;
 
 //    k = round(opt.eig_percentage*n/100);
-    unsigned long k = static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0));
-    random_svd(K, n, n, Q, L, V, k);
+    unsigned long k = std::max(1ul, static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*n)/100.0)));
+    random_svd(K, n, n, Q, L, V, k, opt);
+
+    // only the leading k eigenpairs are computed, the remaining ones do not contribute to C
+    set(Q+(n*k), (T)0.0, n*(n-k));
+    set(L+k, (T)0.0, n-k);
 
 
     gMat2D<T> *retC = new gMat2D<T>(n,t);
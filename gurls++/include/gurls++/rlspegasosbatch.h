@@ -0,0 +1,148 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-1013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef _GURLS_RLSPEGASOSBATCH_H_
+#define _GURLS_RLSPEGASOSBATCH_H_
+
+#include "gurls++/optimization.h"
+#include "gurls++/utils.h"
+
+namespace gurls {
+
+/**
+ * \ingroup Optimization
+ * \brief RLSPegasosBatch is the sub-class of Optimizer that implements the mini-batch version of the Pegasos algorithm
+ */
+
+template <typename T>
+class RLSPegasosBatch: public Optimizer<T>{
+
+public:
+    /**
+     * Computes a classifier for the primal formulation of RLS.
+     * The optimization is carried out using a mini-batch stochastic gradient descent algorithm.
+     * The regularization parameter is set to the one found in the field paramsel of opt.
+     * In case of multiclass problems, the regularizers need to be combined with the function specified inthe field singlelambda of opt
+     *
+     * \param X input data matrix
+     * \param Y labels matrix
+     * \param opt options with the following:
+     *  - singlelambda (default)
+     *  - epochs (default)
+     *  - batchsize (default)
+     *  - hogwild (default)
+     *  - paramsel (settable with the class ParamSelection and its subclasses)
+     *
+     * \return adds to opt the field optimizer which is a list containing the following fields:
+     *  - W = matrix of coefficient vectors of rls estimator for each class
+     *  - W_last = classifier computed in the last iteration
+     *  - W_sum = sum of the classifiers across iterations
+     *  - t0 = stepsize parameter
+     *  - count = number of iterations
+     */
+    GurlsOptionsList *execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList &opt);
+};
+
+
+template <typename T>
+GurlsOptionsList* RLSPegasosBatch<T>::execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList& opt)
+{
+    //	lambda = opt.singlelambda(opt.paramsel.lambdas);
+    const gMat2D<T> &ll = opt.getOptValue<OptMatrix<gMat2D<T> > >("paramsel.lambdas");
+    T lambda = opt.getOptAs<OptFunction>("singlelambda")->getValue(ll.getData(), ll.getSize());
+
+    const unsigned long n = X.rows();
+    const unsigned long d = X.cols();
+    const unsigned long t = Y.cols();
+
+    const unsigned long epochs = static_cast<unsigned long>(opt.getOptAsNumber("epochs"));
+    const unsigned long batchsize = static_cast<unsigned long>(opt.getOptAsNumber("batchsize"));
+    const bool hogwild = opt.getOptAsNumber("hogwild") > 0;
+
+    //   opt.cfr.W = zeros(d,T);
+    gMat2D<T>* W_last = new gMat2D<T>(d,t);
+    set(W_last->getData(), (T)0.0, d*t);
+
+    //   opt.cfr.W_sum = zeros(d,T);
+    gMat2D<T>* W_sum = new gMat2D<T>(d,t);
+    set(W_sum->getData(), (T)0.0, d*t);
+
+    //   opt.cfr.t0 = ceil(norm(X(1,:))/sqrt(opt.singlelambda(opt.paramsel.lambdas)));
+    T* row = new T[d];
+    getRow(X.getData(), n, d, 0, row);
+    const T t0 = std::max((T)1.0, static_cast<T>(ceil( nrm2(d, row, 1)/sqrt(lambda))));
+    delete[] row;
+
+    unsigned long count = 0;
+
+    rls_pegasos_batch_driver(X.getData(), Y.getData(), n, d, t, lambda, t0, batchsize, epochs, hogwild,
+                             W_last->getData(), W_sum->getData(), count);
+
+    if(count == 0)
+        throw gException(Exception_Illegal_Argument_Value);
+
+    //   cfr.W = opt.cfr.W_sum/opt.cfr.count;
+    gMat2D<T>* W = new gMat2D<T>(d,t);
+    set(W->getData(), (T)0.0, d*t);
+    axpy(d*t, (T)(1.0/count), W_sum->getData(), 1, W->getData(), 1);
+
+    GurlsOptionsList* optimizer = new GurlsOptionsList("optimizer");
+
+    optimizer->addOpt("W", new OptMatrix<gMat2D<T> >(*W));
+    optimizer->addOpt("W_last", new OptMatrix<gMat2D<T> >(*W_last));
+    optimizer->addOpt("W_sum", new OptMatrix<gMat2D<T> >(*W_sum));
+    optimizer->addOpt("count", new OptNumber(count));
+    optimizer->addOpt("t0", new OptNumber(t0));
+
+    //	cfr.C = [];
+    gMat2D<T>* emptyC = new gMat2D<T>();
+    optimizer->addOpt("C", new OptMatrix<gMat2D<T> >(*emptyC));
+
+    //	cfr.X = [];
+    gMat2D<T>* emptyX = new gMat2D<T>();
+    optimizer->addOpt("X", new OptMatrix<gMat2D<T> >(*emptyX));
+
+    return optimizer;
+}
+
+}
+#endif // _GURLS_RLSPEGASOSBATCH_H_
@@ -109,8 +109,12 @@ GurlsOptionsList* RLSPrimalr<T>::execute(const gMat2D<T>& X, const gMat2D<T>& Y,
     T *L = new T[d];
     T *V = NULL;
 
-    unsigned long k = static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*d)/100.0));
-    random_svd(XtX, d, d, Q, L, V, k);
+    unsigned long k = std::max(1ul, static_cast<unsigned long>(gurls::round((opt.getOptAsNumber("eig_percentage")*d)/100.0)));
+    random_svd(XtX, d, d, Q, L, V, k, opt);
+
+    // only the leading k eigenpairs are computed, the remaining ones do not contribute to W
+    set(Q+(d*k), (T)0.0, d*(d-k));
+    set(L+k, (T)0.0, d-k);
 
     delete[] XtX;
 
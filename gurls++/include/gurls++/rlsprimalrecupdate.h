@@ -75,9 +75,82 @@ public:
      *  - W = matrix of coefficient vectors of rls estimator for each class
      *  - C = empty matrix
      *  - X = empty matrix
-     *  - Cinv = inverse of the regularized kernel matrix in the primal space
+     *  - Cinv = inverse of the regularized kernel matrix in the primal space, both triangles filled
      */
     GurlsOptionsList* execute(const gMat2D<T>& X, const gMat2D<T>& Y, const GurlsOptionsList& opt);
+
+    /**
+     * Updates in place the estimator with a single input-output pair.
+     * Cinv is a symmetric matrix of which only the upper triangular part is
+     * referenced and updated; W is updated with a rank 1 correction.
+     * The cost is O(d^2 + dt) and no memory is allocated.
+     *
+     * \param W d x t coefficients matrix
+     * \param Cinv d x d inverse of the regularized covariance matrix
+     * \param d number of variables
+     * \param t number of outputs
+     * \param x input vector (d elements with stride incx)
+     * \param incx stride of x
+     * \param y output vector (t elements with stride incy)
+     * \param incy stride of y
+     * \param work workspace of at least updateWorkSize(d, t, 1) elements
+     */
+    static void update(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                       const T* x, const int incx, const T* y, const int incy, T* work);
+
+    /**
+     * Removes in place a single input-output pair from the estimator, i.e.
+     * the Sherman-Morrison downdate matching update().
+     * The pair must have been previously added to the estimator.
+     *
+     * \param W d x t coefficients matrix
+     * \param Cinv d x d inverse of the regularized covariance matrix (upper triangular part)
+     * \param d number of variables
+     * \param t number of outputs
+     * \param x input vector (d elements with stride incx)
+     * \param incx stride of x
+     * \param y output vector (t elements with stride incy)
+     * \param incy stride of y
+     * \param work workspace of at least updateWorkSize(d, t, 1) elements
+     */
+    static void downdate(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                         const T* x, const int incx, const T* y, const int incy, T* work);
+
+    /**
+     * Updates in place the estimator with a block of k input-output pairs
+     * using the Woodbury identity. The k x k capacitance matrix
+     * \f$ I + X C^{-1} X^T \f$ is factorized once, so the whole block costs
+     * O(kd^2 + k^2d + k^3) with level 3 Blas calls, instead of k rank 1 updates.
+     *
+     * \param W d x t coefficients matrix
+     * \param Cinv d x d inverse of the regularized covariance matrix (upper triangular part)
+     * \param d number of variables
+     * \param t number of outputs
+     * \param X k x d input block
+     * \param Y k x t output block
+     * \param k number of samples in the block
+     * \param work workspace of at least updateWorkSize(d, t, k) elements
+     */
+    static void updateBlock(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                            const T* X, const T* Y, const unsigned long k, T* work);
+
+    /**
+     * Copies the upper triangular part of Cinv to the lower one. update(), downdate()
+     * and updateBlock() only maintain the upper part, the full matrix has to be restored
+     * before Cinv is read by anything else.
+     *
+     * \param Cinv d x d inverse of the regularized covariance matrix
+     * \param d number of variables
+     */
+    static void symmetrize(T* Cinv, const unsigned long d);
+
+    /**
+     * Returns the workspace size needed to update the estimator with k samples at once
+     */
+    static unsigned long updateWorkSize(const unsigned long d, const unsigned long t, const unsigned long k)
+    {
+        return (k == 1)? d+t : k*(d+k+t);
+    }
 };
 
 
@@ -99,52 +172,14 @@ GurlsOptionsList* RLSPrimalRecUpdate<T>::execute(const gMat2D<T>& X, const gMat2
     const gMat2D<T>& prev_Cinv = opt.getOptValue<OptMatrix<gMat2D<T> > >("optimizer.Cinv");
     gMat2D<T>* Cinv = new gMat2D<T>(prev_Cinv);
 
-    T* WData = W->getData();
-    const unsigned long wn = W->rows();
-    const unsigned long wd = W->cols();
-
-
-    T* CinvData = Cinv->getData();
-    const unsigned long cn = Cinv->rows();
-    const unsigned long cd = Cinv->cols();
-
-    T* Cx = new T[cn];
-    T* x = new T[d];
-    T* y = new T[t];
-    T xCx;
-    T* CxCxt = new T[cn*cn];
-    T* xW = new T[wd];
-    T* Cxy = new T[cn*t];
+    T* work = new T[updateWorkSize(d, t, 1)];
 
     for(unsigned long i=0; i<n; ++i)
-    {
-        getRow(X.getData(), n, d, i, x);
-        getRow(Y.getData(), n, t, i, y);
-
-        //  Cx = Cinv*X(i,:)';
-        gemv(CblasNoTrans, cn, cd, (T)1.0, CinvData, cn, x, 1, (T)0.0, Cx, 1);
+        update(W->getData(), Cinv->getData(), d, t, X.getData()+i, n, Y.getData()+i, n, work);
 
-        //  xCx = X(i,:)*Cx;
-        gemv(CblasNoTrans, 1, d, (T)1.0, x, 1, Cx, 1, (T)0.0, &xCx, 1);
+    delete[] work;
 
-        //  Cinv = Cinv - Cx*Cx'./(1+xCx);
-        dot(Cx, Cx, CxCxt, cn, 1, cn, 1, cn, cn, CblasNoTrans, CblasTrans, CblasColMajor);
-        axpy(cn*cn, (T)(-1.0/(xCx+1)), CxCxt, 1, CinvData, 1);
-
-
-        //  W = W +(Cx*(y(i,:)-X(i,:)*W))./(1+xCx);
-        dot(x, WData, xW, 1, d, wn, wd, 1, wd, CblasNoTrans, CblasNoTrans, CblasColMajor);
-        axpy(t, (T)-1.0, xW, 1, y, 1);
-        dot(Cx, y, Cxy, cn, 1, 1, t, cn, t, CblasNoTrans, CblasNoTrans, CblasColMajor);
-        axpy(cn*t, (T)(1.0/(xCx+1)), Cxy, 1, WData, 1);
-    }
-
-    delete[] Cx;
-    delete[] x;
-    delete[] y;
-    delete[] CxCxt;
-    delete[] xW;
-    delete[] Cxy;
+    symmetrize(Cinv->getData(), d);
 
 
     GurlsOptionsList* optimizer = new GurlsOptionsList("optimizer");
@@ -166,6 +201,113 @@ GurlsOptionsList* RLSPrimalRecUpdate<T>::execute(const gMat2D<T>& X, const gMat2
     return optimizer;
 }
 
+template <typename T>
+void RLSPrimalRecUpdate<T>::symmetrize(T* Cinv, const unsigned long d)
+{
+    //  Cinv = triu(Cinv) + triu(Cinv,1)';
+    for(unsigned long j=1; j<d; ++j)
+        copy(Cinv+j, Cinv+(d*j), j, d, 1);
+}
+
+template <typename T>
+void RLSPrimalRecUpdate<T>::update(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                                   const T* x, const int incx, const T* y, const int incy, T* work)
+{
+    T* Cx = work;
+    T* r = work+d;
+
+    //  Cx = Cinv*x';
+    symv(CblasUpper, d, (T)1.0, Cinv, d, x, incx, (T)0.0, Cx, 1);
+
+    //  xCx = x*Cx;
+    const T coeff = (T)1.0/((T)1.0 + dot(d, x, incx, Cx, 1));
+
+    //  r = y-x*W;
+    copy(r, y, t, 1, incy);
+    gemv(CblasTrans, d, t, (T)-1.0, W, d, x, incx, (T)1.0, r, 1);
+
+    //  Cinv = Cinv - Cx*Cx'./(1+xCx);
+    syr(CblasUpper, d, -coeff, Cx, 1, Cinv, d);
+
+    //  W = W + Cx*r./(1+xCx);
+    ger(d, t, coeff, Cx, 1, r, 1, W, d);
+}
+
+template <typename T>
+void RLSPrimalRecUpdate<T>::downdate(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                                     const T* x, const int incx, const T* y, const int incy, T* work)
+{
+    T* Cx = work;
+    T* r = work+d;
+
+    //  Cx = Cinv*x';
+    symv(CblasUpper, d, (T)1.0, Cinv, d, x, incx, (T)0.0, Cx, 1);
+
+    //  xCx = x*Cx;
+    const T den = (T)1.0 - dot(d, x, incx, Cx, 1);
+
+    // The downdated matrix is no longer positive definite
+    if(den <= 0)
+        throw gException(Exception_Illegal_Argument_Value);
+
+    const T coeff = (T)1.0/den;
+
+    //  r = y-x*W;
+    copy(r, y, t, 1, incy);
+    gemv(CblasTrans, d, t, (T)-1.0, W, d, x, incx, (T)1.0, r, 1);
+
+    //  Cinv = Cinv + Cx*Cx'./(1-xCx);
+    syr(CblasUpper, d, coeff, Cx, 1, Cinv, d);
+
+    //  W = W - Cx*r./(1-xCx);
+    ger(d, t, -coeff, Cx, 1, r, 1, W, d);
+}
+
+template <typename T>
+void RLSPrimalRecUpdate<T>::updateBlock(T* W, T* Cinv, const unsigned long d, const unsigned long t,
+                                        const T* X, const T* Y, const unsigned long k, T* work)
+{
+    if(k == 1)
+    {
+        update(W, Cinv, d, t, X, 1, Y, 1, work);
+        return;
+    }
+
+    T* XC = work;
+    T* S = XC + k*d;
+    T* R = S + k*k;
+
+    //  XC = X*Cinv;
+    symm(CblasRight, CblasUpper, k, d, (T)1.0, Cinv, d, X, k, (T)0.0, XC, k);
+
+    //  S = eye(k) + X*Cinv*X';
+    set(S, (T)0.0, k*k);
+    set(S, (T)1.0, k, k+1);
+    gemm(CblasNoTrans, CblasTrans, k, k, d, (T)1.0, XC, k, X, k, (T)1.0, S, k);
+
+    //  R = Y - X*W;
+    copy(R, Y, k*t);
+    gemm(CblasNoTrans, CblasNoTrans, k, t, d, (T)-1.0, X, k, W, d, (T)1.0, R, k);
+
+    //  U = chol(S);
+    char UPLO = BlasUtils::charValue(CblasUpper);
+    int n = k;
+    int info;
+    potrf_(&UPLO, &n, S, &n, &info);
+    if(info != 0)
+        throw gException(Exception_Illegal_Argument_Value);
+
+    //  Z = U'\XC;  R = U'\R;
+    trsm(CblasLeft, CblasUpper, CblasTrans, CblasNonUnit, k, d, (T)1.0, S, k, XC, k);
+    trsm(CblasLeft, CblasUpper, CblasTrans, CblasNonUnit, k, t, (T)1.0, S, k, R, k);
+
+    //  W = W + Z'*R;
+    gemm(CblasTrans, CblasNoTrans, d, t, k, (T)1.0, XC, k, R, k, (T)1.0, W, d);
+
+    //  Cinv = Cinv - Z'*Z;
+    syrk(CblasUpper, CblasTrans, d, k, (T)-1.0, XC, k, (T)1.0, Cinv, d);
+}
+
 
 }
 #endif // _GURLS_RLSPRIMALRECUPDATE_H_
@@ -62,6 +62,10 @@ namespace gurls {
  *  Ali Rahimi, Ben Recht;
  *  Random Features for Large-Scale Kernel Machines;
  *  in Neural Information Processing Systems (NIPS) 2007.
+ * With opt.randfeats.type = "sorf" the dense Gaussian projections are replaced by structured orthogonal
+ * ones (see rp_sorf_signs()), which are regenerated from opt.randfeats.seed instead of being stored.
+ * The same seed always gives the same projections: models meant to be independent (e.g. in an ensemble)
+ * need different seeds.
  * The regularization parameter is set to the one found in opt.paramsel.
  * In case of multiclass problems, the regularizers need to be combined with the opt.singlelambda function.
  */
@@ -80,9 +84,13 @@ public:
      *  - singlelambda
      *  - randfeats.D
      *  - randfeats.samplesize
+     *  - randfeats.type ("gaussian" or "sorf")
+     *  - randfeats.seed (sorf only, 0 by default, so that training is repeatable)
      *
      * \return adds to opt the field optimizer, which is a list containing the following fields:
      *  - W: matrix of coefficient vectors of rls estimator for each class
+     *  - proj: matrix of random projections (gaussian only)
+     *  - seed: seed of the structured random projections (sorf only)
      *  - C: empty matrix
      *  - X: empty matrix
      */
@@ -118,8 +126,22 @@ GurlsOptionsList* RLSRandFeats<T>::execute(const gMat2D<T>& X, const gMat2D<T>&
     T *XtX = new T[D2*D2];
     T *Xty = new T[D2*t];
 
+    const std::string type = opt.getOptAsString("randfeats.type");
+    const unsigned long seed = static_cast<unsigned long>(opt.getOptAsNumber("randfeats.seed"));
+
+    gMat2D<T> *rls_proj = NULL;
+
 //    [XtX,Xty,rls.proj] = rp_factorize_large_real(X,y,opt.randfeats.D,ni);
-    gMat2D<T> *rls_proj = rp_factorize_large_real(X, Y, D, ni, XtX, Xty);
+    if(type == "gaussian")
+        rls_proj = rp_factorize_large_real(X, Y, D, ni, XtX, Xty);
+    else if(type == "sorf")
+        rp_factorize_large_sorf(X, Y, D, ni, seed, XtX, Xty);
+    else
+    {
+        delete [] XtX;
+        delete [] Xty;
+        throw gException(Exception_Unknown_Option);
+    }
 
 //    rls.W = rls_primal_driver( XtX, Xty, n, lambda );
     gMat2D<T> *W = rls_primal_driver(XtX, Xty, D2, D2, t, lambda);
@@ -130,7 +152,10 @@ GurlsOptionsList* RLSRandFeats<T>::execute(const gMat2D<T>& X, const gMat2D<T>&
     GurlsOptionsList *optimizer = new GurlsOptionsList("optimizer");
 
 
-    optimizer->addOpt("proj", new OptMatrix<gMat2D<T> >(*rls_proj));
+    if(rls_proj != NULL)
+        optimizer->addOpt("proj", new OptMatrix<gMat2D<T> >(*rls_proj));
+    else
+        optimizer->addOpt("seed", new OptNumber(seed));
 
 //    rls.W = rls_primal_driver( XtX, Xty, n, lambda );
     optimizer->addOpt("W", new OptMatrix<gMat2D<T> >(*W));
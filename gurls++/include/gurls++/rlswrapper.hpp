@@ -53,4 +53,15 @@ gMat2D<T>* RLSWrapper<T>::eval(const gMat2D<T> &X)
     return pred;
 }
 
+template <typename T>
+CompiledPredictor<T>* RLSWrapper<T>::compile()
+{
+    if(!this->trainedModel())
+        throw gException("Error, Train Model First");
+
+    const gMat2D<T> &W = this->opt->template getOptValue<OptMatrix<gMat2D<T> > >("optimizer.W");
+
+    return new CompiledPredictor<T>(CompiledPredictor<T>::LINEAR, W);
+}
+
 }
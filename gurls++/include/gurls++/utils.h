@@ -50,6 +50,7 @@
 
 #include <map>
 #include <algorithm>
+#include <vector>
 
 #include "gurls++/gmath.h"
 #include "gurls++/gmat2d.h"
@@ -348,6 +349,170 @@ GurlsOptionsList* rls_pegasos_driver(const T* X, const T* bY, const GurlsOptions
 }
 
 
+/**
+ * Utility function called by the class RLSPegasosBatch to run the mini-batch version of the pegasos algorithm.
+ * The training samples are split in contiguous blocks of \a batchsize rows, visited in a random order at each epoch.
+ * For each block the gradient is computed with two matrix-matrix products directly on X and bY.
+ * W is kept as s*V, so that the shrinking step only updates the scalar s, and its norm is tracked
+ * while V is updated. With \a hogwild, V is never rescaled while other threads may be updating it:
+ * s is folded into V between epochs. Each thread sums its classifiers in a private buffer,
+ * added to W_sum at the end of the epoch.
+ *
+ * \param X input data matrix
+ * \param bY labels matrix
+ * \param n number of rows of X and bY
+ * \param d number of columns of X
+ * \param t number of columns of bY
+ * \param lambda regularization parameter
+ * \param t0 stepsize parameter
+ * \param batchsize number of samples per update
+ * \param epochs number of passes over the training set
+ * \param hogwild if true, blocks are processed concurrently by all the available threads without locking W
+ * \param W on entry initial classifier, on exit last classifier (d x t)
+ * \param W_sum sum of the classifiers across iterations (d x t)
+ * \param count number of updates performed, updated on exit
+ */
+template <typename T>
+void rls_pegasos_batch_driver(const T* X, const T* bY, const unsigned long n, const unsigned long d, const unsigned long t,
+                              const T lambda, const T t0, const unsigned long batchsize, const unsigned long epochs,
+                              const bool hogwild, T* W, T* W_sum, unsigned long& count)
+{
+    const unsigned long W_size = d*t;
+    const unsigned long b = std::max(1ul, std::min(batchsize, n));
+    const long nb = static_cast<long>((n + b - 1)/b);
+
+    const T thr = sqrt(t/lambda);
+
+    // W = s*V, V is stored in W
+    T* V = W;
+    T s = (T)1.0;
+    T nV2 = dot(W_size, V, 1, V, 1);
+
+    unsigned long* order = new unsigned long[nb];
+
+    for(unsigned long e = 0; e < epochs; ++e)
+    {
+        randperm(nb, order, e == 0, 0);
+
+        // The first update of a run with t0 <= 1 zeroes W: do it before the workers start
+        if(hogwild && le(count + t0, (T)1.0))
+        {
+            set(V, (T)0.0, W_size);
+            nV2 = (T)0.0;
+            s = (T)1.0;
+        }
+
+#pragma omp parallel if(hogwild)
+        {
+            T* R = new T[b*t];
+            T* G = new T[W_size];
+
+            // W_sum is shared: concurrent updates would be lost
+            T* S = W_sum;
+            if(hogwild)
+            {
+                S = new T[W_size];
+                set(S, (T)0.0, W_size);
+            }
+
+#pragma omp for schedule(dynamic)
+            for(long i = 0; i < nb; ++i)
+            {
+                const unsigned long i0 = order[i]*b;
+                const unsigned long rows = std::min(b, n-i0);
+
+                T s_cur;
+#pragma omp critical(pegasos_batch)
+                s_cur = s;
+
+//                R = bY(batch,:) - X(batch,:)*W;
+                for(unsigned long j = 0; j < t; ++j)
+                    copy(R + j*rows, bY + i0 + j*n, rows);
+
+                gemm(CblasNoTrans, CblasNoTrans, rows, t, d, -s_cur, X+i0, n, V, d, (T)1.0, R, rows);
+
+//                G = X(batch,:)'*R;
+                gemm(CblasTrans, CblasNoTrans, d, t, rows, (T)1.0, X+i0, n, R, rows, (T)0.0, G, d);
+
+                T c;
+#pragma omp critical(pegasos_batch)
+                {
+//                    eta = 1.0/(lambda*(count + t0));
+                    const T eta = ((T)1.0)/(lambda*(count + t0));
+                    ++count;
+
+//                    W = (1 - lambda*eta)*W + eta*G/rows;
+                    const T coeff = (T)1.0 - (lambda*eta);
+                    if(le(coeff, (T)0.0))
+                    {
+                        if(!hogwild)
+                            set(V, (T)0.0, W_size);
+                        s = (T)1.0;
+                    }
+                    else
+                        s *= coeff;
+
+                    c = eta/(rows*s);
+                }
+
+                T nrm = 0;
+                for(T *v_it = V, *g_it = G, *const v_end = V + W_size; v_it != v_end; ++v_it, ++g_it)
+                {
+                    *v_it += c*(*g_it);
+                    nrm += (*v_it)*(*v_it);
+                }
+
+                T s_new;
+#pragma omp critical(pegasos_batch)
+                {
+                    nV2 = nrm;
+
+//                    %% Projection onto the ball with radius sqrt(T/lambda)
+                    const T nW = s*sqrt(nV2);
+                    if(gt(nW, thr))
+                        s *= thr/nW;
+
+                    // fold s back into V before it under/overflows
+                    if(!hogwild && (lt(s, (T)1.0e-6) || gt(s, (T)1.0e6)))
+                    {
+                        scal(W_size, s, V, 1);
+                        nV2 *= s*s;
+                        s = (T)1.0;
+                    }
+
+                    s_new = s;
+                }
+
+//                W_sum = W_sum + W;
+                axpy(W_size, s_new, V, 1, S, 1);
+            }
+
+            if(hogwild)
+            {
+#pragma omp critical(pegasos_batch)
+                axpy(W_size, (T)1.0, S, 1, W_sum, 1);
+
+                delete [] S;
+            }
+
+            delete [] R;
+            delete [] G;
+        }
+
+        if(hogwild)
+        {
+            scal(W_size, s, V, 1);
+            nV2 *= s*s;
+            s = (T)1.0;
+        }
+    }
+
+    scal(W_size, s, W, 1);
+
+    delete [] order;
+}
+
+
 /**
  * Utility function called by the rls_pegasos_driver; it evaluate classification accuracy on the test set given in fields Xte and yte of opt
  *
@@ -501,25 +666,151 @@ void distance_transposed_vm(const T* A, const T* B, const int cols, const int B_
     }
 }
 
+/**
+ * \brief Method used by \ref random_svd to build the subspace approximating the range of A
+ */
+enum RandomSVDMethod
+{
+    RandomSVDKrylov,    ///< Block Krylov space [H, AA'H, ..., (AA')^its H], suited to slowly decaying spectra
+    RandomSVDSubspace   ///< Subspace (power) iteration, H = orth(AA'H) repeated its times, keeps only one block in memory
+};
+
+/**
+ * \brief Random test matrix used by \ref random_svd to sketch A
+ */
+enum RandomSVDProjection
+{
+    RandomSVDUniform,   ///< Dense matrix with i.i.d. entries uniformly distributed in [-1,1]
+    RandomSVDSRHT       ///< Subsampled randomized Hadamard transform, applied block-wise in O(log n) per entry
+};
+
+/**
+ * Computes Y = op(A)*X, where op(A) = A if \a transposed is false, op(A) = A' otherwise.
+ * \a A is \a A_rows x \a A_cols, \a X has \a X_cols columns.
+ */
+template <typename T>
+void random_svd_apply(const T* A, const unsigned long A_rows, const unsigned long A_cols, const bool transposed,
+                      const T* X, const unsigned long X_cols, T* Y)
+{
+    if(!transposed)
+        gemm(CblasNoTrans, CblasNoTrans, A_rows, X_cols, A_cols, (T)1.0, A, A_rows, X, A_cols, (T)0.0, Y, A_rows);
+    else
+        gemm(CblasTrans, CblasNoTrans, A_cols, X_cols, A_rows, (T)1.0, A, A_rows, X, A_rows, (T)0.0, Y, A_cols);
+}
+
+/**
+ * Computes H = op(A)*Omega where Omega = D*H*S/sqrt(l) is a subsampled randomized Hadamard transform:
+ * D is a diagonal matrix of random signs, H the Walsh-Hadamard matrix of size pow2 >= cols
+ * and S selects \a l of its columns at random.
+ * Rows of op(A) are processed in blocks, so that only \a block_rows x pow2 temporaries are needed per thread.
+ *
+ * \param A input matrix, A_rows x A_cols
+ * \param transposed if true op(A) = A', otherwise op(A) = A
+ * \param H on exit contains the sketch, rows x l where rows is the number of rows of op(A)
+ * \param l number of columns of the sketch
+ */
+template <typename T>
+void random_svd_srht(const T* A, const unsigned long A_rows, const unsigned long A_cols, const bool transposed,
+                     T* H, const unsigned long l)
+{
+    const long rows = transposed? A_cols : A_rows;
+    const unsigned long cols = transposed? A_rows : A_cols;
+
+    unsigned long pow2 = 1;
+    while(pow2 < cols)
+        pow2 <<= 1;
+
+    T* signs = new T[cols];
+    for(T *it = signs, *end = signs+cols; it != end; ++it)
+        *it = (rand()%2)? (T)1.0 : (T)-1.0;
+
+    unsigned long* sel = new unsigned long[pow2];
+    randperm(pow2, sel, true, 0);
+
+    const T scale = static_cast<T>(1.0/sqrt(static_cast<double>(l)));
+    const long block_rows = 64;
+
+#pragma omp parallel
+    {
+        T* buffer = new T[block_rows*pow2];
+
+#pragma omp for schedule(dynamic)
+        for(long r0 = 0; r0 < rows; r0 += block_rows)
+        {
+            const long nr = std::min(block_rows, rows-r0);
+
+            // buffer(:,i) = (op(A)(r0+i,:).*signs)', zero padded to pow2
+            set(buffer, (T)0.0, nr*pow2);
+
+            if(transposed)
+            {
+                for(long i=0; i<nr; ++i)
+                    mult(A + (r0+i)*A_rows, signs, buffer + i*pow2, cols);
+            }
+            else
+            {
+                for(unsigned long j=0; j<cols; ++j)
+                {
+                    const T* A_it = A + r0 + j*A_rows;
+                    for(long i=0; i<nr; ++i)
+                        buffer[j + i*pow2] = A_it[i]*signs[j];
+                }
+            }
+
+            for(long i=0; i<nr; ++i)
+            {
+                T* b = buffer + i*pow2;
+                fwht(b, pow2);
+
+                for(unsigned long j=0; j<l; ++j)
+                    H[r0 + i + j*rows] = scale*b[sel[j]];
+            }
+        }
+
+        delete [] buffer;
+    }
+
+    delete [] sel;
+    delete [] signs;
+}
+
+/**
+ * Replaces the columns of the \a rows x \a cols matrix \a A with an orthonormal basis of their span
+ */
+template <typename T>
+void random_svd_orth(T* A, const unsigned long rows, const unsigned long cols)
+{
+    int* E = new int[cols];
+    qr_econ(A, rows, cols, A, (T*)NULL, E);
+    delete[] E;
+}
 
 /**
- * Constructs a nearly optimal rank-\a k approximation USV' to \a A, using \a its full iterations of a block Lanczos method
- * of block size \a l, started with an n x \a l random matrix, when \a A is m x n;
+ * Constructs a nearly optimal rank-\a k approximation USV' to \a A, when \a A is m x n.
+ *
+ * An orthonormal basis Q for the range of A is built from a random m x \a l sketch of A, refined
+ * with \a its iterations of either a block Lanczos (Krylov) method or a subspace (power) iteration.
+ * The SVD of the small matrix Q'*A then gives the leading singular triplets.
+ * The smaller of the two dimensions of A is never expanded: all temporaries are
+ * O(max(m,n)*(its+1)*l) for the Krylov method and O(max(m,n)*l) for subspace iteration.
  *
  * \param A Matrix
  * \param A_rows Number of rows of A
  * \param A_cols Number of columns of A
- * \param U Matrix
- * \param S Matrix
- * \param V Matrix
+ * \param U Matrix, A_rows x k. It can share its storage with A.
+ * \param S Vector of the k singular values, in descending order
+ * \param V Matrix, A_cols x k. Not computed if NULL.
  * \param k Rank, must be a positive integer <= the smallest dimension of A.
- * \param its Iterations of Lanczos method
- * \param l Block size
+ * \param its Iterations of the Krylov or subspace method
+ * \param l Block size, k plus oversampling. Set to k+2 if smaller than k.
+ * \param method Krylov or subspace iteration
+ * \param projection Random test matrix used for the initial sketch
  */
 template <typename T>
 void random_svd(const T* A, const unsigned long A_rows, const unsigned long A_cols,
                 T* U, T* S, T* V,
-                unsigned long k = 6, unsigned long its = 2, unsigned long l = 0)
+                unsigned long k = 6, unsigned long its = 2, unsigned long l = 0,
+                RandomSVDMethod method = RandomSVDKrylov, RandomSVDProjection projection = RandomSVDUniform)
 {
     // U: (A_rows,k)
     // S: (k)
@@ -532,14 +823,13 @@ void random_svd(const T* A, const unsigned long A_rows, const unsigned long A_co
         throw gException("k must be <= the smallest dimension of A");
 
 //    %
-//    % SVD A directly if (its+1)*l >= m/1.25 or (its+1)*l >= n/1.25.
+//    % SVD A directly if the basis would not be much smaller than A.
 //    %
-
-//    if(((its+1)*l >= m/1.25) || ((its+1)*l >= n/1.25))
+    const unsigned long q_max = (method == RandomSVDKrylov)? (its+1)*l : l;
 
     const T thr1 = static_cast<T>(A_rows/1.25);
     const T thr2 = static_cast<T>(A_cols/1.25);
-    const T block_dim = static_cast<T>((its+1)*l);
+    const T block_dim = static_cast<T>(q_max);
 
     if(gt(block_dim, thr1) || eq(block_dim, thr1) || gt(block_dim, thr2) || eq(block_dim, thr2))
     {
@@ -579,233 +869,118 @@ void random_svd(const T* A, const unsigned long A_rows, const unsigned long A_co
         return;
     }
 
-    const T randMax = static_cast<T>(RAND_MAX);
-    const T one = static_cast<T>(1.0);
-    const T two = static_cast<T>(2.0);
+    // Work on op(A), the tall one between A and A': op(A) is rows x cols, rows >= cols
+    const bool transposed = A_rows < A_cols;
+    const unsigned long rows = transposed? A_cols : A_rows;
+    const unsigned long cols = transposed? A_rows : A_cols;
 
-//    if(m >= n)
-    if(A_rows >= A_cols)
-    {
-        const int H_len = A_rows*l;
-
-        T* H = new T[H_len];
-        T* tmp = new T[A_cols*l];
+    // Q: basis for the range of op(A), rows x q
+    const unsigned long q = q_max;
+    T* Q = new T[rows*q];
+    T* H = Q;
 
 //    %
-//    % Apply A to a random matrix, obtaining H.
+//    % Apply op(A) to a random matrix, obtaining H.
 //    %
+    if(projection == RandomSVDSRHT)
+        random_svd_srht(A, A_rows, A_cols, transposed, H, l);
+    else
+    {
 //        H = A*(2*rand(n,l)-ones(n,l));
-        for(T *it =tmp, *end = tmp +(A_cols*l); it != end; ++it)
+        const T randMax = static_cast<T>(RAND_MAX);
+        const T one = static_cast<T>(1.0);
+        const T two = static_cast<T>(2.0);
+
+        T* omega = new T[cols*l];
+        for(T *it = omega, *end = omega +(cols*l); it != end; ++it)
             *it = (two* rand()/randMax) - one;
 
-        dot(A, tmp, H, A_rows, A_cols, A_cols, l, A_rows, l, CblasNoTrans, CblasNoTrans, CblasColMajor);
+        random_svd_apply(A, A_rows, A_cols, transposed, omega, l, H);
+        delete[] omega;
+    }
 
-//    %
-//    % Initialize F to its final size and fill its leftmost block with H.
-//    %
-//      F(1:m, 1:l) = H;
-        const unsigned long F_cols = static_cast<unsigned long>(block_dim);
-        T* F = new T[A_rows*F_cols];
-        copy(F, H, H_len);
+    T* G = new T[cols*std::max(l, q)];
 
-//    %
-//    % Apply A*A' to H a total of its times,
-//    % augmenting F with the new H each time.
-//    %
+    for(unsigned long iter = 1; iter<=its; ++iter)
+    {
+        // Orthonormalizing before multiplying does not change the spanned space but avoids overflow
+        random_svd_orth(H, rows, l);
 
-//      for it = 1:its
-        for(unsigned long iter = 1; iter<=its; ++iter)
-        {
-//        H = (H'*A)';
-//        H = A*H;
-            dot(H, A, tmp, A_rows, l, A_rows, A_cols, l, A_cols, CblasTrans, CblasNoTrans, CblasColMajor);
-            dot(A, tmp, H, A_rows, A_cols, l, A_cols, A_rows, l, CblasNoTrans, CblasTrans, CblasColMajor);
+//        G = op(A)'*H;
+        random_svd_apply(A, A_rows, A_cols, !transposed, H, l, G);
 
-//        F(1:m, (1+it*l):((it+1)*l)) = H;
-            copy(F + (H_len*iter), H, H_len);
-        }
+        if(method == RandomSVDSubspace)
+            random_svd_orth(G, cols, l);
+        else
+            H += rows*l;  // Krylov: keep the previous blocks, F(:, (1+it*l):((it+1)*l)) = H
 
-        delete[] H;
+//        H = op(A)*G;
+        random_svd_apply(A, A_rows, A_cols, transposed, G, l, H);
+    }
 
 //    %
 //    % Form a matrix Q whose columns constitute an orthonormal basis
 //    % for the columns of F.
 //    %
-//      [Q,R,E] = qr(F,0);
-        const unsigned long Q_cols = std::min(A_rows, F_cols);
-        T* Q = new T[A_rows*Q_cols];
-        T* R = NULL;
-        int* E = new int [F_cols];
-
-        qr_econ(F, A_rows, F_cols, Q, R, E);
-
-        delete[] E;
-        delete[] F;
+    random_svd_orth(Q, rows, q);
 
 //    %
-//    % SVD Q'*A to obtain approximations to the singular values
-//    % and right singular vectors of A; adjust the left singular vectors
-//    % of Q'*A to approximate the left singular vectors of A.
+//    % SVD op(A)'*Q to obtain approximations to the singular values
+//    % and right singular vectors of op(A); adjust the left singular vectors
+//    % of Q'*op(A) to approximate the left singular vectors of op(A).
 //    %
-//      [U2,S,V] = svd(Q'*A,'econ');
-        T *U2, *L, *Vt;
-        int U2_rows, U2_cols;
-        int L_len;
-        int Vt_rows, Vt_cols;
+    random_svd_apply(A, A_rows, A_cols, !transposed, Q, q, G);
 
-        delete[] tmp;
-        tmp = new T[Q_cols*A_cols];
+    T *U2, *L, *V2t;
+    int U2_rows, U2_cols;
+    int L_len;
+    int V2t_rows, V2t_cols;
 
-        dot(Q, A, tmp, A_rows, Q_cols, A_rows, A_cols, Q_cols, A_cols, CblasTrans, CblasNoTrans, CblasColMajor);
-        svd(tmp , U2, L, Vt, Q_cols, A_cols, U2_rows, U2_cols, L_len, Vt_rows, Vt_cols, true);
+    // G = U2*L*V2t, so that Q'*op(A) = V2t'*L*U2'
+    svd(G, U2, L, V2t, cols, q, U2_rows, U2_cols, L_len, V2t_rows, V2t_cols, true);
 
-//      U = Q*U2;
-        delete[] tmp;
-        tmp = new T[A_rows*U2_cols];
-        dot(Q, U2, tmp, A_rows, Q_cols, U2_rows, U2_cols, A_rows, U2_cols, CblasNoTrans, CblasNoTrans, CblasColMajor);
+    delete[] G;
 
-//      clear Q U2;
-        delete[] Q;
-        delete[] U2;
+    // Left singular vectors of op(A): Q*V2t(1:k,:)'
+    // Right singular vectors of op(A): U2(:,1:k)
+    T* left = transposed? V : U;
+    T* right = transposed? U : V;
 
-//    %
-//    % Retain only the leftmost k columns of U, the leftmost k columns of V,
-//    % and the uppermost leftmost k x k block of S.
-//    %
-//      U = U(:,1:k);
-        copy(U, tmp, k*A_rows);
-        delete[] tmp;
-
-//      V = V(:,1:k);
-        if(V != NULL)
-        {
-            T* tr = new T[Vt_cols*Vt_rows];
-
-            transpose(Vt, Vt_rows, Vt_cols, tr);
-
-            copy(V, tr, k*Vt_cols);
-            delete[] tr;
-        }
-        delete[] Vt;
+    if(left != NULL)
+        gemm(CblasNoTrans, CblasTrans, rows, k, q, (T)1.0, Q, rows, V2t, V2t_rows, (T)0.0, left, rows);
 
+    if(right != NULL)
+        copy(right, U2, k*cols);
 
 //      S = S(1:k,1:k);
-        copy(S, L, k);
-        delete[] L;
-
-    }
-    else
-    {
-//        %
-//        % Apply A' to a random matrix, obtaining H.
-//        %
-
-        const int H_len = A_cols*l;
-
-//            H = ((2*rand(l,m)-ones(l,m))*A)';
-        T* H = new T[H_len];
-        T* tmp = new T[l*A_rows];
-
-        for(T *it =tmp, *end = tmp +(l*A_rows); it != end; ++it)
-            *it = (two* rand()/randMax) - one;
-
-        dot(A, tmp, H, A_rows, A_cols, l, A_rows, A_cols, l, CblasTrans, CblasTrans, CblasColMajor);
-
+    copy(S, L, k);
 
-//        %
-//        % Initialize F to its final size and fill its leftmost block with H.
-//        %
-//          F = zeros(n,(its+1)*l);
-//          F(1:n, 1:l) = H;
-
-        const unsigned long F_cols = static_cast<unsigned long>(block_dim);
-        T* F = new T[A_cols*F_cols];
-        copy(F, H, H_len);
-
-//        %
-//        % Apply A'*A to H a total of its times,
-//        % augmenting F with the new H each time.
-//        %
-//          for it = 1:its
-        for(unsigned long iter = 1; iter<=its; ++iter)
-        {
-//            H = A*H;
-            dot(A, H, tmp, A_rows, A_cols, A_cols, l, A_rows, l, CblasNoTrans, CblasNoTrans, CblasColMajor);
-
-//            H = (H'*A)';
-            dot(A, tmp, H, A_rows, A_cols, A_rows, l, A_cols, l, CblasTrans, CblasNoTrans, CblasColMajor);
-
-//            F(1:n, (1+it*l):((it+1)*l)) = H;
-            copy(F + (H_len*iter), H, H_len);
-        }
-
-        delete[] H;
-
-//        %
-//        % Form a matrix Q whose columns constitute an orthonormal basis
-//        % for the columns of F.
-//        %
-
-//          [Q,R,E] = qr(F,0);
-        const unsigned long Q_cols = std::min(A_cols, F_cols);
-        T* Q = new T[A_cols*Q_cols];
-        T* R = NULL;
-        int* E = new int [F_cols];
-
-        qr_econ(F, A_cols, F_cols, Q, R, E);
-
-        delete[] E;
-        delete[] F;
-
-//        %
-//        % SVD A*Q to obtain approximations to the singular values
-//        % and left singular vectors of A; adjust the right singular vectors
-//        % of A*Q to approximate the right singular vectors of A.
-//        %
-
-//          [U,S,V2] = svd(A*Q,'econ');
-        T *U2, *L, *Vt;
-        int U2_rows, U2_cols;
-        int L_len;
-        int Vt_rows, Vt_cols;
-
-        delete[] tmp;
-        tmp = new T[A_rows*Q_cols];
-
-        dot(A, Q, tmp, A_rows, A_cols, A_cols, Q_cols, A_rows, Q_cols, CblasNoTrans, CblasNoTrans, CblasColMajor);
-        svd(tmp, U2, L, Vt, A_rows, Q_cols, U2_rows, U2_cols, L_len, Vt_rows, Vt_cols, true);
-
-//          V = Q*V2;
-        delete[] tmp;
-        if(V != NULL)
-        {
-            tmp = new T[A_cols*Vt_rows];
-            dot(Q, Vt, tmp, A_cols, Q_cols, Vt_rows, Vt_cols, A_cols, Vt_rows, CblasNoTrans, CblasTrans, CblasColMajor);
-        }
-
-        delete[] Vt;
-        delete[] Q;
-
-//        %
-//        % Retain only the leftmost k columns of U, the leftmost k columns of V,
-//        % and the uppermost leftmost k x k block of S.
-//        %
-
-//          U = U(:,1:k);
-        copy(U, U2, k*U2_rows);
-        delete[] U2;
-
-//          V = V(:,1:k);
-        if(V != NULL)
-            copy(V, tmp, k*A_cols);
+    delete[] Q;
+    delete[] U2;
+    delete[] L;
+    delete[] V2t;
+}
 
-        delete[] tmp;
+/**
+ * Calls \ref random_svd with the parameters stored in \a opt:
+ *  - eig_oversampling: l = k + eig_oversampling
+ *  - eig_iterations: number of Krylov or subspace iterations
+ *  - eig_method: "krylov" or "subspace"
+ *  - eig_projection: "uniform" or "srht"
+ */
+template <typename T>
+void random_svd(const T* A, const unsigned long A_rows, const unsigned long A_cols,
+                T* U, T* S, T* V, const unsigned long k, const GurlsOptionsList& opt)
+{
+    const unsigned long oversampling = static_cast<unsigned long>(opt.getOptAsNumber("eig_oversampling"));
+    const unsigned long its = static_cast<unsigned long>(opt.getOptAsNumber("eig_iterations"));
 
-//          S = S(1:k,1:k);
-        copy(S, L, k);
-        delete[] L;
+    const std::string method = opt.getOptAsString("eig_method");
+    const std::string projection = opt.getOptAsString("eig_projection");
 
-    }
+    random_svd(A, A_rows, A_cols, U, S, V, k, its, k+oversampling,
+               (method == "subspace")? RandomSVDSubspace : RandomSVDKrylov,
+               (projection == "srht")? RandomSVDSRHT : RandomSVDUniform);
 }
 
 /**
@@ -862,6 +1037,56 @@ void GInverseDiagonal(const T* Q, const T* L, const T* lambda, T* Z,
 
 }
 
+/**
+ * Computes the diagonal of \f$(K + n\lambda I)^{-1}\f$ when only the leading \a Q_cols eigenpairs of
+ * the kernel matrix are known. The eigenvalues of the discarded tail are all approximated by \a tail,
+ * so that Z = D*(L+n*lambda).^(-1) + (1 - sum(D,2))/(tail+n*lambda), with D = Q.^2.
+ *
+ * \param Q leading eigenvectors of the kernel matrix (Q_rows x Q_cols)
+ * \param L leading eigenvalues of the kernel matrix
+ * \param lambda vector of regularization parameters
+ * \param tail approximation of the eigenvalues not included in L
+ * \param Z on exit contains the diagonals, one column for each lambda (Q_rows x lambda_length)
+ * \param Q_rows number of rows of Q
+ * \param Q_cols number of columns of Q
+ * \param L_length number of elements of L
+ * \param lambda_length number of elements of lambda
+ * \param work work buffer of length (Q_rows*(Q_cols+1))+L_length
+ */
+template<typename T>
+void GInverseDiagonalTruncated(const T* Q, const T* L, const T* lambda, const T tail, T* Z,
+                    const int Q_rows, const int Q_cols,
+                    const int L_length, const int lambda_length, T* work)
+{
+    //D = Q.^(2);
+    const int Q_size = Q_rows*Q_cols;
+    T* D = work;// size Q_size
+    mult(Q, Q, D, Q_size);
+
+    //Dr = 1 - sum(D,2);
+    T* Dr = work+Q_size; // size Q_rows
+    set(Dr, (T)1.0, Q_rows);
+    for(int j=0; j<Q_cols; ++j)
+        axpy(Q_rows, (T)-1.0, D+(Q_rows*j), 1, Dr, 1);
+
+    T* d = Dr+Q_rows; // size L_length
+
+    for(int i=0; i<lambda_length; ++i)
+    {
+        const T nl = Q_rows*lambda[i];
+
+//    d = (L + (n*lambda(i))).^(-1);
+        set(d, nl, L_length);
+        axpy(L_length, (T)1.0, L, 1, d, 1);
+        setReciprocal(d, L_length);
+
+//    Z(:,i) = D*d + Dr/(tail+n*lambda(i));
+        T* Zi = Z+(i*Q_rows);
+        copy(Zi, Dr, Q_rows);
+        gemv(CblasNoTrans, Q_rows, Q_cols, (T)1.0, D, Q_rows, d, 1, ((T)1.0)/(tail+nl), Zi, 1);
+    }
+}
+
 template<typename T>
 gMat2D<T>* rls_primal_driver(T* K, const T* Xty, const unsigned long n, const unsigned long d, const unsigned long Yd, const T lambda)
 {
@@ -974,11 +1199,168 @@ gMat2D<T>* rp_projections(const unsigned long d, const unsigned long D)
     return W;
 }
 
+/**
+ * Draws the random signs of the structured orthogonal random features (SORF) proposed in:
+ *  Felix Yu, Ananda Theertha Suresh, Krzysztof Choromanski, Daniel Holtmann-Rice, Sanjiv Kumar;
+ *  Orthogonal Random Features;
+ *  in Neural Information Processing Systems (NIPS) 2016.
+ * The D projections are split in blocks of p = 2^ceil(log2(d)) columns, each one equal to
+ * sqrt(2p)*H*D1*H*D2*H*D3 where H is the normalized Walsh-Hadamard matrix of order p and D1, D2, D3
+ * are diagonal matrices of random signs. The same \a seed always gives the same projections.
+ *
+ * \returns a vector of 3*p*ceil(D/p) signs, [D1 D2 D3] for each block, to be freed by the caller
+ */
 template<typename T>
-gMat2D<T>* rp_factorize_large_real(const gMat2D<T> &X, const gMat2D<T> &y, const unsigned long D,
-                                   const unsigned long psize, T* XtX, T*Xty)
+T* rp_sorf_signs(const unsigned long d, const unsigned long D, const unsigned long seed)
+{
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
+
+    const unsigned long size = 3*pow2*((D+pow2-1)/pow2);
+
+    boost::random::mt19937 gen(static_cast<boost::uint32_t>(seed));
+
+    T* signs = new T[size];
+    for(T *it = signs, *const end = signs+size; it != end; ++it)
+        *it = (gen() & 1)? (T)1.0 : (T)-1.0;
+
+    return signs;
+}
+
+/**
+ * Computes V = X*W where W is the d x D structured projection matrix described by \a signs
+ * (see rp_sorf_signs()), in O(D log d) operations per row and without forming W.
+ *
+ * \param X input matrix, rows x d with leading dimension ldX
+ * \param V output matrix, rows x D with leading dimension ldV
+ * \param work work buffer of 2^ceil(log2(d)) elements
+ */
+template<typename T>
+void rp_sorf_project(const T* X, const unsigned long ldX, const unsigned long rows, const unsigned long d,
+                     const unsigned long D, const T* signs, T* V, const unsigned long ldV, T* work)
+{
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
+
+    const unsigned long nBlocks = (D+pow2-1)/pow2;
+
+    // sqrt(2p) times the normalization of three unnormalized transforms
+    const T scale = static_cast<T>(sqrt(2.0)/pow2);
+
+    for(unsigned long r=0; r<rows; ++r)
+    {
+        for(unsigned long b=0; b<nBlocks; ++b)
+        {
+            const T* D1 = signs + (3*pow2*b);
+            const T* D2 = D1 + pow2;
+            const T* D3 = D2 + pow2;
+
+            // work = D3*[x 0]'
+            for(unsigned long j=0; j<d; ++j)
+                work[j] = X[r + j*ldX]*D3[j];
+            set(work+d, (T)0.0, pow2-d);
+
+            fwht(work, pow2);
+            mult(work, D2, work, pow2);
+            fwht(work, pow2);
+            mult(work, D1, work, pow2);
+            fwht(work, pow2);
+
+            const unsigned long cols = std::min(pow2, D-b*pow2);
+            T* V_it = V + r + (b*pow2)*ldV;
+            for(unsigned long j=0; j<cols; ++j, V_it += ldV)
+                *V_it = scale*work[j];
+        }
+    }
+}
+
+/**
+ * Returns the dense d x D matrix of the structured projections generated by \a seed
+ */
+template<typename T>
+gMat2D<T>* rp_sorf_projections(const unsigned long d, const unsigned long D, const unsigned long seed)
 {
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
+
+    T* signs = rp_sorf_signs<T>(d, D, seed);
+    T* work = new T[pow2];
+
+//    W = eye(d)*W;
+    gMat2D<T>* I = new gMat2D<T>(d, d);
+    set(I->getData(), (T)0.0, d*d);
+    set(I->getData(), (T)1.0, d, d+1);
 
+    gMat2D<T>* W = new gMat2D<T>(d, D);
+    rp_sorf_project(I->getData(), d, d, d, D, signs, W->getData(), d, work);
+
+    delete I;
+    delete [] work;
+    delete [] signs;
+
+    return W;
+}
+
+/**
+ * Computes the random features G = [cos(V) sin(V)], V = X*W, of the structured projections generated by \a seed
+ */
+template<typename T>
+gMat2D<T>* rp_apply_sorf(const gMat2D<T> &X, const unsigned long D, const unsigned long seed)
+{
+    const unsigned long n = X.rows();
+    const unsigned long d = X.cols();
+
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
+
+    T* signs = rp_sorf_signs<T>(d, D, seed);
+
+    gMat2D<T> *G = new gMat2D<T>(n, 2*D);
+    T *V = G->getData() + (n*D);
+
+    const long blockRows = 64;
+
+#pragma omp parallel
+    {
+        T* work = new T[pow2];
+
+#pragma omp for schedule(dynamic)
+        for(long r0 = 0; r0 < static_cast<long>(n); r0 += blockRows)
+        {
+            const unsigned long nr = std::min(static_cast<unsigned long>(blockRows), n-r0);
+
+//            V = X*W;
+            rp_sorf_project(X.getData()+r0, n, nr, d, D, signs, V+r0, n, work);
+        }
+
+        delete [] work;
+    }
+
+//    G = [cos(V) sin(V)];
+    for(T *G_it = G->getData(), *const V_end = V+(n*D); V != V_end; ++G_it, ++V)
+    {
+        *G_it = cos(*V);
+        *V = sin(*V);
+    }
+
+    delete [] signs;
+
+    return G;
+}
+
+/**
+ * Accumulates GG = G'*G and Gy = G'*y for the random features G = [cos(X*W) sin(X*W)], blocks of rows
+ * being processed in parallel. The projections are either the dense d x D matrix \a W or, if \a W is NULL,
+ * the structured ones described by \a signs.
+ */
+template<typename T>
+void rp_factorize_features(const gMat2D<T> &X, const gMat2D<T> &y, const unsigned long D, const unsigned long psize,
+                           const T* W, const T* signs, T* XtX, T*Xty)
+{
 //    d = size(X,2);
 //    n = size(X,1);
 //    T = size(y,2);
@@ -987,61 +1369,134 @@ gMat2D<T>* rp_factorize_large_real(const gMat2D<T> &X, const gMat2D<T> &y, const
     const unsigned long n = X.rows();
     const unsigned long t = y.cols();
 
-//    W = rp_projections(d,D,kernel);
-    gMat2D<T>* W = rp_projections<T>(d, D);
+    unsigned long pow2 = 1;
+    while(pow2 < d)
+        pow2 <<= 1;
 
     const unsigned long D2 = 2*D;
 
-//    GG = zeros(D*2,D*2);
-    set(XtX, (T)0.0, D2*D2);
+    // Rows projected at once: the cos/sin features of a block stay in cache
+    // and are never formed for a whole chunk of psize rows
+    const unsigned long blockRows = std::max(std::min(psize, 512ul), 1ul);
+    const long nBlocks = static_cast<long>((n+blockRows-1)/blockRows);
 
-//    Gy = zeros(D*2,T);
-    set(Xty, (T)0.0, D2*t);
+    // One GG and Gy accumulator per thread, stored contiguously
+    std::vector<T*> accumulators;
+    const unsigned long accSize = D2*D2 + D2*t;
 
+#pragma omp parallel
+    {
+        T* Gi = new T[blockRows*D2];
+        T* work = (W == NULL)? new T[pow2] : NULL;
+        T* acc = NULL;
 
-    T* Xi = new T[psize*d];
-    T* yi = new T[psize*t];
+//    for i=1:psize:n
+#pragma omp for schedule(dynamic)
+        for(long b=0; b<nBlocks; ++b)
+        {
+            if(acc == NULL)
+            {
+                acc = new T[accSize];
+                set(acc, (T)0.0, accSize);
 
-    const T alpha = (T)1.0;
-    const T beta = (T)1.0;
+#pragma omp critical(rp_factorize_features)
+                accumulators.push_back(acc);
+            }
 
-//    for i=1:psize:n
-    for(unsigned long i=0; i< n; i+=psize)
-    {
 //        bend = min(i+psize-1,n);
-        unsigned long bend = std::min(i+psize, n);
+            const unsigned long i = b*blockRows;
+            const unsigned long rows = std::min(blockRows, n-i);
 
 //        Gi = rp_apply_real(X(i:bend,:),W);
-//        yi = y(i:bend,:);
+            T* V = Gi + (blockRows*D);
+            if(W != NULL)
+                gemm(CblasNoTrans, CblasNoTrans, rows, D, d, (T)1.0, X.getData()+i, n, W, d, (T)0.0, V, blockRows);
+            else
+                rp_sorf_project(X.getData()+i, n, rows, d, D, signs, V, blockRows, work);
 
-        unsigned long rows = bend-i;
+            for(unsigned long j=0; j<D; ++j)
+            {
+                T* G_it = Gi + (j*blockRows);
+                T* V_it = V + (j*blockRows);
+
+                for(T* const V_end = V_it+rows; V_it != V_end; ++G_it, ++V_it)
+                {
+                    *G_it = cos(*V_it);
+                    *V_it = sin(*V_it);
+                }
+            }
 
-        const T *X_it = X.getData() + i, *y_it = y.getData() + i;
-        T *Xi_it = Xi, *yi_it = yi;
+//        GG = GG + Gi'*Gi;
+            syrk(CblasUpper, CblasTrans, D2, rows, (T)1.0, Gi, blockRows, (T)1.0, acc, D2);
+
+//        Gy = Gy + Gi'*yi;
+            gemm(CblasTrans, CblasNoTrans, D2, t, rows, (T)1.0, Gi, blockRows, y.getData()+i, n, (T)1.0, acc+(D2*D2), D2);
+        }
 
-        for(unsigned long j=0; j<d; ++j, X_it+=n, Xi_it+=rows)
-            copy(Xi_it, X_it, rows);
+        delete [] Gi;
+        delete [] work;
+    }
 
-        for(unsigned long j=0; j<t; ++j, y_it+=n, yi_it+=rows)
-            copy(yi_it, y_it, rows);
+    // Pairwise tree reduction of the per-thread accumulators
+    const unsigned long nAcc = accumulators.size();
+    for(unsigned long s=1; s<nAcc; s*=2)
+    {
+        const long pairs = static_cast<long>((nAcc-s + 2*s-1)/(2*s));
 
-        gMat2D<T> *Gi = rp_apply_real(Xi, W->getData(), rows, d, D);
+#pragma omp parallel for
+        for(long k=0; k<pairs; ++k)
+            axpy(accSize, (T)1.0, accumulators[2*s*k+s], 1, accumulators[2*s*k], 1);
+    }
 
-//        GG = GG + Gi'*Gi;
-        gemm(CblasTrans, CblasNoTrans, D2, D2, rows, alpha, Gi->getData(), rows, Gi->getData(), rows, beta, XtX, D2);
+//    GG = zeros(D*2,D*2);
+    set(XtX, (T)0.0, D2*D2);
 
-//        Gy = Gy + Gi'*yi;
-        gemm(CblasTrans, CblasNoTrans, D2, t, rows, alpha, Gi->getData(), rows, yi, rows, beta, Xty, D2);
+//    Gy = zeros(D*2,T);
+    set(Xty, (T)0.0, D2*t);
+
+    if(nAcc > 0)
+    {
+        const T* acc = accumulators[0];
 
-        delete Gi;
+        // syrk only fills the upper triangle
+        for(unsigned long j=0; j<D2; ++j)
+            for(unsigned long i=0; i<=j; ++i)
+                XtX[i+j*D2] = XtX[j+i*D2] = acc[i+j*D2];
+
+        copy(Xty, acc+(D2*D2), D2*t);
     }
 
-    delete [] Xi;
-    delete [] yi;
+    for(unsigned long k=0; k<nAcc; ++k)
+        delete [] accumulators[k];
+}
+
+template<typename T>
+gMat2D<T>* rp_factorize_large_real(const gMat2D<T> &X, const gMat2D<T> &y, const unsigned long D,
+                                   const unsigned long psize, T* XtX, T*Xty)
+{
+//    W = rp_projections(d,D,kernel);
+    gMat2D<T>* W = rp_projections<T>(X.cols(), D);
+
+    rp_factorize_features(X, y, D, psize, W->getData(), (const T*)NULL, XtX, Xty);
 
     return W;
 }
 
+/**
+ * Same as rp_factorize_large_real(), with the structured projections generated by \a seed in place of
+ * a dense Gaussian matrix
+ */
+template<typename T>
+void rp_factorize_large_sorf(const gMat2D<T> &X, const gMat2D<T> &y, const unsigned long D,
+                             const unsigned long psize, const unsigned long seed, T* XtX, T*Xty)
+{
+    T* signs = rp_sorf_signs<T>(X.cols(), D, seed);
+
+    rp_factorize_features(X, y, D, psize, (const T*)NULL, signs, XtX, Xty);
+
+    delete [] signs;
+}
+
 }
 
 #endif // _GURLS_UTILS_H_
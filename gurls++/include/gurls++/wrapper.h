@@ -45,6 +45,7 @@
 #include "gurls++/gvec.h"
 #include "gurls++/gmat2d.h"
 #include "gurls++/optlist.h"
+#include "gurls++/compiledpredictor.h"
 
 namespace gurls
 {
@@ -98,6 +99,14 @@ public:
       */
     virtual gMat2D<T>* eval(const gMat2D<T> &X) = 0;
 
+    /**
+      * Takes an immutable snapshot of the trained model, to be used for
+      * allocation-free and thread-safe predictions
+      *
+      * \returns A new CompiledPredictor, owned by the caller
+      */
+    virtual CompiledPredictor<T>* compile();
+
     /**
       * Returns a const reference to the options structure
       */
@@ -117,8 +126,13 @@ public:
       */
     virtual void loadModel(const std::string &fileName);
 
-//    virtual void exportModel(const std::string &fileName);
-//    virtual void importModel(const std::string &fileName);
+    /**
+      * Saves only the parameters needed for prediction to a compact binary file,
+      * which can be loaded with CompiledPredictor::load()
+      *
+      * \param fileName name of the file where data will be saved
+      */
+    virtual void exportModel(const std::string &fileName);
 
     /**
       *
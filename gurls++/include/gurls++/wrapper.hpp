@@ -45,6 +45,12 @@ T GurlsWrapper<T>::eval(const gVec<T> &X, unsigned long *index)
     return ret;
 }
 
+template <typename T>
+CompiledPredictor<T>* GurlsWrapper<T>::compile()
+{
+    throw gException(Exception_Functionality_Not_Implemented);
+}
+
 template <typename T>
 const GurlsOptionsList &GurlsWrapper<T>::getOpt() const
 {
@@ -63,6 +69,24 @@ void GurlsWrapper<T>::loadModel(const std::string &fileName)
     opt->load(fileName);
 }
 
+template <typename T>
+void GurlsWrapper<T>::exportModel(const std::string &fileName)
+{
+    CompiledPredictor<T>* predictor = compile();
+
+    try
+    {
+        predictor->save(fileName);
+    }
+    catch(gException&)
+    {
+        delete predictor;
+        throw;
+    }
+
+    delete predictor;
+}
+
 template <typename T>
 void GurlsWrapper<T>::setNparams(unsigned long value)
 {
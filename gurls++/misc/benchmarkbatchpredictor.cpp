@@ -0,0 +1,194 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-1013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \ingroup Tutorials
+ * \file
+ * \brief Throughput and latency of single-point predictions served through a BatchPredictor
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <ctime>
+
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "gurls++/gmat2d.h"
+#include "gurls++/gvec.h"
+#include "gurls++/rlswrapper.h"
+#include "gurls++/kernelrlswrapper.h"
+#include "gurls++/batchpredictor.h"
+
+using namespace gurls;
+using namespace std;
+
+typedef double T;
+
+/**
+  * Returns the elapsed time in seconds since \a begin
+  */
+double elapsed(const boost::posix_time::ptime& begin)
+{
+    return (boost::posix_time::microsec_clock::local_time() - begin).total_microseconds()/1.0e6;
+}
+
+/**
+  * Synthetic client: submits \a requests rows of \a X, one at a time, waiting for each result
+  */
+void client(BatchPredictor<T>* server, const gMat2D<T>* X, unsigned long first, unsigned long requests)
+{
+    const unsigned long n = X->rows();
+    const unsigned long d = X->cols();
+
+    vector<T> x(d);
+    vector<T> y(server->outputs());
+
+    for(unsigned long r = 0; r < requests; ++r)
+    {
+        const unsigned long i = (first + r) % n;
+        for(unsigned long j = 0; j < d; ++j)
+            x[j] = X->getData()[i + n*j];
+
+        server->predict(&x[0], &y[0]);
+    }
+}
+
+/**
+  * Evaluates the requests one at a time with GurlsWrapper::eval, then serves them from \a clients
+  * concurrent threads through BatchPredictor instances with different batch sizes.
+  */
+void benchmark(const string& name, GurlsWrapper<T>& wrapper, const gMat2D<T>& Xte, unsigned long clients, unsigned long requests)
+{
+    const unsigned long d = Xte.cols();
+    const unsigned long n = Xte.rows();
+    const unsigned long total = clients*requests;
+
+    gVec<T> x(d);
+    boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+    for(unsigned long r = 0; r < total; ++r)
+    {
+        for(unsigned long j = 0; j < d; ++j)
+            x[j] = Xte.getData()[(r % n) + n*j];
+        wrapper.eval(x);
+    }
+    const double t_eval = elapsed(begin);
+
+    cout << name << ": " << total << " requests from " << clients << " clients" << endl;
+    cout << setw(10) << "batch" << setw(10) << "wait(us)" << setw(12) << "req/s" << setw(10) << "avg size"
+         << setw(10) << "p50(us)" << setw(10) << "p90(us)" << setw(10) << "p99(us)" << setw(10) << "max(us)" << endl;
+    cout << setw(10) << "eval" << setw(10) << "-" << setw(12) << total/t_eval << endl;
+
+    const unsigned long batchSizes[] = {1, 8, 32, 128};
+    const unsigned long waits[] = {50, 500};
+
+    for(int b = 0; b < 4; ++b)
+        for(int w = 0; w < 2; ++w)
+        {
+            BatchPredictor<T> server(wrapper, batchSizes[b], waits[w]);
+            server.resetStats();
+
+            boost::thread_group group;
+            for(unsigned long c = 0; c < clients; ++c)
+                group.create_thread(boost::bind(client, &server, &Xte, c*requests, requests));
+            group.join_all();
+
+            const BatchPredictor<T>::Stats s = server.stats();
+
+            cout << setw(10) << batchSizes[b] << setw(10) << waits[w] << setw(12) << s.throughput << setw(10) << s.meanBatchSize
+                 << setw(10) << s.latencyP50 << setw(10) << s.latencyP90 << setw(10) << s.latencyP99 << setw(10) << s.latencyMax << endl;
+        }
+
+    cout << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    srand(static_cast<unsigned int>(time(NULL)));
+
+    if (argc > 1 && string(argv[1]) == "-h")
+    {
+        cout << "Usage: " << argv[0] << " [n_train] [d] [clients] [requests per client]" << endl;
+        return EXIT_SUCCESS;
+    }
+
+    const unsigned long n = (argc > 1)? strtoul(argv[1], NULL, 10) : 2000;
+    const unsigned long d = (argc > 2)? strtoul(argv[2], NULL, 10) : 50;
+    const unsigned long clients = (argc > 3)? strtoul(argv[3], NULL, 10) : 16;
+    const unsigned long requests = (argc > 4)? strtoul(argv[4], NULL, 10) : 500;
+    const unsigned long t = 2;
+
+    try
+    {
+        // two gaussian blobs, one-vs-all labels
+        gMat2D<T> X(n, d), y(n, t), Xte(n, d);
+
+        for(unsigned long i = 0; i < n; ++i)
+        {
+            const unsigned long c = i % t;
+            for(unsigned long j = 0; j < d; ++j)
+            {
+                X(i, j) = (T)c + rand()/(T)RAND_MAX;
+                Xte(i, j) = (T)((i+1) % t) + rand()/(T)RAND_MAX;
+            }
+            for(unsigned long k = 0; k < t; ++k)
+                y(i, k) = (k == c)? (T)1.0 : (T)-1.0;
+        }
+
+        RLSWrapper<T> rls("benchmarkbatchpredictor_rls");
+        rls.train(X, y);
+        benchmark("RLSWrapper", rls, Xte, clients, requests);
+
+        KernelRLSWrapper<T> krls("benchmarkbatchpredictor_krls");
+        krls.train(X, y);
+        benchmark("KernelRLSWrapper (rbf)", krls, Xte, clients, requests);
+
+        return EXIT_SUCCESS;
+    }
+    catch (gException& e)
+    {
+        cout << e.getMessage() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,166 @@
+/*
+ * The GURLS Package in C++
+ *
+ * Copyright (C) 2011-1013, IIT@MIT Lab
+ * All rights reserved.
+ *
+ * authors:  M. Santoro
+ * email:   msantoro@mit.edu
+ * website: http://cbcl.mit.edu/IIT@MIT/IIT@MIT.html
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ *     * Redistributions of source code must retain the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials
+ *       provided with the distribution.
+ *     * Neither the name(s) of the copyright holders nor the names
+ *       of its contributors or of the Massacusetts Institute of
+ *       Technology or of the Italian Institute of Technology may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/**
+ * \ingroup Tutorials
+ * \file
+ * \brief Accuracy versus speed of the randomized SVD variants on gaussian kernel matrices
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <ctime>
+
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "gurls++/gmat2d.h"
+#include "gurls++/gmath.h"
+#include "gurls++/optlist.h"
+#include "gurls++/rbfkernel.h"
+#include "gurls++/utils.h"
+
+using namespace gurls;
+using namespace std;
+
+typedef double T;
+
+/**
+  * Returns the elapsed time in seconds since \a begin
+  */
+double elapsed(const boost::posix_time::ptime& begin)
+{
+    return (boost::posix_time::microsec_clock::local_time() - begin).total_microseconds()/1.0e6;
+}
+
+/**
+  * For each eig_percentage value, compares the leading eigenvalues of a gaussian kernel matrix
+  * computed by random_svd with different methods, projections and numbers of iterations
+  * against the ones computed by eig_sm.
+  */
+int main(int argc, char *argv[])
+{
+    srand(static_cast<unsigned int>(time(NULL)));
+
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <data file> [sigma]" << endl;
+        return EXIT_SUCCESS;
+    }
+
+    try
+    {
+        gMat2D<T> X;
+        X.readCSV(argv[1]);
+
+        const T sigma = (argc > 2)? static_cast<T>(atof(argv[2])) : (T)1.0;
+
+        GurlsOptionsList opt("benchmarkrandomsvd", true);
+        GurlsOptionsList* paramsel = new GurlsOptionsList("paramsel");
+        paramsel->addOpt("sigma", new OptNumber(sigma));
+        opt.addOpt("paramsel", paramsel);
+
+        KernelRBF<T> rbf;
+        GurlsOptionsList* kernel = rbf.execute(X, X, opt);
+
+        const gMat2D<T>& K = kernel->getOptValue<OptMatrix<gMat2D<T> > >("K");
+        const unsigned long n = K.rows();
+
+        // reference: full eigendecomposition
+        gMat2D<T> Q(K);
+        T* L = new T[n];
+
+        boost::posix_time::ptime begin = boost::posix_time::microsec_clock::local_time();
+        eig_sm(Q.getData(), L, n);
+        const double t_full = elapsed(begin);
+
+        cout << "n = " << n << ", sigma = " << sigma << ", eig_sm time: " << t_full << "s" << endl << endl;
+
+        cout << setw(8) << "eig_%" << setw(6) << "k" << setw(10) << "method" << setw(10) << "proj"
+             << setw(5) << "its" << setw(12) << "time (s)" << setw(14) << "max rel err" << endl;
+
+        const double percentages[] = {1, 5, 10, 20};
+        const RandomSVDMethod methods[] = {RandomSVDKrylov, RandomSVDSubspace};
+        const RandomSVDProjection projections[] = {RandomSVDUniform, RandomSVDSRHT};
+        const unsigned long iterations[] = {0, 1, 2, 4};
+
+        for(int p = 0; p < 4; ++p)
+        {
+            const unsigned long k = std::max(1ul, static_cast<unsigned long>(gurls::round(percentages[p]*n/100.0)));
+
+            T* U = new T[n*k];
+            T* S = new T[k];
+
+            for(int m = 0; m < 2; ++m)
+                for(int pr = 0; pr < 2; ++pr)
+                    for(int i = 0; i < 4; ++i)
+                    {
+                        begin = boost::posix_time::microsec_clock::local_time();
+                        random_svd(K.getData(), n, n, U, S, (T*)NULL, k, iterations[i], k+2, methods[m], projections[pr]);
+                        const double t = elapsed(begin);
+
+                        // eig_sm returns the eigenvalues in ascending order
+                        T err = 0;
+                        for(unsigned long j = 0; j < k; ++j)
+                            err = std::max(err, std::abs(S[j] - L[n-1-j])/L[n-1-j]);
+
+                        cout << setw(8) << percentages[p] << setw(6) << k
+                             << setw(10) << ((methods[m] == RandomSVDKrylov)? "krylov" : "subspace")
+                             << setw(10) << ((projections[pr] == RandomSVDUniform)? "uniform" : "srht")
+                             << setw(5) << iterations[i] << setw(12) << t << setw(14) << err << endl;
+                    }
+
+            delete [] U;
+            delete [] S;
+        }
+
+        delete [] L;
+        delete kernel;
+
+        return EXIT_SUCCESS;
+    }
+    catch (gException& e)
+    {
+        cout << e.getMessage() << endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -81,6 +81,36 @@ GURLS_EXPORT void gemm(const CBLAS_TRANSPOSE TransA, const CBLAS_TRANSPOSE Trans
           const_cast<double*>(C), const_cast<int*>(&ldc));
 }
 
+/**
+  * Specialized version of syrk for float buffers
+  */
+template<>
+GURLS_EXPORT void syrk(const CBLAS_UPLO Uplo, const CBLAS_TRANSPOSE Trans, const int N, const int K,
+          const float alpha, const float *A, const int lda, const float beta, float *C, const int ldc)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+    char trans = BlasUtils::charValue(Trans);
+
+    ssyrk_(&uplo, &trans, const_cast<int*>(&N), const_cast<int*>(&K),
+          const_cast<float*>(&alpha), const_cast<float*>(A), const_cast<int*>(&lda),
+          const_cast<float*>(&beta), C, const_cast<int*>(&ldc));
+}
+
+/**
+  * Specialized version of syrk for double buffers
+  */
+template<>
+GURLS_EXPORT void syrk(const CBLAS_UPLO Uplo, const CBLAS_TRANSPOSE Trans, const int N, const int K,
+          const double alpha, const double *A, const int lda, const double beta, double *C, const int ldc)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+    char trans = BlasUtils::charValue(Trans);
+
+    dsyrk_(&uplo, &trans, const_cast<int*>(&N), const_cast<int*>(&K),
+          const_cast<double*>(&alpha), const_cast<double*>(A), const_cast<int*>(&lda),
+          const_cast<double*>(&beta), C, const_cast<int*>(&ldc));
+}
+
 /**
   * Specialized version of potrf_ for float buffers
   */
@@ -347,4 +377,114 @@ GURLS_EXPORT void swap( int n, double *x, int incx, double *y, int incy)
     dswap_(&n, x, &incx, y, &incy);
 }
 
+/**
+  * Specialized version of ger for float buffers
+  */
+template<>
+GURLS_EXPORT void ger(const int M, const int N, const float alpha, const float *X, const int incX,
+         const float *Y, const int incY, float *A, const int lda)
+{
+    sger_(const_cast<int*>(&M), const_cast<int*>(&N), const_cast<float*>(&alpha),
+          const_cast<float*>(X), const_cast<int*>(&incX), const_cast<float*>(Y), const_cast<int*>(&incY),
+          A, const_cast<int*>(&lda));
+}
+
+/**
+  * Specialized version of ger for double buffers
+  */
+template<>
+GURLS_EXPORT void ger(const int M, const int N, const double alpha, const double *X, const int incX,
+         const double *Y, const int incY, double *A, const int lda)
+{
+    dger_(const_cast<int*>(&M), const_cast<int*>(&N), const_cast<double*>(&alpha),
+          const_cast<double*>(X), const_cast<int*>(&incX), const_cast<double*>(Y), const_cast<int*>(&incY),
+          A, const_cast<int*>(&lda));
+}
+
+/**
+  * Specialized version of syr for float buffers
+  */
+template<>
+GURLS_EXPORT void syr(const CBLAS_UPLO Uplo, const int N, const float alpha, const float *X, const int incX,
+         float *A, const int lda)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+
+    ssyr_(&uplo, const_cast<int*>(&N), const_cast<float*>(&alpha), const_cast<float*>(X), const_cast<int*>(&incX),
+          A, const_cast<int*>(&lda));
+}
+
+/**
+  * Specialized version of syr for double buffers
+  */
+template<>
+GURLS_EXPORT void syr(const CBLAS_UPLO Uplo, const int N, const double alpha, const double *X, const int incX,
+         double *A, const int lda)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+
+    dsyr_(&uplo, const_cast<int*>(&N), const_cast<double*>(&alpha), const_cast<double*>(X), const_cast<int*>(&incX),
+          A, const_cast<int*>(&lda));
+}
+
+/**
+  * Specialized version of symv for float buffers
+  */
+template<>
+GURLS_EXPORT void symv(const CBLAS_UPLO Uplo, const int N, const float alpha, const float *A, const int lda,
+          const float *X, const int incX, const float beta, float *Y, const int incY)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+
+    ssymv_(&uplo, const_cast<int*>(&N), const_cast<float*>(&alpha), const_cast<float*>(A), const_cast<int*>(&lda),
+          const_cast<float*>(X), const_cast<int*>(&incX), const_cast<float*>(&beta), Y, const_cast<int*>(&incY));
+}
+
+/**
+  * Specialized version of symv for double buffers
+  */
+template<>
+GURLS_EXPORT void symv(const CBLAS_UPLO Uplo, const int N, const double alpha, const double *A, const int lda,
+          const double *X, const int incX, const double beta, double *Y, const int incY)
+{
+    char uplo = BlasUtils::charValue(Uplo);
+
+    dsymv_(&uplo, const_cast<int*>(&N), const_cast<double*>(&alpha), const_cast<double*>(A), const_cast<int*>(&lda),
+          const_cast<double*>(X), const_cast<int*>(&incX), const_cast<double*>(&beta), Y, const_cast<int*>(&incY));
+}
+
+/**
+  * Specialized version of symm for float buffers
+  */
+template<>
+GURLS_EXPORT void symm(const CBLAS_SIDE Side, const CBLAS_UPLO Uplo, const int M, const int N,
+          const float alpha, const float *A, const int lda, const float *B, const int ldb,
+          const float beta, float *C, const int ldc)
+{
+    char side = BlasUtils::charValue(Side);
+    char uplo = BlasUtils::charValue(Uplo);
+
+    ssymm_(&side, &uplo, const_cast<int*>(&M), const_cast<int*>(&N),
+          const_cast<float*>(&alpha), const_cast<float*>(A), const_cast<int*>(&lda),
+          const_cast<float*>(B), const_cast<int*>(&ldb), const_cast<float*>(&beta),
+          C, const_cast<int*>(&ldc));
+}
+
+/**
+  * Specialized version of symm for double buffers
+  */
+template<>
+GURLS_EXPORT void symm(const CBLAS_SIDE Side, const CBLAS_UPLO Uplo, const int M, const int N,
+          const double alpha, const double *A, const int lda, const double *B, const int ldb,
+          const double beta, double *C, const int ldc)
+{
+    char side = BlasUtils::charValue(Side);
+    char uplo = BlasUtils::charValue(Uplo);
+
+    dsymm_(&side, &uplo, const_cast<int*>(&M), const_cast<int*>(&N),
+          const_cast<double*>(&alpha), const_cast<double*>(A), const_cast<int*>(&lda),
+          const_cast<double*>(B), const_cast<int*>(&ldb), const_cast<double*>(&beta),
+          C, const_cast<int*>(&ldc));
+}
+
 }
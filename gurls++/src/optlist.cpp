@@ -94,6 +94,8 @@ GurlsOptionsList::GurlsOptionsList(std::string ExpName, bool usedefopt): GurlsOp
         //		opt.kernel.type = 'rbf';
         (*table)["singlelambda"] = new OptFunction("median");
         (*table)["predbagmethod"] = new OptString("vote");
+        // absolute error allowed to the truncated rbf prediction, 0 = exact
+        (*table)["pred_tolerance"] = new OptNumber(0);
 
         // NOTE: lambda is searched between
         // [min(eig_r, opt.smallnumber), eig_1],
@@ -120,12 +122,22 @@ GurlsOptionsList::GurlsOptionsList(std::string ExpName, bool usedefopt): GurlsOp
         (*table)["nlambda"] = new OptNumber(20);
 //        (*table)["nsigma"] =  new OptNumber(10);
         (*table)["eig_percentage"] = new OptNumber(5);
+        (*table)["eig_tol"] = new OptNumber(1e-3);
+        // randomized eigendecomposition: block size is k + eig_oversampling,
+        // eig_method is either "krylov" or "subspace", eig_projection either "uniform" or "srht"
+        (*table)["eig_oversampling"] = new OptNumber(2);
+        (*table)["eig_iterations"] = new OptNumber(2);
+        (*table)["eig_method"] = new OptString("krylov");
+        (*table)["eig_projection"] = new OptString("uniform");
 
 
     // ======================================================== Pegasos option
         (*table)["subsize"]   = new OptNumber(50);
         (*table)["calibfile"] = new OptString("foo");
         (*table)["epochs"]   = new OptNumber(4);
+        // mini-batch pegasos: samples per update, lock-free multi-threaded updates if hogwild > 0
+        (*table)["batchsize"] = new OptNumber(64);
+        (*table)["hogwild"] = new OptNumber(0);
 
         // ============================================================== Quiet
         // Currenty either 0 or 1; levels of verbosity may be implemented later;
@@ -138,6 +150,11 @@ GurlsOptionsList::GurlsOptionsList(std::string ExpName, bool usedefopt): GurlsOp
         GurlsOptionsList * randfeats = new GurlsOptionsList("randfeats");
         randfeats->table->insert(pair<std::string,GurlsOption*>("D", new OptNumber(500)));
         randfeats->table->insert(pair<std::string,GurlsOption*>("samplesize", new OptNumber(100)));
+        // random projections: "gaussian" (dense d x D matrix) or "sorf" (structured orthogonal
+        // projections, regenerated from seed). The default seed gives the same projections on every
+        // run, set a different one for each independent model
+        randfeats->table->insert(pair<std::string,GurlsOption*>("type", new OptString("gaussian")));
+        randfeats->table->insert(pair<std::string,GurlsOption*>("seed", new OptNumber(0)));
 
         (*table)["randfeats"] = randfeats;
 
@@ -489,12 +506,17 @@ void GurlsOptionsList::save(const std::string& fileName) const
     if(!outstream.is_open())
         throw gException("Could not open file " + fileName);
 
-    oarchive outar(outstream);
-    outar << *this;
+    save(outstream);
 
     outstream.close();
 }
 
+void GurlsOptionsList::save(std::ostream& outstream) const
+{
+    oarchive outar(outstream);
+    outar << *this;
+}
+
 void GurlsOptionsList::load(const std::string& fileName)
 {
 #ifndef USE_BINARY_ARCHIVES
@@ -520,6 +542,19 @@ void GurlsOptionsList::load(const std::string& fileName)
     instream.close();
 }
 
+void GurlsOptionsList::load(std::istream& instream)
+{
+    try
+    {
+        iarchive inar(instream);
+        inar >> *this;
+    }
+    catch(boost::archive::archive_exception&)
+    {
+        throw gException("Invalid archive format");
+    }
+}
+
 
 }
 
@@ -7,6 +7,7 @@
 #include "chisquaredkernel.h"
 
 #include "predkerneltraintest.h"
+#include "predrandfeats.h"
 
 #include "precisionrecall.h"
 #include "macroavg.h"
@@ -18,6 +19,8 @@
 #include "rlsdual.h"
 #include "rlsdualr.h"
 #include "rlspegasos.h"
+#include "rlspegasosbatch.h"
+#include "rlsrandfeats.h"
 
 #include "loocvprimal.h"
 #include "loocvdual.h"
@@ -38,8 +41,20 @@
 #include "gap.h"
 #include "maxscore.h"
 
+#include "kernelrlswrapper.h"
+#include "icholwrapper.h"
+#include "recrlswrapper.h"
+#include "datareader.h"
+#include "primalaccumulator.h"
+#include "compiledpredictor.h"
+#include "randfeatswrapper.h"
+
 #include <cstdlib>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #define BOOST_TEST_DYN_LINK
 #define BOOST_TEST_MODULE yeast
 
@@ -492,4 +507,1189 @@ BOOST_AUTO_TEST_CASE(TestConfBoltzmanGap)
     fixture.checkResults("conf");
 }
 
+BOOST_AUTO_TEST_CASE(TestPredDualTruncated)
+{
+    // the truncated rbf prediction is compared with the exact one, computed from the full test kernel
+    srand(0);
+
+    const unsigned long n = 1000;
+    const unsigned long nte = 200;
+    const unsigned long d = 3;
+
+    gurls::gMat2D<T> X(n, d), Y(n, 2), Xte(nte, d);
+
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 10*static_cast<T>(rand())/RAND_MAX;
+
+    for(unsigned long i = 0; i < Xte.getSize(); ++i)
+        Xte.getData()[i] = 10*static_cast<T>(rand())/RAND_MAX;
+
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y(i, 0) = (sin(X(i, 0)) + cos(X(i, 1)) > 0)? 1: -1;
+        Y(i, 1) = -Y(i, 0);
+    }
+
+    gurls::KernelRLSWrapper<T> wrapper("truncated");
+    wrapper.setNSigma(1);
+    wrapper.setSigma(0.5);
+    wrapper.setNparams(1);
+    wrapper.setParam(1e-3);
+    wrapper.train(X, Y);
+
+    gurls::gMat2D<T>* exact = wrapper.eval(Xte);
+
+    const T tolerances[] = {1e-2, 1e-4, 1e-6, 1e-8};
+    for(int k = 0; k < 4; ++k)
+    {
+        wrapper.setPredTolerance(tolerances[k]);
+
+        gurls::gMat2D<T>* truncated = wrapper.eval(Xte);
+
+        T error = 0;
+        for(unsigned long i = 0; i < exact->getSize(); ++i)
+            error = std::max(error, std::abs(truncated->getData()[i] - exact->getData()[i]));
+
+        BOOST_CHECK_LE(error, tolerances[k]);
+
+        delete truncated;
+    }
+
+    delete exact;
+}
+
+BOOST_AUTO_TEST_CASE(TestICholUpdate)
+{
+    // after a stream of updates the factorization is compared with the one recomputed from the stored samples:
+    // G = Q*R, Q'*Q = I and G*G(pivots,:)' = K(:,pivots)
+    srand(0);
+
+    const unsigned long n = 300;
+    const unsigned long nup = 200;
+    const unsigned long nva = 100;
+    const unsigned long d = 2;
+    const unsigned long t = 2;
+    const T sigma = 0.5;
+
+    gurls::gMat2D<T> X(n+nup, d), Y(n+nup, t), Xva(nva, d), yva(nva, t);
+
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 4*static_cast<T>(rand())/RAND_MAX;
+
+    // the updates come from a shifted region, so that they also add pivots
+    for(unsigned long i = n; i < n+nup; ++i)
+        X(i, 0) += 3;
+
+    for(unsigned long i = 0; i < n+nup; ++i)
+    {
+        Y(i, 0) = (sin(2*X(i, 0))*cos(X(i, 1)) > 0)? 1: -1;
+        Y(i, 1) = -Y(i, 0);
+    }
+
+    gurls::gMat2D<T> X0(n, d), y0(n, t);
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        for(unsigned long k = 0; k < d; ++k)
+            X0(i, k) = X(i, k);
+        for(unsigned long k = 0; k < t; ++k)
+            y0(i, k) = Y(i, k);
+    }
+
+    for(unsigned long i = 0; i < nva; ++i)
+    {
+        for(unsigned long k = 0; k < d; ++k)
+            Xva(i, k) = X(i, k);
+        for(unsigned long k = 0; k < t; ++k)
+            yva(i, k) = Y(i, k);
+    }
+
+    gurls::ICholWrapper<T> wrapper("ichol");
+    wrapper.setRankMax(60);
+    wrapper.setNRank(6);
+    wrapper.setSigma(sigma);
+    wrapper.setXva(Xva);
+    wrapper.setyva(yva);
+    wrapper.train(X0, y0);
+
+    for(unsigned long i = n; i < n+nup; ++i)
+    {
+        gurls::gVec<T> x(d), y(t);
+        for(unsigned long k = 0; k < d; ++k)
+            x[k] = X(i, k);
+        for(unsigned long k = 0; k < t; ++k)
+            y[k] = Y(i, k);
+
+        wrapper.update(x, y);
+    }
+
+    const gurls::GurlsOptionsList& opt = wrapper.getOpt();
+    const gurls::gMat2D<T>& G = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("paramsel.G");
+    const gurls::gMat2D<T>& Q = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("paramsel.Q");
+    const gurls::gMat2D<T>& R = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("paramsel.R");
+    const gurls::gMat2D<unsigned long>& pVec = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<unsigned long> > >("paramsel.pVec");
+    const gurls::gMat2D<T>& Xtr = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.X");
+
+    const unsigned long nn = G.rows();
+    const unsigned long r = G.cols();
+
+    BOOST_REQUIRE_EQUAL(nn, n+nup);
+    BOOST_REQUIRE_EQUAL(Xtr.rows(), n+nup);
+
+    const T* G_data = G.getData();
+    const T* Q_data = Q.getData();
+    const T* R_data = R.getData();
+    const T* X_data = Xtr.getData();
+    const unsigned long* P = pVec.getData();
+
+    T errQR = 0, errOrth = 0, errK = 0;
+
+    for(unsigned long i = 0; i < nn; ++i)
+        for(unsigned long j = 0; j < r; ++j)
+        {
+            T QR_ij = 0;
+            for(unsigned long l = 0; l < r; ++l)
+                QR_ij += Q_data[i+nn*l]*R_data[l+r*j];
+            errQR = std::max(errQR, std::abs(QR_ij - G_data[i+nn*j]));
+        }
+
+    for(unsigned long a = 0; a < r; ++a)
+        for(unsigned long b = 0; b < r; ++b)
+        {
+            T QtQ_ab = 0;
+            for(unsigned long i = 0; i < nn; ++i)
+                QtQ_ab += Q_data[i+nn*a]*Q_data[i+nn*b];
+            errOrth = std::max(errOrth, std::abs(QtQ_ab - ((a == b)? 1: 0)));
+        }
+
+    for(unsigned long i = 0; i < nn; ++i)
+        for(unsigned long j = 0; j < r; ++j)
+        {
+            T GGt_ij = 0;
+            for(unsigned long l = 0; l < r; ++l)
+                GGt_ij += G_data[i+nn*l]*G_data[j+nn*l];
+
+            T dist2 = 0;
+            for(unsigned long k = 0; k < d; ++k)
+            {
+                const T diff = X_data[P[i]+nn*k] - X_data[P[j]+nn*k];
+                dist2 += diff*diff;
+            }
+
+            errK = std::max(errK, std::abs(GGt_ij - exp(-dist2/(sigma*sigma))));
+        }
+
+    BOOST_CHECK_SMALL(errQR, 1e-10);
+    BOOST_CHECK_SMALL(errOrth, 1e-10);
+    BOOST_CHECK_SMALL(errK, 1e-10);
+}
+
+BOOST_AUTO_TEST_CASE(TestParamSelLoocvDualr)
+{
+    // a linear kernel of rank d is recovered exactly by the randomized eigendecomposition,
+    // so the rank-k selection has to give the same guesses and performances as the dense one
+    srand(0);
+
+    const unsigned long n = 200;
+    const unsigned long d = 5;
+    const unsigned long t = 2;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y(i, 0) = X(i, 0) - 2*X(i, 1) + 0.1*static_cast<T>(rand())/RAND_MAX;
+        Y(i, 1) = X(i, 2)*X(i, 3);
+    }
+
+    gurls::GurlsOptionsList opt("loocvdualr", true);
+    opt.getOptValue<gurls::OptString>("hoperf") = "rmse";
+
+    gurls::KernelLinear<T> kernel;
+    opt.addOpt("kernel", kernel.execute(X, Y, opt));
+
+    gurls::ParamSelLoocvDual<T> dense;
+    gurls::GurlsOptionsList* reference = dense.execute(X, Y, opt);
+
+    gurls::ParamSelLoocvDualr<T> randomized;
+    gurls::GurlsOptionsList* result = randomized.execute(X, Y, opt);
+
+    BOOST_CHECK_LT(result->getOptAsNumber("rank"), n);
+
+    const char* fields[] = {"guesses", "perf", "lambdas"};
+    for(int k = 0; k < 3; ++k)
+    {
+        const gurls::gMat2D<T>& res = result->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >(fields[k]);
+        const gurls::gMat2D<T>& ref = reference->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >(fields[k]);
+
+        BOOST_REQUIRE_EQUAL(res.getSize(), ref.getSize());
+
+        for(unsigned long i = 0; i < ref.getSize(); ++i)
+            BOOST_CHECK_LE(std::abs(res.getData()[i] - ref.getData()[i]), 1e-8*std::abs(ref.getData()[i]));
+    }
+
+    delete result;
+    delete reference;
+}
+
+BOOST_AUTO_TEST_CASE(TestRandomSVD)
+{
+    // every range finder and sketch has to recover a rank-k matrix: singular values equal to the dense svd
+    // and U*S*V' = A, both for a tall matrix and for its transpose
+    srand(0);
+
+    const unsigned long m = 300;
+    const unsigned long n = 60;
+    const unsigned long k = 8;
+
+    gurls::gMat2D<T> B(m, k), C(k, n), A(m, n), At(n, m);
+
+    for(unsigned long i = 0; i < B.getSize(); ++i)
+        B.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < C.getSize(); ++i)
+        C.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+
+    gurls::dot(B.getData(), C.getData(), A.getData(), m, k, k, n, m, n, gurls::CblasNoTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+    gurls::transpose(A.getData(), m, n, At.getData());
+
+    T *U_ref, *S_ref, *Vt_ref;
+    int U_rows, U_cols, S_len, Vt_rows, Vt_cols;
+    gurls::svd(A.getData(), U_ref, S_ref, Vt_ref, m, n, U_rows, U_cols, S_len, Vt_rows, Vt_cols, true);
+
+    const gurls::RandomSVDMethod methods[] = {gurls::RandomSVDKrylov, gurls::RandomSVDSubspace};
+    const gurls::RandomSVDProjection projections[] = {gurls::RandomSVDUniform, gurls::RandomSVDSRHT};
+
+    for(int tr = 0; tr < 2; ++tr)
+    {
+        const gurls::gMat2D<T>& M = tr? At: A;
+        const unsigned long rows = M.rows();
+        const unsigned long cols = M.cols();
+
+        for(int i = 0; i < 2; ++i)
+            for(int j = 0; j < 2; ++j)
+            {
+                gurls::gMat2D<T> U(rows, k), V(cols, k), S(k, 1);
+                gurls::random_svd(M.getData(), rows, cols, U.getData(), S.getData(), V.getData(), k, 2, k+2, methods[i], projections[j]);
+
+                for(unsigned long l = 0; l < k; ++l)
+                    BOOST_CHECK_LE(std::abs(S.getData()[l] - S_ref[l]), 1e-8*S_ref[0]);
+
+                T error = 0;
+                for(unsigned long c = 0; c < cols; ++c)
+                    for(unsigned long r = 0; r < rows; ++r)
+                    {
+                        T USVt_rc = 0;
+                        for(unsigned long l = 0; l < k; ++l)
+                            USVt_rc += U(r, l)*S.getData()[l]*V(c, l);
+                        error = std::max(error, std::abs(USVt_rc - M.getData()[r+rows*c]));
+                    }
+
+                BOOST_CHECK_SMALL(error, 1e-8*S_ref[0]);
+            }
+    }
+
+    delete [] U_ref;
+    delete [] S_ref;
+    delete [] Vt_ref;
+}
+
+BOOST_AUTO_TEST_CASE(TestRLSPegasosBatchHogwild)
+{
+    // the lock-free updates only perturb the trajectory: the averaged classifier has to stay close
+    // to the one computed by a single thread, and no update may be lost from W_sum
+    srand(0);
+
+    const unsigned long n = 4000;
+    const unsigned long d = 10;
+    const unsigned long t = 2;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        T s = 0;
+        for(unsigned long k = 0; k < d; ++k)
+            s += (k+1)*X(i, k);
+
+        Y(i, 0) = (s > 0)? 1: -1;
+        Y(i, 1) = -Y(i, 0);
+    }
+
+    gurls::GurlsOptionsList opt("pegasosbatch", true);
+    opt.getOptValue<gurls::OptNumber>("epochs") = 20;
+    opt.getOptValue<gurls::OptNumber>("batchsize") = 16;
+
+    gurls::GurlsOptionsList* paramsel = new gurls::GurlsOptionsList("paramsel");
+    gurls::gMat2D<T>* lambdas = new gurls::gMat2D<T>(1, 1);
+    lambdas->getData()[0] = 1e-3;
+    paramsel->addOpt("lambdas", new gurls::OptMatrix<gurls::gMat2D<T> >(*lambdas));
+    opt.addOpt("paramsel", paramsel);
+
+    gurls::RLSPegasosBatch<T> optimizer;
+
+    // both runs visit the blocks in the same order
+    srand(1);
+    gurls::GurlsOptionsList* serial = optimizer.execute(X, Y, opt);
+
+    opt.getOptValue<gurls::OptNumber>("hogwild") = 1;
+    srand(1);
+    gurls::GurlsOptionsList* hogwild = optimizer.execute(X, Y, opt);
+
+    BOOST_CHECK_EQUAL(hogwild->getOptAsNumber("count"), serial->getOptAsNumber("count"));
+
+    const gurls::gMat2D<T>& W_serial = serial->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("W");
+    const gurls::gMat2D<T>& W_hogwild = hogwild->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("W");
+
+    T diff = 0, norm = 0;
+    for(unsigned long i = 0; i < W_serial.getSize(); ++i)
+    {
+        diff += (W_hogwild.getData()[i] - W_serial.getData()[i])*(W_hogwild.getData()[i] - W_serial.getData()[i]);
+        norm += W_serial.getData()[i]*W_serial.getData()[i];
+    }
+
+    BOOST_CHECK_LE(sqrt(diff), 1e-2*sqrt(norm));
+
+    delete hogwild;
+    delete serial;
+}
+
+BOOST_AUTO_TEST_CASE(TestRowRanks)
+{
+    // ranks and row maxima are compared with a stable sort of every row and with indicesOfMax,
+    // on integer scores so that ties are frequent
+    srand(0);
+
+    const unsigned long rows = 500;
+    const unsigned long cols = 7;
+
+    gurls::gMat2D<T> A(rows, cols);
+    for(unsigned long i = 0; i < A.getSize(); ++i)
+        A.getData()[i] = static_cast<T>(rand()%5);
+
+    std::vector<unsigned long> ind(rows), ranks(rows), maxInd(rows), refMaxInd(rows);
+    std::vector<T> work(rows*cols), maxv(rows);
+
+    for(unsigned long i = 0; i < rows; ++i)
+        ind[i] = rand()%cols;
+
+    gurls::rowRanks(A.getData(), rows, cols, &ind[0], &ranks[0], &work[0]);
+    gurls::rowIndicesOfMax(A.getData(), rows, cols, &maxInd[0], &maxv[0]);
+    gurls::indicesOfMax(A.getData(), rows, cols, &refMaxInd[0], &work[0], 2);
+
+    for(unsigned long i = 0; i < rows; ++i)
+    {
+        // columns sorted by descending score, ties by column
+        std::vector<std::pair<T, unsigned long> > row(cols);
+        for(unsigned long j = 0; j < cols; ++j)
+            row[j] = std::make_pair(-A(i, j), j);
+
+        std::sort(row.begin(), row.end());
+
+        unsigned long position = 0;
+        while(row[position].second != ind[i])
+            ++position;
+
+        BOOST_CHECK_EQUAL(ranks[i], position);
+        BOOST_CHECK_EQUAL(maxInd[i], row[0].second);
+        BOOST_CHECK_EQUAL(maxInd[i], refMaxInd[i]);
+        BOOST_CHECK_EQUAL(maxv[i], -row[0].first);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestCompiledPredictorLoad)
+{
+    // headers whose sizes wrap around 64 bits, or describe more data than the file holds, are rejected
+    typedef gurls::CompiledPredictor<T> Predictor;
+
+    const std::string fileName = (boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("compiledpredictor-%%%%-%%%%")).string();
+
+    gurls::gMat2D<T> W(3, 2);
+    for(unsigned long i = 0; i < W.getSize(); ++i)
+        W.getData()[i] = static_cast<T>(i);
+
+    Predictor linear(Predictor::LINEAR, W);
+    linear.save(fileName);
+
+    Predictor* loaded = Predictor::load(fileName);
+    BOOST_CHECK_EQUAL(loaded->inputs(), 3ul);
+    BOOST_CHECK_EQUAL(loaded->outputs(), 2ul);
+    delete loaded;
+
+    // offsets of t, basisRows and basisCols in the header
+    const std::streamoff t_offset = 32;
+    const std::streamoff basisRows_offset = 40;
+    const std::streamoff basisCols_offset = 48;
+
+    // d*t*sizeof(T) = 3*2^62*8 wraps to 0
+    {
+        std::fstream file(fileName.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        const boost::uint64_t t = 1ull << 62;
+        file.seekp(t_offset);
+        file.write(reinterpret_cast<const char*>(&t), sizeof(t));
+    }
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    // basisRows*basisCols = 2^122 wraps to 0
+    linear.save(fileName);
+    {
+        std::fstream file(fileName.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        const boost::uint64_t size = 1ull << 61;
+        file.seekp(basisRows_offset);
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        file.seekp(basisCols_offset);
+        file.write(reinterpret_cast<const char*>(&size), sizeof(size));
+    }
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    // truncated parameters
+    linear.save(fileName);
+    boost::filesystem::resize_file(fileName, boost::filesystem::file_size(fileName) - sizeof(T));
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_CASE(TestRecursiveRLSWindow)
+{
+    // XtX, Xty and Cinv of the sliding window and of the forgetting factor, against their direct computation
+    srand(0);
+
+    const unsigned long n0 = 100;
+    const unsigned long nu = 150;
+    const unsigned long d = 4;
+    const unsigned long windowSize = 50;
+    const T beta = 0.97;
+
+    gurls::gMat2D<T> X(n0+nu, d);
+    gurls::gMat2D<T> y(n0+nu, 1);
+    for(unsigned long i = 0; i < (n0+nu)*d; ++i)
+        X.getData()[i] = rand()/(T)RAND_MAX - 0.5;
+    for(unsigned long i = 0; i < n0+nu; ++i)
+        y.getData()[i] = X.getData()[i] - 2*X.getData()[i+(n0+nu)] + 0.1*(rand()/(T)RAND_MAX - 0.5);
+
+    gurls::gMat2D<T> X0(n0, d);
+    gurls::gMat2D<T> y0(n0, 1);
+    for(unsigned long j = 0; j < d; ++j)
+        gurls::copy(X0.getData()+j*n0, X.getData()+j*(n0+nu), n0);
+    gurls::copy(y0.getData(), y.getData(), n0);
+
+    {
+        gurls::RecursiveRLSWrapper<T> wrapper("recursiverls");
+        wrapper.setForgettingFactor(beta);
+        BOOST_CHECK_THROW(wrapper.setWindowSize(windowSize), gurls::gException);
+        wrapper.setForgettingFactor(1);
+        wrapper.setWindowSize(windowSize);
+        BOOST_CHECK_THROW(wrapper.setForgettingFactor(beta), gurls::gException);
+        wrapper.setForgettingFactor(1);
+    }
+
+    for(int mode = 0; mode < 2; ++mode)
+    {
+        gurls::RecursiveRLSWrapper<T> wrapper("recursiverls");
+        if(mode == 0)
+            wrapper.setWindowSize(windowSize);
+        else
+            wrapper.setForgettingFactor(beta);
+
+        wrapper.train(X0, y0);
+
+        gurls::gVec<T> x(d);
+        gurls::gVec<T> yi(1);
+        for(unsigned long i = n0; i < n0+nu; ++i)
+        {
+            gurls::copy(x.getData(), X.getData()+i, d, 1, n0+nu);
+            yi[0] = y.getData()[i];
+            wrapper.update(x, yi);
+        }
+
+        // weights of the samples: the last windowSize ones, or beta^age
+        std::vector<T> weights(n0+nu, 0);
+        T regWeight = 1;
+        for(unsigned long i = 0; i < n0+nu; ++i)
+        {
+            if(mode == 0)
+                weights[i] = (i >= n0+nu-windowSize)? 1 : 0;
+            else
+                weights[i] = std::pow(beta, (T)((i < n0)? nu : n0+nu-1-i));
+        }
+        if(mode == 1)
+            regWeight = std::pow(beta, (T)nu);
+
+        std::vector<T> XtX(d*d, 0);
+        std::vector<T> Xty(d, 0);
+        for(unsigned long i = 0; i < n0+nu; ++i)
+            for(unsigned long j = 0; j < d; ++j)
+            {
+                const T xj = X.getData()[i+j*(n0+nu)];
+                for(unsigned long k = 0; k < d; ++k)
+                    XtX[j+k*d] += weights[i]*xj*X.getData()[i+k*(n0+nu)];
+                Xty[j] += weights[i]*xj*y.getData()[i];
+            }
+
+        const gurls::GurlsOptionsList& opt = wrapper.getOpt();
+        const T* kXtX = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.XtX").getData();
+        const T* kXty = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.Xty").getData();
+        const T* Cinv = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.Cinv").getData();
+        const T* W = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.W").getData();
+        const T lambda = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("paramsel.lambdas").getData()[0];
+
+        for(unsigned long j = 0; j < d*d; ++j)
+            BOOST_CHECK_SMALL(kXtX[j] - XtX[j], 1e-10);
+        for(unsigned long j = 0; j < d; ++j)
+            BOOST_CHECK_SMALL(kXty[j] - Xty[j], 1e-10);
+
+        // Cinv*(XtX + n0*lambda*regWeight*eye(d)) = eye(d), W = Cinv*Xty
+        for(unsigned long j = 0; j < d; ++j)
+            XtX[j+j*d] += n0*lambda*regWeight;
+
+        for(unsigned long i = 0; i < d; ++i)
+        {
+            T w = 0;
+            for(unsigned long k = 0; k < d; ++k)
+                w += Cinv[i+k*d]*Xty[k];
+            BOOST_CHECK_SMALL(W[i] - w, 1e-8);
+
+            for(unsigned long j = 0; j < d; ++j)
+            {
+                T e = 0;
+                for(unsigned long k = 0; k < d; ++k)
+                    e += Cinv[i+k*d]*XtX[k+j*d];
+                BOOST_CHECK_SMALL(e - ((i == j)? 1 : 0), 1e-8);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestBinaryReader)
+{
+    // blocks of rows read from a saved matrix, into a buffer with a larger leading dimension
+    const std::string fileName = (boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("binaryreader-%%%%-%%%%")).string();
+
+    const unsigned long n = 50;
+    const unsigned long d = 3;
+    const unsigned long ld = 10;
+    const unsigned long blockRows = 7;
+
+    gurls::gMat2D<T> M(n, d);
+    for(unsigned long i = 0; i < M.getSize(); ++i)
+        M.getData()[i] = static_cast<T>(i);
+
+    M.save(fileName);
+
+    {
+        gurls::BinaryReader<T> reader(fileName);
+        BOOST_CHECK_EQUAL(reader.cols(), d);
+
+        std::vector<T> block(ld*d);
+        unsigned long next = 0;
+        unsigned long rows;
+
+        while((rows = reader.read(&block[0], ld, blockRows)) > 0)
+        {
+            BOOST_REQUIRE_EQUAL(rows, std::min(blockRows, n-next));
+
+            for(unsigned long j = 0; j < d; ++j)
+                for(unsigned long i = 0; i < rows; ++i)
+                    BOOST_CHECK_EQUAL(block[i+j*ld], M.getData()[next+i+j*n]);
+
+            next += rows;
+        }
+
+        BOOST_CHECK_EQUAL(next, n);
+    }
+
+    // the last column is incomplete
+    boost::filesystem::resize_file(fileName, boost::filesystem::file_size(fileName) - sizeof(T));
+    {
+        gurls::BinaryReader<T> reader(fileName);
+
+        std::vector<T> block(n*d);
+        BOOST_CHECK_THROW(reader.read(&block[0], n, n), gurls::gException);
+    }
+
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_CASE(TestPrimalAccumulator)
+{
+    // statistics accumulated on shifted blocks, against X'*X and X'*y computed directly
+    srand(0);
+
+    const unsigned long n = 1003;
+    const unsigned long d = 4;
+    const unsigned long t = 2;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+
+    // large means make the conversion back from the shifted statistics significant
+    for(unsigned long j = 0; j < d; ++j)
+        for(unsigned long i = 0; i < n; ++i)
+            X.getData()[i+j*n] = 100.0*(j+1) + static_cast<T>(rand())/RAND_MAX;
+
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y.getData()[i] = X.getData()[i] - X.getData()[i+n];
+        Y.getData()[i+n] = 50 + static_cast<T>(rand())/RAND_MAX;
+    }
+
+    gurls::MatrixReader<T> readerX(X), readerY(Y);
+
+    gurls::PrimalAccumulator<T> accumulator(64);
+    accumulator.setHoldout(0.2);
+    accumulator.accumulate(readerX, readerY);
+
+    BOOST_REQUIRE_EQUAL(accumulator.samples(), n);
+
+    std::vector<T> meanX(d, 0), meanY(t, 0), stdX(d, 0), stdY(t, 0);
+    for(unsigned long j = 0; j < d; ++j)
+    {
+        for(unsigned long i = 0; i < n; ++i)
+            meanX[j] += X.getData()[i+j*n]/n;
+        for(unsigned long i = 0; i < n; ++i)
+            stdX[j] += std::pow(X.getData()[i+j*n] - meanX[j], 2)/(n-1);
+        stdX[j] = std::sqrt(stdX[j]) + std::numeric_limits<T>::epsilon();
+    }
+    for(unsigned long j = 0; j < t; ++j)
+    {
+        for(unsigned long i = 0; i < n; ++i)
+            meanY[j] += Y.getData()[i+j*n]/n;
+        for(unsigned long i = 0; i < n; ++i)
+            stdY[j] += std::pow(Y.getData()[i+j*n] - meanY[j], 2)/(n-1);
+        stdY[j] = std::sqrt(stdY[j]) + std::numeric_limits<T>::epsilon();
+    }
+
+    gurls::GurlsOptionsList* norm = accumulator.norm();
+    for(unsigned long j = 0; j < d; ++j)
+    {
+        BOOST_CHECK_SMALL(norm->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("meanX").getData()[j] - meanX[j], 1e-10);
+        BOOST_CHECK_SMALL(norm->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("stdX").getData()[j] - stdX[j], 1e-10);
+    }
+    for(unsigned long j = 0; j < t; ++j)
+    {
+        BOOST_CHECK_SMALL(norm->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("meanY").getData()[j] - meanY[j], 1e-10);
+        BOOST_CHECK_SMALL(norm->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("stdY").getData()[j] - stdY[j], 1e-10);
+    }
+    delete norm;
+
+    for(int zscore = 0; zscore < 2; ++zscore)
+    {
+        // Xs = X, or (X-1*meanX)./(1*stdX)
+        gurls::gMat2D<T> Xs(n, d), Ys(n, t);
+        for(unsigned long j = 0; j < d; ++j)
+            for(unsigned long i = 0; i < n; ++i)
+                Xs.getData()[i+j*n] = zscore? (X.getData()[i+j*n] - meanX[j])/stdX[j] : X.getData()[i+j*n];
+        for(unsigned long j = 0; j < t; ++j)
+            for(unsigned long i = 0; i < n; ++i)
+                Ys.getData()[i+j*n] = zscore? (Y.getData()[i+j*n] - meanY[j])/stdY[j] : Y.getData()[i+j*n];
+
+        gurls::gMat2D<T> XtX(d, d), Xty(d, t);
+        gurls::dot(Xs.getData(), Xs.getData(), XtX.getData(), n, d, n, d, d, d, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+        gurls::dot(Xs.getData(), Ys.getData(), Xty.getData(), n, d, n, t, d, t, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+
+        gurls::GurlsOptionsList* kernel = accumulator.kernel(zscore != 0);
+
+        const gurls::gMat2D<T>& K = kernel->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("XtX");
+        const gurls::gMat2D<T>& B = kernel->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("Xty");
+        const gurls::gMat2D<T>& Xva = kernel->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("Xva");
+        const gurls::gMat2D<T>& yva = kernel->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("yva");
+
+        for(unsigned long i = 0; i < d*d; ++i)
+            BOOST_CHECK_LE(std::abs(K.getData()[i] - XtX.getData()[i]), 1e-10*std::abs(XtX.getData()[i]) + 1e-9);
+        for(unsigned long i = 0; i < d*t; ++i)
+            BOOST_CHECK_LE(std::abs(B.getData()[i] - Xty.getData()[i]), 1e-10*std::abs(Xty.getData()[i]) + 1e-9);
+
+        // one sample every 5 is held out, in reading order
+        const unsigned long nva = n/5;
+        BOOST_REQUIRE_EQUAL(Xva.rows(), nva);
+        BOOST_REQUIRE_EQUAL(yva.rows(), nva);
+
+        for(unsigned long k = 0; k < nva; ++k)
+        {
+            for(unsigned long j = 0; j < d; ++j)
+                BOOST_CHECK_SMALL(Xva.getData()[k+j*nva] - Xs.getData()[5*k+4+j*n], 1e-10);
+            for(unsigned long j = 0; j < t; ++j)
+                BOOST_CHECK_SMALL(yva.getData()[k+j*nva] - Ys.getData()[5*k+4+j*n], 1e-10);
+        }
+
+        delete kernel;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(TestParamSelHoPrimalValidationSplit)
+{
+    // with precomputed statistics and nTot the split may list only the validation indices:
+    // the selection must be the same as with the full split, and as without statistics
+    srand(0);
+
+    const unsigned long n = 400;
+    const unsigned long nva = 80;
+    const unsigned long d = 6;
+    const unsigned long t = 2;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y.getData()[i] = X.getData()[i] - 2*X.getData()[i+n] + 0.5*static_cast<T>(rand())/RAND_MAX;
+        Y.getData()[i+n] = X.getData()[i+2*n] + 0.5*static_cast<T>(rand())/RAND_MAX;
+    }
+
+    // validation samples are the rows 5k+2
+    gurls::gMat2D<unsigned long>* indices = new gurls::gMat2D<unsigned long>(1, n);
+    gurls::gMat2D<unsigned long>* vaIndices = new gurls::gMat2D<unsigned long>(1, nva);
+    gurls::gMat2D<T> Xva(nva, d), yva(nva, t);
+
+    unsigned long tr = 0;
+    for(unsigned long i = 0; i < n; ++i)
+        if(i % 5 != 2)
+            indices->getData()[tr++] = i;
+
+    for(unsigned long k = 0; k < nva; ++k)
+    {
+        indices->getData()[tr+k] = 5*k+2;
+        vaIndices->getData()[k] = k;
+
+        for(unsigned long j = 0; j < d; ++j)
+            Xva.getData()[k+j*nva] = X.getData()[5*k+2+j*n];
+        for(unsigned long j = 0; j < t; ++j)
+            yva.getData()[k+j*nva] = Y.getData()[5*k+2+j*n];
+    }
+
+    gurls::gMat2D<unsigned long>* lasts = new gurls::gMat2D<unsigned long>(1, 1);
+    lasts->getData()[0] = n-nva;
+
+    gurls::GurlsOptionsList* split = new gurls::GurlsOptionsList("split");
+    split->addOpt("indices", new gurls::OptMatrix<gurls::gMat2D<unsigned long> >(*indices));
+    split->addOpt("lasts", new gurls::OptMatrix<gurls::gMat2D<unsigned long> >(*lasts));
+
+    gurls::GurlsOptionsList* vaSplit = new gurls::GurlsOptionsList("split");
+    vaSplit->addOpt("indices", new gurls::OptMatrix<gurls::gMat2D<unsigned long> >(*vaIndices));
+    vaSplit->addOpt("lasts", new gurls::OptMatrix<gurls::gMat2D<unsigned long> >(*(new gurls::gMat2D<unsigned long>(*lasts))));
+
+    gurls::gMat2D<T>* XtX = new gurls::gMat2D<T>(d, d);
+    gurls::gMat2D<T>* Xty = new gurls::gMat2D<T>(d, t);
+    gurls::dot(X.getData(), X.getData(), XtX->getData(), n, d, n, d, d, d, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+    gurls::dot(X.getData(), Y.getData(), Xty->getData(), n, d, n, t, d, t, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+
+    gurls::GurlsOptionsList* kernel = new gurls::GurlsOptionsList("kernel");
+    kernel->addOpt("XtX", new gurls::OptMatrix<gurls::gMat2D<T> >(*XtX));
+    kernel->addOpt("Xty", new gurls::OptMatrix<gurls::gMat2D<T> >(*Xty));
+
+    gurls::GurlsOptionsList* vaKernel = new gurls::GurlsOptionsList("kernel");
+    vaKernel->addOpt("XtX", new gurls::OptMatrix<gurls::gMat2D<T> >(*(new gurls::gMat2D<T>(*XtX))));
+    vaKernel->addOpt("Xty", new gurls::OptMatrix<gurls::gMat2D<T> >(*(new gurls::gMat2D<T>(*Xty))));
+
+    gurls::ParamSelHoPrimal<T> paramsel;
+
+    gurls::GurlsOptionsList dense("hoprimal", true);
+    dense.getOptValue<gurls::OptNumber>("nholdouts") = 1.0;
+    dense.addOpt("split", split);
+    gurls::GurlsOptionsList* reference = paramsel.execute(X, Y, dense);
+
+    dense.addOpt("kernel", kernel);
+    gurls::GurlsOptionsList* full = paramsel.execute(X, Y, dense);
+
+    gurls::GurlsOptionsList stats("hoprimal", true);
+    stats.getOptValue<gurls::OptNumber>("nholdouts") = 1.0;
+    stats.addOpt("split", vaSplit);
+    stats.addOpt("kernel", vaKernel);
+    stats.addOpt("nTot", new gurls::OptNumber(n));
+    gurls::GurlsOptionsList* result = paramsel.execute(Xva, yva, stats);
+
+    const char* fields[] = {"guesses", "perf", "lambdas"};
+    for(int k = 0; k < 3; ++k)
+    {
+        const gurls::gMat2D<T>& ref = reference->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >(fields[k]);
+        const gurls::gMat2D<T>& ful = full->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >(fields[k]);
+        const gurls::gMat2D<T>& res = result->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >(fields[k]);
+
+        BOOST_REQUIRE_EQUAL(ful.getSize(), ref.getSize());
+        BOOST_REQUIRE_EQUAL(res.getSize(), ref.getSize());
+
+        for(unsigned long i = 0; i < ref.getSize(); ++i)
+        {
+            BOOST_CHECK_EQUAL(res.getData()[i], ful.getData()[i]);
+            BOOST_CHECK_LE(std::abs(ful.getData()[i] - ref.getData()[i]), 1e-8*std::abs(ref.getData()[i]));
+        }
+    }
+
+    delete result;
+    delete full;
+    delete reference;
+}
+
+namespace
+{
+
+// reads a matrix from memory in blocks of at most 13 rows
+unsigned long readRows(T* block, unsigned long ld, unsigned long maxRows, void* userData)
+{
+    return static_cast<gurls::MatrixReader<T>*>(userData)->read(block, ld, std::min(maxRows, 13ul));
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(TestRecursiveRLSDataReader)
+{
+    // training from readers gives the same statistics as training from matrices,
+    // and the estimator solves the primal system with the selected lambda
+    srand(0);
+
+    const unsigned long n = 500;
+    const unsigned long d = 5;
+    const unsigned long t = 2;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 3 + 2*static_cast<T>(rand())/RAND_MAX;
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y.getData()[i] = X.getData()[i] - 2*X.getData()[i+n] + 0.1*static_cast<T>(rand())/RAND_MAX;
+        Y.getData()[i+n] = X.getData()[i+2*n] + 0.1*static_cast<T>(rand())/RAND_MAX;
+    }
+
+    gurls::RecursiveRLSWrapper<T> inMemory("recursiverls");
+    inMemory.train(X, Y);
+
+    gurls::MatrixReader<T> matrixX(X), matrixY(Y);
+    gurls::CallbackReader<T> readerX(d, readRows, &matrixX), readerY(t, readRows, &matrixY);
+
+    gurls::RecursiveRLSWrapper<T> streamed("recursiverls");
+    streamed.train(readerX, readerY);
+
+    const gurls::GurlsOptionsList& ref = inMemory.getOpt();
+    const gurls::GurlsOptionsList& opt = streamed.getOpt();
+
+    const gurls::gMat2D<T>& XtX_ref = ref.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.XtX");
+    const gurls::gMat2D<T>& Xty_ref = ref.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.Xty");
+
+    const T* XtX = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.XtX").getData();
+    const T* Xty = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.Xty").getData();
+
+    for(unsigned long i = 0; i < d*d; ++i)
+        BOOST_CHECK_LE(std::abs(XtX[i] - XtX_ref.getData()[i]), 1e-10*std::abs(XtX_ref.getData()[i]));
+    for(unsigned long i = 0; i < d*t; ++i)
+        BOOST_CHECK_LE(std::abs(Xty[i] - Xty_ref.getData()[i]), 1e-10*std::abs(Xty_ref.getData()[i]));
+
+    // one sample every 5 is held out
+    const gurls::gMat2D<T>& Xva = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("kernel.Xva");
+    BOOST_REQUIRE_EQUAL(Xva.rows(), n/5);
+    for(unsigned long k = 0; k < n/5; ++k)
+        BOOST_CHECK_EQUAL(Xva.getData()[k], X.getData()[5*k+4]);
+
+    // W = (XtX + n*lambda*eye(d)) \ Xty
+    const gurls::gMat2D<T>& lambdas = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("paramsel.lambdas");
+    const T lambda = opt.getOptAs<gurls::OptFunction>("singlelambda")->getValue(lambdas.getData(), lambdas.getSize());
+
+    const T* W = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.W").getData();
+
+    for(unsigned long j = 0; j < t; ++j)
+        for(unsigned long i = 0; i < d; ++i)
+        {
+            T r = n*lambda*W[i+j*d] - Xty[i+j*d];
+            for(unsigned long k = 0; k < d; ++k)
+                r += XtX[i+k*d]*W[k+j*d];
+
+            BOOST_CHECK_LE(std::abs(r), 1e-8*std::abs(Xty[i+j*d]));
+        }
+
+    // both estimators predict the data alike
+    gurls::gMat2D<T>* pred = streamed.eval(X);
+    gurls::gMat2D<T>* pred_ref = inMemory.eval(X);
+
+    T err = 0, err_ref = 0;
+    for(unsigned long i = 0; i < n*t; ++i)
+    {
+        err += std::pow(pred->getData()[i] - Y.getData()[i], 2);
+        err_ref += std::pow(pred_ref->getData()[i] - Y.getData()[i], 2);
+    }
+    BOOST_CHECK_LE(err, 1.1*err_ref);
+
+    delete pred;
+    delete pred_ref;
+}
+
+BOOST_AUTO_TEST_CASE(TestRPFactorizeLargeReal)
+{
+    // Gram matrices of the random features accumulated per block and per thread, against the
+    // dense G = rp_apply_real(X,W) and between a serial and a multi-thread run
+    srand(0);
+
+    const unsigned long n = 1000;
+    const unsigned long d = 6;
+    const unsigned long t = 2;
+    const unsigned long D = 40;
+    const unsigned long D2 = 2*D;
+    const unsigned long psize = 37;
+
+    gurls::gMat2D<T> X(n, d), y(n, t);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < y.getSize(); ++i)
+        y.getData()[i] = static_cast<T>(rand())/RAND_MAX;
+
+    std::vector<T> XtX(D2*D2), Xty(D2*t);
+    gurls::gMat2D<T>* W = gurls::rp_factorize_large_real(X, y, D, psize, &XtX[0], &Xty[0]);
+
+    gurls::gMat2D<T>* G = gurls::rp_apply_real(X, *W);
+
+    gurls::gMat2D<T> GG(D2, D2), Gy(D2, t);
+    gurls::dot(G->getData(), G->getData(), GG.getData(), n, D2, n, D2, D2, D2, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+    gurls::dot(G->getData(), y.getData(), Gy.getData(), n, D2, n, t, D2, t, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+
+    for(unsigned long i = 0; i < D2*D2; ++i)
+        BOOST_CHECK_SMALL(XtX[i] - GG.getData()[i], 1e-9);
+    for(unsigned long i = 0; i < D2*t; ++i)
+        BOOST_CHECK_SMALL(Xty[i] - Gy.getData()[i], 1e-9);
+
+    delete G;
+    delete W;
+
+#ifdef _OPENMP
+    const int threads = omp_get_max_threads();
+
+    std::vector<T> XtX_s(D2*D2), Xty_s(D2*t);
+    omp_set_num_threads(1);
+    delete gurls::rp_factorize_large_real(X, y, D, psize, &XtX_s[0], &Xty_s[0]);
+
+    std::vector<T> XtX_p(D2*D2), Xty_p(D2*t);
+    omp_set_num_threads(4);
+    delete gurls::rp_factorize_large_real(X, y, D, psize, &XtX_p[0], &Xty_p[0]);
+
+    omp_set_num_threads(threads);
+
+    for(unsigned long i = 0; i < D2*D2; ++i)
+        BOOST_CHECK_SMALL(XtX_p[i] - XtX_s[i], 1e-9);
+    for(unsigned long i = 0; i < D2*t; ++i)
+        BOOST_CHECK_SMALL(Xty_p[i] - Xty_s[i], 1e-9);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(TestSORFProjections)
+{
+    // the structured projections applied in place, against the product with their dense matrix
+    srand(0);
+
+    const unsigned long n = 30;
+    const unsigned long ld = 37;
+    const unsigned long d = 10;
+    const unsigned long D = 40;
+    const unsigned long seed = 5;
+
+    gurls::gMat2D<T> X(ld, d);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+
+    gurls::gMat2D<T>* W = gurls::rp_sorf_projections<T>(d, D, seed);
+
+    // V = X(1:n,:)*W;
+    gurls::gMat2D<T> V(n, D);
+    gurls::gemm(gurls::CblasNoTrans, gurls::CblasNoTrans, n, D, d, (T)1.0, X.getData(), ld, W->getData(), d, (T)0.0, V.getData(), n);
+
+    T* signs = gurls::rp_sorf_signs<T>(d, D, seed);
+    std::vector<T> work(16);
+    std::vector<T> V_sorf(ld*D, 0);
+    gurls::rp_sorf_project(X.getData(), ld, n, d, D, signs, &V_sorf[0], ld, &work[0]);
+
+    for(unsigned long j = 0; j < D; ++j)
+        for(unsigned long i = 0; i < n; ++i)
+            BOOST_CHECK_SMALL(V_sorf[i+j*ld] - V.getData()[i+j*n], 1e-10);
+
+    delete [] signs;
+    delete W;
+
+    // the columns of a full block are orthogonal, with squared norm 2p: W'*W = 2p*eye(p)
+    const unsigned long p = 16;
+    W = gurls::rp_sorf_projections<T>(p, D, seed);
+
+    for(unsigned long a = 0; a < p; ++a)
+        for(unsigned long b = 0; b < p; ++b)
+            BOOST_CHECK_SMALL(gurls::dot(p, W->getData()+a*p, 1, W->getData()+b*p, 1) - ((a == b)? 2.0*p : 0.0), 1e-10);
+
+    delete W;
+}
+
+BOOST_AUTO_TEST_CASE(TestRLSRandFeatsSORF)
+{
+    // "sorf" random features keep only the seed and solve the same system as the dense features
+    srand(0);
+
+    const unsigned long n = 300;
+    const unsigned long d = 5;
+    const unsigned long t = 2;
+    const unsigned long D = 20;
+    const unsigned long D2 = 2*D;
+    const unsigned long seed = 3;
+    const T lambda = 1e-4;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y.getData()[i] = sin(2*X.getData()[i]) + X.getData()[i+n];
+        Y.getData()[i+n] = cos(3*X.getData()[i+2*n]);
+    }
+
+    gurls::GurlsOptionsList opt("randfeats", true);
+    opt.getOptValue<gurls::OptString>("randfeats.type") = "sorf";
+    opt.getOptValue<gurls::OptNumber>("randfeats.D") = D;
+    opt.getOptValue<gurls::OptNumber>("randfeats.seed") = seed;
+    opt.getOptValue<gurls::OptNumber>("randfeats.samplesize") = 64;
+
+    gurls::GurlsOptionsList* paramsel = new gurls::GurlsOptionsList("paramsel");
+    gurls::gMat2D<T>* lambdas = new gurls::gMat2D<T>(1, 1);
+    lambdas->getData()[0] = lambda;
+    paramsel->addOpt("lambdas", new gurls::OptMatrix<gurls::gMat2D<T> >(*lambdas));
+    opt.removeOpt("paramsel");
+    opt.addOpt("paramsel", paramsel);
+
+    gurls::RLSRandFeats<T> task;
+    opt.addOpt("optimizer", task.execute(X, Y, opt));
+
+    BOOST_CHECK(!opt.hasOpt("optimizer.proj"));
+    BOOST_REQUIRE(opt.hasOpt("optimizer.seed"));
+    BOOST_CHECK_EQUAL(opt.getOptAsNumber("optimizer.seed"), seed);
+
+    // G = rp_apply_real(X,W) with the dense structured projections
+    gurls::gMat2D<T>* W = gurls::rp_sorf_projections<T>(d, D, seed);
+    gurls::gMat2D<T>* G = gurls::rp_apply_real(X, *W);
+
+    std::vector<T> GG(D2*D2), Gy(D2*t);
+    gurls::dot(G->getData(), G->getData(), &GG[0], n, D2, n, D2, D2, D2, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+    gurls::dot(G->getData(), Y.getData(), &Gy[0], n, D2, n, t, D2, t, gurls::CblasTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+
+    gurls::gMat2D<T>* W_ref = gurls::rls_primal_driver(&GG[0], &Gy[0], D2, D2, t, lambda);
+    const gurls::gMat2D<T>& W_rls = opt.getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("optimizer.W");
+
+    BOOST_REQUIRE_EQUAL(W_rls.getSize(), W_ref->getSize());
+    for(unsigned long i = 0; i < W_ref->getSize(); ++i)
+        BOOST_CHECK_LE(std::abs(W_rls.getData()[i] - W_ref->getData()[i]), 1e-6*(1 + std::abs(W_ref->getData()[i])));
+
+    // predictions regenerate the projections from the seed
+    gurls::PredRandFeats<T> pred;
+    gurls::GurlsOptionsList* result = pred.execute(X, Y, opt);
+    const gurls::gMat2D<T>& scores = result->getOptValue<gurls::OptMatrix<gurls::gMat2D<T> > >("scores");
+
+    gurls::gMat2D<T> scores_ref(n, t);
+    gurls::dot(G->getData(), W_rls.getData(), scores_ref.getData(), n, D2, D2, t, n, t, gurls::CblasNoTrans, gurls::CblasNoTrans, gurls::CblasColMajor);
+
+    for(unsigned long i = 0; i < n*t; ++i)
+        BOOST_CHECK_SMALL(scores.getData()[i] - scores_ref.getData()[i], 1e-8);
+
+    delete result;
+    delete W_ref;
+    delete G;
+    delete W;
+}
+
+BOOST_AUTO_TEST_CASE(TestCompiledPredictorSORF)
+{
+    // compiled SORF models predict as the wrapper, also once saved and loaded,
+    // and files whose signs do not match the projections are rejected
+    typedef gurls::CompiledPredictor<T> Predictor;
+    srand(0);
+
+    const unsigned long n = 200;
+    const unsigned long nte = 50;
+    const unsigned long d = 7;
+    const unsigned long t = 2;
+    const unsigned long D = 24;
+
+    gurls::gMat2D<T> X(n, d), Y(n, t), Xte(nte, d);
+    for(unsigned long i = 0; i < X.getSize(); ++i)
+        X.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < Xte.getSize(); ++i)
+        Xte.getData()[i] = 2*static_cast<T>(rand())/RAND_MAX - 1;
+    for(unsigned long i = 0; i < n; ++i)
+    {
+        Y.getData()[i] = sin(2*X.getData()[i]);
+        Y.getData()[i+n] = X.getData()[i+n]*X.getData()[i+2*n];
+    }
+
+    gurls::RandomFeaturesWrapper<T> wrapper("randfeats");
+    wrapper.setNRandFeats(D);
+    wrapper.setRandFeatsType("sorf");
+    wrapper.setRandFeatsSeed(11);
+    wrapper.setProblemType(gurls::GurlsWrapper<T>::REGRESSION);
+    wrapper.train(X, Y);
+
+    gurls::gMat2D<T>* pred = wrapper.eval(Xte);
+
+    Predictor* compiled = wrapper.compile();
+    BOOST_CHECK(compiled->modelType() == Predictor::SORF);
+    BOOST_CHECK_EQUAL(compiled->inputs(), d);
+    BOOST_CHECK_EQUAL(compiled->outputs(), t);
+
+    const std::string fileName = (boost::filesystem::temp_directory_path()/boost::filesystem::unique_path("compiledpredictor-%%%%-%%%%")).string();
+    compiled->save(fileName);
+
+    Predictor* loaded = Predictor::load(fileName);
+
+    Predictor* predictors[] = {compiled, loaded};
+    for(int k = 0; k < 2; ++k)
+    {
+        std::vector<T> work(predictors[k]->workSize(nte));
+        gurls::gMat2D<T> out(nte, t);
+        predictors[k]->predictBatch(Xte.getData(), nte, out.getData(), &work[0]);
+
+        for(unsigned long i = 0; i < nte*t; ++i)
+            BOOST_CHECK_SMALL(out.getData()[i] - pred->getData()[i], 1e-8);
+
+        // single point, a row of Xte
+        std::vector<T> x(d), y(t);
+        gurls::copy(&x[0], Xte.getData()+3, d, 1, nte);
+        predictors[k]->predict(&x[0], &y[0], &work[0]);
+
+        for(unsigned long j = 0; j < t; ++j)
+            BOOST_CHECK_SMALL(y[j] - pred->getData()[3+j*nte], 1e-8);
+    }
+
+    delete loaded;
+
+    // offsets of d and basisRows in the header
+    const std::streamoff d_offset = 24;
+    const std::streamoff basisRows_offset = 40;
+
+    // d = 9 needs blocks of 16 projections, the signs are for blocks of 8
+    {
+        std::fstream file(fileName.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        const boost::uint64_t d9 = 9;
+        file.seekp(d_offset);
+        file.write(reinterpret_cast<const char*>(&d9), sizeof(d9));
+    }
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    // fewer signs than the projections need, still within the file
+    compiled->save(fileName);
+    {
+        std::fstream file(fileName.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        const boost::uint64_t signs = 3;
+        file.seekp(basisRows_offset);
+        file.write(reinterpret_cast<const char*>(&signs), sizeof(signs));
+    }
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    // d = 0
+    compiled->save(fileName);
+    {
+        std::fstream file(fileName.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+        const boost::uint64_t d0 = 0;
+        file.seekp(d_offset);
+        file.write(reinterpret_cast<const char*>(&d0), sizeof(d0));
+    }
+    BOOST_CHECK_THROW(Predictor::load(fileName), gurls::gException);
+
+    boost::filesystem::remove(fileName);
+
+    delete compiled;
+    delete pred;
+}
+
 //BOOST_AUTO_TEST_SUITE_END()